@@ -16,13 +16,25 @@ extern "C" {
 #include <spritetools/spritetools_input.h>
 #include <spritetools/spritetools_textcolors.h>
 #include <spritetools/spritetools_spritesheet.h>
+#include <spritetools/spritetools_residency.h>
+#include <spritetools/spritetools_archive.h>
+#include <spritetools/spritetools_loader.h>
 #include <spritetools/spritetools_render.h>
 #include <spritetools/spritetools_splash.h>
 #include <spritetools/spritetools_animation.h>
 #include <spritetools/spritetools_time.h>
 #include <spritetools/spritetools_entity.h>
+#include <spritetools/spritetools_component.h>
+#include <spritetools/spritetools_animfile.h>
+#include <spritetools/spritetools_statemachine.h>
+#include <spritetools/spritetools_tween.h>
+#include <spritetools/spritetools_composite.h>
+#include <spritetools/spritetools_hierarchy.h>
 #include <spritetools/spritetools_camera.h>
 #include <spritetools/spritetools_collision.h>
+#include <spritetools/spritetools_loop.h>
+#include <spritetools/spritetools_governor.h>
+#include <spritetools/spritetools_viewport.h>
 
 /* Inits all modules and sets up */
 /* Returns 1 on success, 0 on failure */
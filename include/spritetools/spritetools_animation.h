@@ -26,8 +26,33 @@ typedef struct {
   u32 height;
   s32 xoff;
   s32 yoff;
+  float u0; /* Normalized texture coordinates of the frame */
+  float v0; /*   (cached from the spritesheet's power of two size) */
+  float u1;
+  float v1;
+  u32 drawWidth; /* Width rounded up to an even number for rendering */
+  u32 drawHeight; /* Height rounded up to an even number for rendering */
+  s32 trimX; /* How far trimming moved the center of the frame */
+  s32 trimY; /*   (in unscaled, unrotated pixels) */
+  u32 sourceWidth; /* Dimensions before trimming */
+  u32 sourceHeight;
 } st_frame;
 
+/* Event on a frame of an animation, like a footstep or a hit */
+typedef struct {
+  u16 frame;
+  u16 id; /* Chosen by the game */
+} st_animationevent;
+
+/* The frames belong to something else, like an array of sliced frames */
+#define ST_ANIMATION_SHARED_FRAMES 0x1
+
+/* The events belong to something else and can't be changed */
+#define ST_ANIMATION_SHARED_EVENTS 0x2
+
+/* The list of frame pointers wasn't allocated on its own */
+#define ST_ANIMATION_SHARED_LIST 0x4
+
 /* Animation of frames */
 typedef struct {
   s16 fpf; /* Number of frames to wait between each frame of animation */
@@ -36,8 +61,23 @@ typedef struct {
   u16 length; /* Number of frames in the animation */
   st_frame **frames;
   u16 currentFrame;
+  st_animationevent *events; /* Sorted by frame */
+  u16 eventCount;
+  u16 eventCursor; /* First event after the last frame events fired on */
+  void *eventData; /* Passed along with fired events */
+                   /*   (ST_EntityAddAnimation sets it to the entity) */
+  u8 shared; /* ST_ANIMATION_SHARED_* flags for what belongs to */
+             /*   something else and isn't freed with the animation */
 } st_animation;
 
+/* Event that fired, as handed out by ST_AnimationDrainEvents */
+typedef struct {
+  st_animation *animation;
+  void *data; /* The animation's eventData */
+  u16 frame;
+  u16 id;
+} st_firedevent;
+
 /***************************\
 |*     Frame Functions     *|
 \***************************/
@@ -62,6 +102,41 @@ st_frame *ST_AnimationCreateFrameOffset(st_spritesheet *spritesheet,
 /* Takes a pointer to a frame */
 void ST_AnimationFreeFrame(st_frame *frame);
 
+/* Recalculates the cached texture coordinates and draw size of a frame */
+/*   Call this after changing a frame's position or dimensions by hand */
+/* Takes a pointer to a frame */
+void ST_AnimationFrameRefresh(st_frame *frame);
+
+/* Changes the spritesheet of a frame and refreshes its cached values */
+/* Takes a pointer to a frame and a pointer to a spritesheet */
+void ST_AnimationFrameSetSpritesheet(st_frame *frame,
+  st_spritesheet *spritesheet);
+
+/* Shrinks a frame to the part of it that isn't fully transparent */
+/*   The frame still draws in the same place, it just covers fewer pixels */
+/*   The spritesheet must be loaded and RGBA8, RGBA4, or RGB5A1 */
+/* Takes a pointer to a frame */
+/* Returns 1 if the frame was trimmed, 0 if it couldn't be */
+u8 ST_AnimationFrameTrim(st_frame *frame);
+
+/* Cuts a spritesheet into a grid of same sized frames */
+/*   All of the frames are in one array, in order left to right, then top */
+/*   to bottom, and are freed together with ST_AnimationFreeFrames */
+/*   Skipping empty cells needs the spritesheet to be loaded and RGBA8, */
+/*   RGBA4, or RGB5A1, otherwise every cell is kept */
+/* Takes a pointer to a spritesheet, the size of each cell, the space */
+/*   around the grid and between cells, whether to skip cells that are */
+/*   fully transparent, and where to store the number of frames */
+/* Returns the frames, or NULL if failed or no cells fit */
+st_frame *ST_AnimationSliceSpritesheet(st_spritesheet *spritesheet,
+  u32 cellWidth, u32 cellHeight, u32 margin, u32 spacing, u8 skipEmpty,
+  u32 *count);
+
+/* Frees an array of frames from ST_AnimationSliceSpritesheet */
+/*   Animations using them must be freed first */
+/* Takes a pointer to the frames */
+void ST_AnimationFreeFrames(st_frame *frames);
+
 /*******************************\
 |*     Animation Functions     *|
 \*******************************/
@@ -74,7 +149,26 @@ void ST_AnimationFreeFrame(st_frame *frame);
 st_animation *ST_AnimationCreateAnimation(s16 fpf, u16 loopFrame,
   u16 length, ...);
 
+/* Returns a pointer to an animation of consecutive frames in an array */
+/*   The frames aren't freed with the animation */
+/*   Returns NULL if failed */
+/* Takes speed of animation (in frames between each frame of animation) */
+/*   Takes frame to loop to when the animation has reached its end */
+/*   Takes the array of frames, the first to use and how many */
+st_animation *ST_AnimationCreateAnimationRange(s16 fpf, u16 loopFrame,
+  st_frame *frames, u32 first, u16 length);
+
+/* Returns a pointer to an animation of frames in an array, picked by index */
+/*   The frames aren't freed with the animation */
+/*   Returns NULL if failed */
+/* Takes speed of animation (in frames between each frame of animation) */
+/*   Takes frame to loop to when the animation has reached its end */
+/*   Takes the array of frames, indices into it and how many there are */
+st_animation *ST_AnimationCreateAnimationIndices(s16 fpf, u16 loopFrame,
+  st_frame *frames, const u16 *indices, u16 length);
+
 /* Frees an animation and all of its frames from memory */
+/*   Frames it shares with something else are left alone */
 /* Takes a pointer to an animation */
 void ST_AnimationFreeAnimation(st_animation *animation);
 
@@ -91,10 +185,58 @@ void ST_AnimationNextFrame(st_animation *animation);
 /* Takes a pointer to an animation */
 void ST_AnimationPreviousFrame(st_animation *animation);
 
+/* Trims every frame of an animation */
+/* Takes a pointer to an animation */
+/* Returns the number of frames trimmed */
+u16 ST_AnimationTrimAnimation(st_animation *animation);
+
 /* Sets the speed (fpf) of an animation */
 /* Takes a pointer to an animation and frame to go to */
 void ST_AnimationSetSpeed(st_animation *animation, s16 speed);
 
+/* Moves an animation on by a number of played frames without drawing it */
+/*   Keeps the timing of ST_RenderAnimationPlayAdvanced, showing each */
+/*   frame for fpf + 1 frames, and frames left over after moving onto a */
+/*   new frame count toward the next one */
+/* Takes a pointer to an animation and the number of frames */
+void ST_AnimationStep(st_animation *animation, u16 frames);
+
+/****************************\
+|*     Animation Events     *|
+\****************************/
+/* Events fire when playback moves onto their frame: through */
+/*   ST_AnimationNextFrame, ST_AnimationPreviousFrame, or the */
+/*   ST_RenderAnimation* functions that advance. Each animation keeps its */
+/*   place in its sorted event list, so moving onto a frame without events */
+/*   costs a couple of compares. Fired events are gathered into one buffer */
+/*   for the game to go through once per frame */
+
+/* Adds an event to an animation */
+/* Takes a pointer to an animation, the frame it's on, and its id */
+/* Returns 1 on success and 0 on failure */
+u8 ST_AnimationAddEvent(st_animation *animation, u16 frame, u16 id);
+
+/* Removes every event from an animation */
+/* Takes a pointer to an animation */
+void ST_AnimationClearEvents(st_animation *animation);
+
+/* Sets the pointer passed along with an animation's events */
+/* Takes a pointer to an animation and a pointer to pass along */
+void ST_AnimationSetEventData(st_animation *animation, void *data);
+
+/* Fires the events on the current frame of an animation */
+/*   Done for you when playback moves onto a frame */
+/* Takes a pointer to an animation */
+void ST_AnimationDispatchEvents(st_animation *animation);
+
+/* Returns the events fired since the last call, oldest first */
+/*   They stay valid until the next call */
+/* Takes a pointer to where to store the number of events */
+const st_firedevent *ST_AnimationDrainEvents(u32 *count);
+
+/* Frees the fired event buffers */
+u8 ST_AnimationFini(void);
+
 #endif
 
 #ifdef __cplusplus
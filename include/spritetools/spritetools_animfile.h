@@ -0,0 +1,180 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_animfile_h
+
+#define __spritetools_animfile_h
+
+/* The layout below is shared with the host tools in tools/ */
+#include <spritetools/spritetools_texture.h>
+
+/**********************************\
+|*     Animation File Defines     *|
+\**********************************/
+/* Identifies an animation file ("STAN" read as a little endian u32) */
+#define ST_ANIMFILE_MAGIC 0x4E415453
+
+/* Version of the animation file layout */
+#define ST_ANIMFILE_VERSION 2
+
+/* Header at the start of an animation file */
+/*   All values are little endian. The header is followed by the sheets, */
+/*   frames, animations, events, sets, indices and strings, each packed */
+/*   right after the last. Names are offsets into the strings, which are */
+/*   nul terminated. Records refer to each other by index */
+typedef struct {
+  u32 magic; /* ST_ANIMFILE_MAGIC */
+  u16 version; /* ST_ANIMFILE_VERSION */
+  u16 reserved;
+  u32 sheetCount;
+  u32 frameCount;
+  u32 animationCount;
+  u32 eventCount;
+  u32 setCount;
+  u32 indexCount;
+  u32 stringsSize;
+  u32 reserved2;
+} st_animfileheader;
+
+/* Spritesheet the frames are cut from */
+typedef struct {
+  u32 name; /* Archive entry or whatever the game's resolver understands */
+} st_animfilesheet;
+
+/* Frame, as for ST_AnimationCreateFrameOffset */
+/*   Frames packed with their transparent borders cut off keep the size */
+/*   they had before and how far that moved their center, like */
+/*   ST_AnimationFrameTrim leaves them */
+typedef struct {
+  u32 sheet;
+  u16 xleft;
+  u16 ytop;
+  u16 width;
+  u16 height;
+  s16 xoff;
+  s16 yoff;
+  s16 trimX;
+  s16 trimY;
+  u16 sourceWidth;
+  u16 sourceHeight;
+} st_animfileframe;
+
+/* Animation, as for ST_AnimationCreateAnimation */
+typedef struct {
+  u32 name;
+  s16 fpf;
+  u16 loopFrame;
+  u32 frames; /* First of length frame indices in the indices */
+  u16 length;
+  u16 eventCount;
+  u32 events; /* First of eventCount events, sorted by frame */
+} st_animfileanimation;
+
+/* Event on a frame, the same layout as st_animationevent */
+typedef struct {
+  u16 frame;
+  u16 id;
+} st_animfileevent;
+
+/* Set of animations an entity is made with, like all of a character's */
+typedef struct {
+  u32 name;
+  u32 animations; /* First of count animation indices in the indices */
+  u32 count;
+} st_animfileset;
+
+/* Returns the size of an animation file from its header */
+static inline u32 ST_AnimFileSize(const st_animfileheader *header)
+{
+  return sizeof(st_animfileheader) +
+    header->sheetCount * sizeof(st_animfilesheet) +
+    header->frameCount * sizeof(st_animfileframe) +
+    header->animationCount * sizeof(st_animfileanimation) +
+    header->eventCount * sizeof(st_animfileevent) +
+    header->setCount * sizeof(st_animfileset) +
+    header->indexCount * sizeof(u32) + header->stringsSize;
+}
+
+#ifdef _3DS
+
+#include <3ds.h>
+#include <spritetools/spritetools_entity.h>
+#include <spritetools/spritetools_archive.h>
+
+/* Returns the spritesheet a name in an animation file refers to */
+/*   Takes the name and the data given to the loading function */
+typedef st_spritesheet *(*st_animfileresolve)(const char *name, void *data);
+
+/* A loaded animation file */
+/*   Everything lives in one block: this struct, the frames, animations and */
+/*   frame lists built from the file, and the file itself. Loading is one */
+/*   read followed by one pass that turns indices into pointers */
+typedef struct {
+  const st_animfileheader *header;
+  const st_animfileanimation *animationRecords;
+  const st_animfileset *sets;
+  const u32 *indices;
+  const char *strings;
+  st_spritesheet **sheets;
+  st_frame *frames;
+  st_frame **frameLists; /* One pointer for each index */
+  st_animation *animations; /* Shared templates, see ST_AnimFileCreateEntity */
+} st_animfile;
+
+/************************************\
+|*     Animation File Functions     *|
+\************************************/
+/* Loads an animation file */
+/* Takes path, a function to find spritesheets by name, and data for it */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoad(const char *path, st_animfileresolve resolve,
+  void *data);
+
+/* Loads an animation file already in memory */
+/*   The buffer is copied and can be freed afterwards */
+/* Takes buffer, its size in bytes, a function to find spritesheets by */
+/*   name, and data for it */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoadMemory(const void *buffer, u32 size,
+  st_animfileresolve resolve, void *data);
+
+/* Loads an animation file from an archive */
+/*   Its spritesheets are loaded from the same archive */
+/* Takes pointer to st_archive and the name of the file */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoadArchive(st_archive *archive, const char *name);
+
+/* Frees an animation file and releases its spritesheets */
+/*   Entities made from it must be freed first */
+/* Takes pointer to st_animfile */
+void ST_AnimFileFree(st_animfile *file);
+
+/* Finds an animation by name */
+/*   The animation is shared, so playing it directly moves it for */
+/*   everything else that plays it */
+/* Takes pointer to st_animfile and name */
+/* Returns pointer to the animation or NULL if there isn't one */
+st_animation *ST_AnimFileFindAnimation(st_animfile *file, const char *name);
+
+/* Makes an entity with the animations of a set */
+/*   The entity gets its own copy of each animation so it plays them on */
+/*   its own, but the frames and events stay in the file */
+/* Takes pointer to st_animfile, name of the set and a position */
+/* Returns pointer to st_entity or NULL on failure */
+st_entity *ST_AnimFileCreateEntity(st_animfile *file, const char *set,
+  double x, double y);
+
+#endif
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,156 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_archive_h
+
+#define __spritetools_archive_h
+
+/* The layout half of this header is shared with tools/stpack, so only the */
+/*   functions depend on the 3DS toolchain */
+#include <spritetools/spritetools_texture.h>
+
+/***************************\
+|*     Archive Defines     *|
+\***************************/
+/* Identifies an archive ("STPK" read as a little endian u32) */
+#define ST_ARCHIVE_MAGIC 0x4B505453
+
+/* Version of the archive layout */
+#define ST_ARCHIVE_VERSION 1
+
+/* Payloads start on multiples of this many bytes */
+#define ST_ARCHIVE_ALIGN 0x80
+
+/* Name offset of an empty slot in the table of contents */
+#define ST_ARCHIVE_EMPTY 0xFFFFFFFF
+
+/*************************\
+|*     Archive Types     *|
+\*************************/
+/* What an archive entry holds */
+typedef enum {
+  ST_ARCHIVE_RAW,
+  ST_ARCHIVE_TEXTURE, /* Converted texture made by tools/sttexconv */
+  ST_ARCHIVE_PNG,
+  ST_ARCHIVE_BMP,
+  ST_ARCHIVE_JPEG,
+  ST_ARCHIVE_ANIMATION /* Animation file (see spritetools_animfile.h) */
+} st_archivetype;
+
+/* Header at the start of an archive. All values are little endian */
+/*   The table of contents and names follow it directly so they can be */
+/*   read together, and the payloads come after them in packing order */
+typedef struct {
+  u32 magic; /* ST_ARCHIVE_MAGIC */
+  u16 version; /* ST_ARCHIVE_VERSION */
+  u16 reserved;
+  u32 entryCount;
+  u32 tableSize; /* Slots in the table of contents (a power of 2) */
+  u32 namesSize; /* Bytes of names after the table */
+  u32 indexSize; /* Bytes of header, table and names */
+  u32 dataSize; /* Bytes of payloads after the index */
+  u32 reserved2;
+} st_archiveheader;
+
+/* Slot in the table of contents, an open addressed hash table of names */
+typedef struct {
+  u32 hash; /* ST_ArchiveHash of the name */
+  u32 name; /* Offset of the name in the names, or ST_ARCHIVE_EMPTY */
+  u32 offset; /* Offset of the payload from the start of the archive */
+  u32 size; /* Bytes of payload */
+  u16 type; /* st_archivetype */
+  u16 flags;
+  u32 reserved;
+} st_archiveentry;
+
+/* Returns the hash of an entry name (32 bit FNV-1a) */
+static inline u32 ST_ArchiveHash(const char *name)
+{
+  u32 hash = 0x811C9DC5;
+  while (*name)
+    hash = (hash ^ (u8)*name++) * 0x01000193;
+  return hash;
+}
+
+#ifdef _3DS
+
+#include <3ds.h>
+#include <stdio.h>
+#include <spritetools/spritetools_spritesheet.h>
+
+/* An open archive */
+/*   Archives opened from memory hand out pointers to their payloads, */
+/*   archives opened from files read payloads straight to where they go */
+typedef struct {
+  st_archiveheader *header; /* Whole index, header first */
+  st_archiveentry *table;
+  const char *names;
+  const u8 *memory; /* Start of the archive in memory, or NULL */
+  FILE *file; /* Archive file, or NULL */
+  LightLock lock; /* Lets the loader thread read the file too */
+} st_archive;
+
+/*****************************\
+|*     Archive Functions     *|
+\*****************************/
+/* Opens an archive file, reading only its index */
+/*   Works with romfs:/ and sdmc:/ paths */
+/* Takes path */
+/* Returns pointer to st_archive or NULL on failure */
+st_archive *ST_ArchiveOpen(const char *path);
+
+/* Opens an archive already in memory, such as one linked into the program */
+/*   The buffer is not copied and must stay valid */
+/* Takes buffer and its size in bytes */
+/* Returns pointer to st_archive or NULL on failure */
+st_archive *ST_ArchiveOpenMemory(const void *buffer, u32 size);
+
+/* Closes an archive */
+/*   Spritesheets loaded from it must be freed first */
+/* Takes pointer to st_archive */
+void ST_ArchiveClose(st_archive *archive);
+
+/* Finds an entry by name */
+/* Takes pointer to st_archive and name */
+/* Returns entry index or -1 if there isn't one */
+s32 ST_ArchiveFind(st_archive *archive, const char *name);
+
+/* Returns pointer to an entry */
+/* Takes pointer to st_archive and entry index */
+/* Returns pointer to st_archiveentry or NULL if the index is bad */
+const st_archiveentry *ST_ArchiveEntry(st_archive *archive, s32 index);
+
+/* Returns a pointer to an entry's payload if the archive is in memory */
+/* Takes pointer to st_archive and entry index */
+/* Returns pointer to the payload or NULL */
+const void *ST_ArchiveData(st_archive *archive, s32 index);
+
+/* Copies part of an entry's payload */
+/* Takes pointer to st_archive, entry index, offset into the payload, */
+/*   destination and number of bytes */
+/* Returns number of bytes copied */
+u32 ST_ArchiveRead(st_archive *archive, s32 index, u32 offset, void *dst,
+  u32 size);
+
+/* Loads a spritesheet from an entry */
+/*   Converted textures from an archive file are read straight into their */
+/*   texture without a copy on the heap */
+/* Takes pointer to st_archive, name and a placement hint */
+/* Returns pointer to st_spritesheet or NULL on failure */
+st_spritesheet *ST_ArchiveLoadSpritesheet(st_archive *archive,
+  const char *name, st_placement placement);
+
+#endif
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_capture_h
+
+#define __spritetools_capture_h
+
+/* Like spritetools_texture.h, this is shared with the host tools so */
+/*   captured frames can be analyzed off the device (see tools/stoverdraw.c) */
+#include <spritetools/spritetools_texture.h>
+
+/**********************************\
+|*     Render Capture Defines     *|
+\**********************************/
+/* Identifies a render capture ("STCF" read as a little endian u32) */
+#define ST_CAPTURE_MAGIC 0x46435453
+
+/* Version of the render capture layout */
+#define ST_CAPTURE_VERSION 1
+
+/* Screens records can start */
+#define ST_CAPTURE_TOP 0
+#define ST_CAPTURE_BOTTOM 1
+
+/* Types of capture records */
+typedef enum {
+  ST_CAPTURE_END_FRAME, /* Buffers were swapped */
+  ST_CAPTURE_SCREEN, /* Drawing moved to a screen */
+  ST_CAPTURE_SCISSOR, /* Drawing was clipped, or stopped being clipped */
+  ST_CAPTURE_QUAD /* A spritesheet was drawn */
+} st_capturetype;
+
+/* Header at the start of a render capture, followed by its records */
+/*   All values are little endian */
+typedef struct {
+  u32 magic; /* ST_CAPTURE_MAGIC */
+  u16 version; /* ST_CAPTURE_VERSION */
+  u16 reserved;
+} st_captureheader;
+
+/* A single recorded command */
+/*   Screens keep the screen in value */
+/*   Scissors keep 1 in value while clipping, 0 once clipping stops */
+/*   Scissors and quads keep their corners in screen pixels, in order */
+/*     around them. Quads keep the drawn spritesheet's format in value */
+typedef struct {
+  u16 type; /* st_capturetype */
+  u16 value;
+  float x[4];
+  float y[4];
+} st_capturerecord;
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_component_h
+
+#define __spritetools_component_h
+
+#include <3ds/types.h>
+
+/* Number of bits of a handle that are its index */
+/*   The rest are free for telling apart reuses of the same index */
+#define ST_HANDLE_INDEX_BITS 20
+
+/* Returns the index part of a handle */
+#define ST_HANDLE_INDEX(handle) ((handle) & ((1 << ST_HANDLE_INDEX_BITS) - 1))
+
+/* Handle that never refers to anything */
+#define ST_HANDLE_NONE 0xFFFFFFFF
+
+/* Most component types a query can ask for */
+#define ST_QUERY_MAX_TYPES 8
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Handle of something components are attached to */
+typedef u32 st_handle;
+
+/* Every component of one type, packed */
+/*   The sparse array maps handle indices to places in the packed arrays, */
+/*   so lookups are one step and going through components never skips */
+/*   over holes */
+typedef struct {
+  u32 size; /* Bytes in each component */
+  u32 *sparse; /* Place in the packed arrays + 1, or 0, by handle index */
+  u32 sparseSize;
+  st_handle *handles; /* Handle each component belongs to */
+  u8 *data; /* Components, with one more slot kept free for swapping */
+  u32 count;
+  u32 capacity;
+} st_componentstore;
+
+/* Component types an application registered */
+typedef struct {
+  st_componentstore *stores;
+  u16 storeCount;
+  u16 storeCapacity;
+} st_componentregistry;
+
+/* Going through everything that has all of a set of component types */
+/*   The smallest store is walked in order and the others are looked up, */
+/*   from the end back so components can be removed on the way */
+typedef struct {
+  st_componentregistry *registry;
+  u16 types[ST_QUERY_MAX_TYPES];
+  u8 typeCount;
+  u16 lead; /* Type with the fewest components */
+  u32 position;
+  st_handle handle; /* Current match */
+  void *components[ST_QUERY_MAX_TYPES]; /* Its components, as in types */
+} st_componentquery;
+
+/*******************************\
+|*     Component Functions     *|
+\*******************************/
+/* Returns a pointer to a component registry */
+/*   Returns NULL if failed */
+st_componentregistry *ST_ComponentCreateRegistry(void);
+
+/* Frees a component registry and every component in it */
+/* Takes a pointer to a component registry */
+void ST_ComponentFreeRegistry(st_componentregistry *registry);
+
+/* Adds a component type */
+/* Takes a pointer to a component registry and the size of the component */
+/* Returns the type, or -1 on failure */
+s32 ST_ComponentRegister(st_componentregistry *registry, u32 size);
+
+/* Adds a component to a handle */
+/*   New components are zeroed. Pointers to components of a type stay */
+/*   valid until one of that type is added or removed */
+/* Takes a pointer to a component registry, the type and the handle */
+/* Returns the component (the one already there if there is one), */
+/*   or NULL on failure */
+void *ST_ComponentAdd(st_componentregistry *registry, u16 type,
+  st_handle handle);
+
+/* Removes a component from a handle */
+/*   The last component of the type takes its place */
+/* Takes a pointer to a component registry, the type and the handle */
+/* Returns 1 if there was one to remove, 0 if not */
+u8 ST_ComponentRemove(st_componentregistry *registry, u16 type,
+  st_handle handle);
+
+/* Removes every component of a handle */
+/* Takes a pointer to a component registry and the handle */
+void ST_ComponentRemoveAll(st_componentregistry *registry, st_handle handle);
+
+/* Returns a handle's component, or NULL if it doesn't have one */
+/* Takes a pointer to a component registry, the type and the handle */
+void *ST_ComponentGet(st_componentregistry *registry, u16 type,
+  st_handle handle);
+
+/* Returns the number of components of a type */
+/* Takes a pointer to a component registry and the type */
+u32 ST_ComponentCount(st_componentregistry *registry, u16 type);
+
+/* Returns the packed components of a type */
+/* Takes a pointer to a component registry and the type */
+void *ST_ComponentData(st_componentregistry *registry, u16 type);
+
+/* Returns the handles of the packed components of a type, in order */
+/* Takes a pointer to a component registry and the type */
+const st_handle *ST_ComponentHandles(st_componentregistry *registry,
+  u16 type);
+
+/***************************\
+|*     Query Functions     *|
+\***************************/
+/* Starts going through everything with all of a set of component types */
+/* Takes a pointer to a query, a pointer to a component registry, the */
+/*   number of types and the types */
+/* Returns 1 on success and 0 if the types aren't valid */
+u8 ST_ComponentQueryStart(st_componentquery *query,
+  st_componentregistry *registry, u8 typeCount, const u16 *types);
+
+/* Moves a query on to the next match */
+/*   Components of the current match can be removed before calling this */
+/* Takes a pointer to a query */
+/* Returns 1 if there's a match, with its handle and components in the */
+/*   query, or 0 once there are no more */
+u8 ST_ComponentQueryNext(st_componentquery *query);
+
+/* Reorders the stores of a query's types so every match is at the front */
+/*   of each, in the same order */
+/*   Afterward the first count components of each type from */
+/*   ST_ComponentData belong together and can be gone through like plain */
+/*   arrays, until a component of one of the types is added or removed */
+/* Takes a pointer to a query */
+/* Returns the number of matches */
+u32 ST_ComponentQueryPack(st_componentquery *query);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
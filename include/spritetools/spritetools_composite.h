@@ -0,0 +1,129 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_composite_h
+
+#define __spritetools_composite_h
+
+#include <spritetools/spritetools_animation.h>
+
+/* Parent of parts attached straight to a composite's root */
+#define ST_COMPOSITE_ROOT -1
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Part of a composite, placed relative to its parent */
+typedef struct {
+  st_frame *frame;
+  s16 parent; /* Index of the parent part, or ST_COMPOSITE_ROOT */
+  s16 layer; /* Parts on lower layers are drawn first */
+  float x, y; /* Offset from the parent, in the parent's space */
+  float rotation;
+  float scale;
+  u8 red;
+  u8 green;
+  u8 blue;
+  u8 alpha;
+  u8 dirty; /* Local values changed since the world ones were worked out */
+  float worldX, worldY; /* Relative to the composite's root */
+  float worldRotation;
+  float worldScale;
+} st_compositepart;
+
+/* Sprite built from many parts, like a boss made of cutout limbs */
+/*   Parts always come after their parent, so one pass in order updates */
+/*   world values, and only for parts that changed or whose parent did */
+typedef struct {
+  st_compositepart *parts;
+  u16 partCount;
+  u16 partCapacity;
+  u16 *order; /* Part indices sorted by layer */
+  u8 orderDirty;
+  u8 dirty; /* Some part's local values changed */
+  double xpos; /* Root position, rotation and scale in the world */
+  double ypos;
+  double rotation;
+  double scale;
+} st_composite;
+
+/*******************************\
+|*     Composite Functions     *|
+\*******************************/
+/* Returns a pointer to a composite */
+/*   Returns NULL if failed */
+/* Takes a position and the number of parts to make room for */
+st_composite *ST_CompositeCreate(double x, double y, u16 partCount);
+
+/* Frees a composite from memory */
+/*   Its frames are not freed */
+/* Takes a pointer to a composite */
+void ST_CompositeFree(st_composite *composite);
+
+/* Adds a part to a composite */
+/*   Parts start unrotated, unscaled and untinted */
+/* Takes a pointer to a composite, a frame, the parent part (an earlier */
+/*   part or ST_COMPOSITE_ROOT), an offset from the parent and a layer */
+/* Returns the index of the part, or -1 on failure */
+s32 ST_CompositeAddPart(st_composite *composite, st_frame *frame,
+  s16 parent, float x, float y, s16 layer);
+
+/* Sets the offset of a part from its parent */
+/* Takes a pointer to a composite, the part and an offset */
+void ST_CompositeSetPartPosition(st_composite *composite, u16 part,
+  float x, float y);
+
+/* Sets the rotation of a part relative to its parent */
+/* Takes a pointer to a composite, the part and a rotation in radians */
+void ST_CompositeSetPartRotation(st_composite *composite, u16 part,
+  float rotation);
+
+/* Sets the scale of a part relative to its parent */
+/* Takes a pointer to a composite, the part and a scale */
+void ST_CompositeSetPartScale(st_composite *composite, u16 part,
+  float scale);
+
+/* Sets the frame a part draws */
+/* Takes a pointer to a composite, the part and a frame */
+void ST_CompositeSetPartFrame(st_composite *composite, u16 part,
+  st_frame *frame);
+
+/* Sets the color to blend a part with */
+/* Takes a pointer to a composite, the part, and red, green, blue, alpha */
+void ST_CompositeSetPartColor(st_composite *composite, u16 part,
+  u8 red, u8 green, u8 blue, u8 alpha);
+
+/* Sets the layer of a part */
+/* Takes a pointer to a composite, the part and a layer */
+void ST_CompositeSetPartLayer(st_composite *composite, u16 part, s16 layer);
+
+/* Sets the position of a composite's root */
+/* Takes a pointer to a composite and a position */
+void ST_CompositeSetPosition(st_composite *composite, double x, double y);
+
+/* Sets the rotation of a composite's root */
+/* Takes a pointer to a composite and a rotation in radians */
+void ST_CompositeSetRotation(st_composite *composite, double rotation);
+
+/* Sets the scale of a composite's root */
+/* Takes a pointer to a composite and a scale */
+void ST_CompositeSetScale(st_composite *composite, double scale);
+
+/* Works out the world values of parts that changed and their children, */
+/*   and sorts the draw order if layers changed */
+/*   Rendering a composite does this for you */
+/* Takes a pointer to a composite */
+void ST_CompositeUpdate(st_composite *composite);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
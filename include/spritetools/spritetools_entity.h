@@ -13,6 +13,7 @@ extern "C"{
 #define __spritetools_entity_h
 
 #include <spritetools/spritetools_animation.h>
+#include <spritetools/spritetools_component.h>
 
 /********************\
 |*     Typedefs     *|
@@ -36,6 +37,28 @@ typedef struct {
   u8 alpha;
 } st_entity;
 
+/* Entities made up front and handed out by handle */
+/*   Spawning takes a slot off the free list and destroying queues it until */
+/*   ST_EntityPoolFlush, so neither touches the allocator and an entity */
+/*   destroyed partway through a loop over entities stays readable until */
+/*   the loop is done. Handles carry how many times their slot was reused */
+/*   above ST_HANDLE_INDEX_BITS, so old ones stop working */
+typedef struct {
+  st_entity *entities;
+  st_animation **animations; /* animCount for each slot */
+  char **names;
+  u16 *generations; /* Times each slot was reused */
+  u8 *states; /* Whether each slot is free, alive or destroyed */
+  u32 *freeList; /* Free slots, the next one to use last */
+  u32 freeCount;
+  st_handle *destroyed; /* Waiting for ST_EntityPoolFlush */
+  u32 destroyedCount;
+  u32 capacity;
+  u32 aliveCount;
+  u8 animCount;
+  st_componentregistry *registry; /* Components removed on flush */
+} st_entitypool;
+
 /***************************\
 |*     Entity Creation     *|
 \***************************/
@@ -54,6 +77,56 @@ void ST_EntityFreeEntity(st_entity *entity);
 /* Returns 1 on success and 0 on failure */
 u8 ST_EntityAddAnimation(st_entity *entity, st_animation *anim, char *name);
 
+/************************\
+|*     Entity Pools     *|
+\************************/
+/* Returns a pointer to an entity pool */
+/*   Returns NULL if failed */
+/* Takes the number of entities and of animations each can have */
+st_entitypool *ST_EntityPoolCreate(u32 capacity, u8 animCount);
+
+/* Frees an entity pool and all of its entities */
+/*   Animations added to its entities are not freed */
+/* Takes a pointer to an entity pool */
+void ST_EntityPoolFree(st_entitypool *pool);
+
+/* Sets a component registry whose components are removed along with */
+/*   destroyed entities when the pool is flushed */
+/* Takes a pointer to an entity pool and a pointer to a component registry */
+void ST_EntityPoolSetRegistry(st_entitypool *pool,
+  st_componentregistry *registry);
+
+/* Takes an entity from a pool, set up like ST_EntityCreateEntity does */
+/*   Entities from a pool must not be freed with ST_EntityFreeEntity */
+/* Takes a pointer to an entity pool and a position */
+/* Returns the entity's handle, or ST_HANDLE_NONE if the pool is empty */
+st_handle ST_EntityPoolSpawn(st_entitypool *pool, double x, double y);
+
+/* Returns the entity a handle refers to */
+/*   Returns NULL if it was destroyed */
+/* Takes a pointer to an entity pool and a handle */
+st_entity *ST_EntityPoolGet(st_entitypool *pool, st_handle handle);
+
+/* Destroys an entity */
+/*   It stays in memory, untouched, until the pool is flushed */
+/* Takes a pointer to an entity pool and a handle */
+/* Returns 1 on success and 0 if it was already destroyed */
+u8 ST_EntityPoolDestroy(st_entitypool *pool, st_handle handle);
+
+/* Gives the slots of destroyed entities back to a pool */
+/*   Call this where nothing is going through entities, like the end of an */
+/*   update. ST_LoopSetPool does it after every update */
+/* Takes a pointer to an entity pool */
+void ST_EntityPoolFlush(st_entitypool *pool);
+
+/* Goes through the entities of a pool that are alive */
+/*   Start the cursor at 0 */
+/* Takes a pointer to an entity pool, a pointer to the cursor and where */
+/*   to store the entity's handle (or NULL) */
+/* Returns the next entity, or NULL once there are no more */
+st_entity *ST_EntityPoolNext(st_entitypool *pool, u32 *cursor,
+  st_handle *handle);
+
 /**************************\
 |*     Setting Values     *|
 \**************************/
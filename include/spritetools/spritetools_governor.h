@@ -0,0 +1,124 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_governor_h
+
+#define __spritetools_governor_h
+
+#include <3ds/types.h>
+#include <spritetools/spritetools_animation.h>
+
+/* Highest quality level. The governor starts here */
+#define ST_GOVERNOR_MAX_QUALITY 4
+
+/* Default frame budget in ms (60 fps) */
+/*   This is the work done each frame, not counting waiting for vsync */
+#define ST_GOVERNOR_DEFAULT_BUDGET 16.6
+
+/* Maximum number of workloads that can be registered at once */
+#define ST_GOVERNOR_MAX_WORKLOADS 32
+
+/* Frames over budget in a row before quality is lowered */
+#define ST_GOVERNOR_DROP_FRAMES 3
+
+/* Frames comfortably under budget in a row before quality is raised */
+#define ST_GOVERNOR_RAISE_FRAMES 120
+
+/* Distance from the camera past which entities animate less often */
+#define ST_GOVERNOR_NEAR_DISTANCE 256.0
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Called whenever the quality level changes */
+/*   Takes the new quality level and user data */
+typedef void (*st_governorworkload)(u8 quality, void *data);
+
+/******************************\
+|*     Governor Functions     *|
+\******************************/
+/* Inits the governor */
+u8 ST_GovernorInit(void);
+
+/* Sets the frame budget in ms */
+void ST_GovernorSetBudget(double budget);
+
+/* Returns the frame budget in ms */
+double ST_GovernorGetBudget(void);
+
+/* Feeds the governor the length of the last frame in ms */
+/*   ST_RenderEndRender already does this, so only call it when you time */
+/*   frames yourself */
+void ST_GovernorFrame(double ms);
+
+/* Marks the start of a frame's work */
+/*   Call this after waiting for vsync so the wait isn't counted as work. */
+/*   ST_RenderEndRender already does this */
+void ST_GovernorStartWork(void);
+
+/* Reports work done for this frame somewhere else, like another thread */
+/*   The frame counts as the longest of this and the work measured by */
+/*   ST_GovernorTick */
+/* Takes the length of the work in ms */
+void ST_GovernorWork(double ms);
+
+/* Measures the work since ST_GovernorStartWork (or the last call) and */
+/*   feeds it to the governor */
+void ST_GovernorTick(void);
+
+/* Returns the smoothed frame time in ms */
+double ST_GovernorAverage(void);
+
+/* Returns the current quality level */
+/*   0 is the lowest and ST_GOVERNOR_MAX_QUALITY is full quality */
+u8 ST_GovernorQuality(void);
+
+/* Forces the quality level and notifies all workloads */
+void ST_GovernorSetQuality(u8 quality);
+
+/* Returns the quality level scaled to 0.0 - 1.0 */
+/*   Useful for scaling emission rates and counts of optional effects */
+double ST_GovernorScale(void);
+
+/* Returns the number of frames the governor has seen */
+u32 ST_GovernorFrameCount(void);
+
+/* Registers a workload to be told when the quality level changes */
+/*   The callback is also called right away with the current level */
+/* Takes a callback and user data */
+/* Returns id of the workload or -1 on failure */
+s8 ST_GovernorRegister(st_governorworkload workload, void *data);
+
+/* Removes a workload */
+/* Takes id of the workload */
+void ST_GovernorUnregister(s8 id);
+
+/***********************************\
+|*     Library Scaling Helpers     *|
+\***********************************/
+/* Returns how many frames an entity at the given distance from the */
+/*   camera should wait between animation updates (1 = every frame) */
+u8 ST_GovernorAnimationDivisor(double distance);
+
+/* Steps an animation for this frame, only every few frames when it's far */
+/*   from the camera and the quality is lowered, keeping its speed */
+/*   Animations are spread over those frames so they don't all step at once */
+/* Takes a pointer to an animation and its distance from the camera */
+void ST_GovernorStepAnimation(st_animation *animation, double distance);
+
+/* Returns a culling margin shrunk to match the quality level */
+/* Takes the margin used at full quality */
+double ST_GovernorCullMargin(double margin);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
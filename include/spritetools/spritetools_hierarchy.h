@@ -0,0 +1,118 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_hierarchy_h
+
+#define __spritetools_hierarchy_h
+
+#include <spritetools/spritetools_entity.h>
+
+/* Parent of nodes that aren't attached to anything */
+#define ST_HIERARCHY_ROOT -1
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Entity placed relative to its parent */
+typedef struct {
+  st_entity *entity;
+  u32 id; /* Stays the same when nodes are sorted */
+  s32 parent; /* Place of the parent in the nodes, or ST_HIERARCHY_ROOT */
+  double x, y; /* Offset from the parent, in the parent's space */
+  double rotation;
+  double scale;
+  double worldX, worldY; /* Last values given to the entity */
+  double worldRotation;
+  double worldScale;
+  u8 dirty; /* Local values changed since the world ones were worked out */
+} st_hierarchynode;
+
+/* Entities attached to each other, like a weapon to a hand */
+/*   Nodes are kept in one array with parents before their children, so */
+/*   one pass in order updates everything, and only nodes that changed or */
+/*   whose parent did are worked out again. Roots follow their entity, so */
+/*   they can be moved like any other entity */
+typedef struct {
+  st_hierarchynode *nodes;
+  st_hierarchynode *sorted; /* Room for sorting the nodes into */
+  u32 count;
+  u32 capacity;
+  u32 *places; /* Place of each node in the nodes by id */
+  u32 *freeIds;
+  u32 freeCount;
+  u32 *scratch; /* Room for two lists of places while sorting */
+  u32 nextId;
+  u8 orderDirty; /* A node was attached after its parent in the nodes */
+} st_hierarchy;
+
+/*******************************\
+|*     Hierarchy Functions     *|
+\*******************************/
+/* Returns a pointer to a hierarchy */
+/*   Returns NULL if failed */
+/* Takes the number of nodes to make room for */
+st_hierarchy *ST_HierarchyCreate(u32 capacity);
+
+/* Frees a hierarchy from memory */
+/*   Its entities are not freed */
+/* Takes a pointer to a hierarchy */
+void ST_HierarchyFree(st_hierarchy *hierarchy);
+
+/* Adds an entity to a hierarchy */
+/*   Children start at an offset from their parent, unrotated and */
+/*   unscaled. Roots start where their entity is */
+/* Takes a pointer to a hierarchy, the entity, the id of the parent (or */
+/*   ST_HIERARCHY_ROOT) and the offset from the parent */
+/* Returns the id of the node, or -1 on failure */
+s32 ST_HierarchyAdd(st_hierarchy *hierarchy, st_entity *entity, s32 parent,
+  double x, double y);
+
+/* Removes a node from a hierarchy */
+/*   Its children are attached to its parent and stay where they are */
+/* Takes a pointer to a hierarchy and the id of the node */
+void ST_HierarchyRemove(st_hierarchy *hierarchy, u32 id);
+
+/* Attaches a node to another parent, keeping its local values */
+/* Takes a pointer to a hierarchy, the id of the node and the id of the */
+/*   parent (or ST_HIERARCHY_ROOT) */
+/* Returns 1 on success and 0 if the parent is the node or its child */
+u8 ST_HierarchySetParent(st_hierarchy *hierarchy, u32 id, s32 parent);
+
+/* Sets the offset of a node from its parent */
+/* Takes a pointer to a hierarchy, the id of the node and an offset */
+void ST_HierarchySetPosition(st_hierarchy *hierarchy, u32 id,
+  double x, double y);
+
+/* Sets the rotation of a node relative to its parent */
+/* Takes a pointer to a hierarchy, the id of the node and a rotation in */
+/*   radians */
+void ST_HierarchySetRotation(st_hierarchy *hierarchy, u32 id,
+  double rotation);
+
+/* Sets the scale of a node relative to its parent */
+/* Takes a pointer to a hierarchy, the id of the node and a scale */
+void ST_HierarchySetScale(st_hierarchy *hierarchy, u32 id, double scale);
+
+/* Returns a node of a hierarchy, or NULL if there isn't one */
+/*   The pointer is good until nodes are added, removed or reparented */
+/* Takes a pointer to a hierarchy and the id of the node */
+st_hierarchynode *ST_HierarchyGetNode(st_hierarchy *hierarchy, u32 id);
+
+/* Works out the world values of nodes that changed and their children, */
+/*   and gives them to their entities */
+/*   Roots whose entity was moved, turned or scaled count as changed */
+/* Takes a pointer to a hierarchy */
+void ST_HierarchyUpdate(st_hierarchy *hierarchy);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,143 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_loader_h
+
+#define __spritetools_loader_h
+
+#include <3ds.h>
+#include <spritetools/spritetools_spritesheet.h>
+
+/**************************\
+|*     Loader Defines     *|
+\**************************/
+/* Stack size of the loader thread. Image decoders need a lot of it */
+#define ST_LOADER_THREAD_STACK 0x10000
+
+/* Core the loader thread runs on (-2 is the app's own core) */
+#define ST_LOADER_THREAD_CORE -2
+
+/************************\
+|*     Loader Types     *|
+\************************/
+/* Where a load is at */
+typedef enum {
+  ST_LOAD_QUEUED, /* Waiting for the loader thread */
+  ST_LOAD_LOADING, /* Being decoded */
+  ST_LOAD_DECODED, /* Decoded and waiting for ST_LoaderUpdate to upload it */
+  ST_LOAD_DONE, /* Spritesheet is ready */
+  ST_LOAD_FAILED,
+  ST_LOAD_CANCELLED
+} st_loadstate;
+
+struct st_loadjob;
+
+/* Called from ST_LoaderUpdate when a load finishes or fails */
+/* Takes the job and the data it was queued with */
+typedef void (*st_loadcallback)(struct st_loadjob *job, void *data);
+
+/* A queued load. Returned by the queue functions as a handle */
+/*   Only read it through the functions below until it's finished */
+typedef struct st_loadjob {
+  st_spritesheetsource source;
+  st_decodedsource decoded; /* Filled in by the loader thread */
+  st_spritesheet *spritesheet; /* Set once the state is ST_LOAD_DONE */
+  vu32 state; /* st_loadstate */
+  st_loadcallback callback;
+  void *data;
+  u8 released; /* Handle was freed before the load finished */
+  u8 cached; /* Spritesheet was already loaded and is shared */
+  u8 borrowed; /* Source buffer isn't kept once the load finishes */
+  struct st_loadjob *next;
+} st_loadjob;
+
+/****************************\
+|*     Loader Functions     *|
+\****************************/
+/* Images are decoded into ordinary memory on a background thread so the */
+/*   game can keep drawing while they load. Textures are only made and */
+/*   uploaded on the main thread by ST_LoaderUpdate, which */
+/*   ST_RenderEndRender calls every frame, so they never race the GPU or */
+/*   VRAM moves, and callbacks never run at the same time as the game */
+
+/* Inits the loader */
+/* Returns 1 on success, 0 on failure */
+u8 ST_LoaderInit(void);
+
+/* Cancels every queued load, waits for the current one and stops the */
+/*   loader thread */
+/* Returns 1 on success, 0 on failure */
+u8 ST_LoaderFini(void);
+
+/* Queues a spritesheet to be loaded from a source */
+/*   The spritesheet may be evicted and later reloaded from the source, so */
+/*   its buffer must stay valid until the spritesheet is freed */
+/* Takes pointer to a source, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueue(const st_spritesheetsource *source,
+  st_loadcallback callback, void *data);
+
+/* The shortcuts below only need their buffer until the load finishes, */
+/*   and their spritesheets are never evicted */
+
+/* Queues a spritesheet to be loaded from a PNG file */
+/* Takes buffer, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueuePNG(const void *buffer, st_loadcallback callback,
+  void *data);
+
+/* Queues a spritesheet to be loaded from a BMP file */
+/* Takes buffer, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueueBMP(const void *buffer, st_loadcallback callback,
+  void *data);
+
+/* Queues a spritesheet to be loaded from a JPEG file */
+/* Takes buffer, its size, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueueJPEG(const void *buffer, unsigned long buffer_size,
+  st_loadcallback callback, void *data);
+
+/* Finishes decoded loads and runs their callbacks */
+/*   Called by ST_RenderEndRender, but can be called more often */
+/* Returns the number of loads still queued or decoding */
+u32 ST_LoaderUpdate(void);
+
+/* Returns the state of a load */
+/* Takes pointer to st_loadjob */
+st_loadstate ST_LoaderState(st_loadjob *job);
+
+/* Returns 1 if a load has finished one way or another, 0 if not */
+/* Takes pointer to st_loadjob */
+u8 ST_LoaderFinished(st_loadjob *job);
+
+/* Returns the loaded spritesheet, or NULL if it isn't done */
+/* Takes pointer to st_loadjob */
+st_spritesheet *ST_LoaderSpritesheet(st_loadjob *job);
+
+/* Cancels a load that hasn't started decoding yet */
+/* Takes pointer to st_loadjob */
+/* Returns 1 if it was cancelled, 0 if it's too late */
+u8 ST_LoaderCancel(st_loadjob *job);
+
+/* Returns the number of loads still queued or decoding */
+u32 ST_LoaderPending(void);
+
+/* Frees a load handle, not the spritesheet it loaded */
+/*   Unfinished loads are cancelled if they can be, otherwise their */
+/*   spritesheet is freed when it arrives */
+/* Takes pointer to st_loadjob */
+void ST_LoaderFree(st_loadjob *job);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_loop_h
+
+#define __spritetools_loop_h
+
+#include <spritetools/spritetools_entity.h>
+
+/* Default number of updates a single frame may catch up on */
+#define ST_LOOP_DEFAULT_MAX_STEPS 5
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Called at a fixed rate. Takes the step length in ms and user data */
+typedef void (*st_loopupdate)(double step, void *data);
+
+/* Called once per frame. Takes how far (0.0 to 1.0) the frame is between */
+/*   the last two updates and user data */
+typedef void (*st_looprender)(double alpha, void *data);
+
+/* Position of a tracked entity before and after the last update */
+typedef struct {
+  st_entity *entity;
+  double prevx, prevy, prevrot;
+  double currx, curry, currrot;
+} st_loopstate;
+
+/* Fixed timestep game loop */
+typedef struct {
+  double step; /* Length of one update in ms */
+  double accumulator; /* Time in ms that hasn't been simulated yet */
+  double alpha; /* Interpolation value of the last rendered frame */
+  u64 lastTick; /* System tick of the last frame */
+  u32 maxSteps; /* Most updates run in one frame before time is dropped */
+  u32 stepCount; /* Updates run since the loop was created */
+  st_loopupdate update;
+  st_looprender render;
+  void *data;
+  st_loopstate *states; /* Entities interpolated when rendering */
+  u32 stateCount;
+  u32 stateCapacity;
+  st_entitypool *pool; /* Flushed after every update */
+  u8 running;
+} st_loop;
+
+/**************************\
+|*     Loop Functions     *|
+\**************************/
+/* Returns a pointer to a loop */
+/*   Returns NULL if failed */
+/* Takes number of updates per second, an update and a render function, */
+/*   and user data passed to both */
+st_loop *ST_LoopCreate(double rate, st_loopupdate update,
+  st_looprender render, void *data);
+
+/* Frees a loop from memory */
+/* Takes a pointer to a loop */
+void ST_LoopFree(st_loop *loop);
+
+/* Sets the most updates a single frame may catch up on */
+/*   Time past that is dropped so a slow frame can't snowball */
+/* Takes a pointer to a loop and a number of updates */
+void ST_LoopSetMaxSteps(st_loop *loop, u32 maxSteps);
+
+/* Sets an entity pool to flush after every update */
+/*   Destroyed entities are untracked before their slots are reused */
+/* Takes a pointer to a loop and a pointer to an entity pool (or NULL) */
+void ST_LoopSetPool(st_loop *loop, st_entitypool *pool);
+
+/* Runs one frame: as many fixed updates as time allows, then a render */
+/* Takes a pointer to a loop */
+/* Returns the interpolation value given to the render function */
+double ST_LoopTick(st_loop *loop);
+
+/* Runs frames until ST_LoopStop is called or the app is closed */
+/* Takes a pointer to a loop */
+void ST_LoopRun(st_loop *loop);
+
+/* Makes ST_LoopRun return after the current frame */
+/* Takes a pointer to a loop */
+void ST_LoopStop(st_loop *loop);
+
+/* Returns the interpolation value of the last rendered frame */
+/* Takes a pointer to a loop */
+double ST_LoopAlpha(st_loop *loop);
+
+/****************************\
+|*     Entity Smoothing     *|
+\****************************/
+/* Tracked entities are drawn between their last two updated positions */
+/*   Their real values are put back once the render function returns */
+
+/* Starts interpolating an entity when rendering */
+/* Takes a pointer to a loop and a pointer to an entity */
+/* Returns 1 on success and 0 on failure */
+u8 ST_LoopTrackEntity(st_loop *loop, st_entity *entity);
+
+/* Stops interpolating an entity */
+/* Takes a pointer to a loop and a pointer to an entity */
+void ST_LoopUntrackEntity(st_loop *loop, st_entity *entity);
+
+/* Makes a tracked entity skip interpolation for its next frame */
+/*   Use after teleporting an entity so it doesn't slide to its new spot */
+/* Takes a pointer to a loop and a pointer to an entity */
+void ST_LoopSnapEntity(st_loop *loop, st_entity *entity);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_pixel_h
+
+#define __spritetools_pixel_h
+
+/* Like spritetools_texture.h, this is shared with the host tools so the */
+/*   kernels can be benchmarked off the device (see tools/stpixelbench.c) */
+#include <spritetools/spritetools_texture.h>
+
+/* Returns offset in texels of a texel in the GPU's tiled layout */
+/*   Textures are 8x8 tiles in rows with the texels of a tile in Morton */
+/*   order. y counts up from the bottom of the texture, which is stored */
+/*   first, so an image's row r is at y = texture height - 1 - r */
+static inline u32 ST_PixelTiledOffset(u32 x, u32 y, u32 width)
+{
+  u32 morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
+    ((x & 4) << 2) | ((y & 4) << 3);
+  return (y & ~7) * width + (x & ~7) * 8 + morton;
+}
+
+/***************************\
+|*     Pixel Functions     *|
+\***************************/
+/* Kernels for getting texel data ready for the GPU. Each has an SSE2 and */
+/*   a NEON version that's used when the compiler targets them, and a */
+/*   scalar version for everything else, including the 3DS (the ARM11 has */
+/*   no NEON). Defining ST_PIXEL_NO_SIMD forces the scalar versions */
+/* RGBA8 texels are bytes in R, G, B, A order. The GPU wants them the other */
+/*   way around, which a "swap" does */
+
+/* Returns the name of the kernels compiled in ("sse2", "neon" or "scalar") */
+const char *ST_PixelPath(void);
+
+/* Reverses the bytes of RGBA8 texels, turning RGBA into the GPU's ABGR */
+/*   src and dst can be the same */
+/* Takes source, destination and number of texels */
+void ST_PixelSwapRGBA8(const u32 *src, u32 *dst, u32 count);
+
+/* Multiplies the color of RGBA8 texels by their alpha, in place */
+/* Takes texels and number of texels */
+void ST_PixelPremultiply(u8 *rgba, u32 count);
+
+/* Packs RGBA8 texels into a 16 bit format */
+/* Takes source, destination, number of texels and format (RGB565, RGB5A1 */
+/*   or RGBA4) */
+/* Returns 1 on success, 0 if the format isn't 16 bit */
+u8 ST_PixelPack16(const u8 *rgba, u16 *dst, u32 count, u16 format);
+
+/* Tiles a linear image of 32 bit texels into a texture */
+/*   The image's top row goes to the top of the texture, which the GPU */
+/*   stores last. Texels of the texture outside the image are left alone */
+/* Takes source, source stride in texels, image width and height, */
+/*   destination, texture width and height (multiples of 8), and whether */
+/*   to swap RGBA into ABGR on the way */
+void ST_PixelTile32(const u32 *src, u32 stride, u32 width, u32 height,
+  u32 *dst, u32 texWidth, u32 texHeight, u8 swap);
+
+/* Tiles a linear image of 16 bit texels into a texture */
+/* Takes source, source stride in texels, image width and height, */
+/*   destination, and texture width and height (multiples of 8) */
+void ST_PixelTile16(const u16 *src, u32 stride, u32 width, u32 height,
+  u16 *dst, u32 texWidth, u32 texHeight);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,10 +12,13 @@ extern "C"{
 
 #define __spritetools_render_h
 
+#include <stdio.h>
 #include <spritetools/spritetools_spritesheet.h>
 #include <spritetools/spritetools_animation.h>
 #include <spritetools/spritetools_entity.h>
 #include <spritetools/spritetools_camera.h>
+#include <spritetools/spritetools_viewport.h>
+#include <spritetools/spritetools_composite.h>
 
 /*****************************\
 |*     General Functions     *|
@@ -51,6 +54,54 @@ void ST_RenderSetBackground(u8 red, u8 green, u8 blue);
 /* Returns background color in the RGBA8 format */
 u32 ST_RenderGetBackground(void);
 
+/* Clips drawing to a rectangle of the current screen */
+/* Takes position and size of the rectangle */
+void ST_RenderSetScissor(u32 x, u32 y, u32 width, u32 height);
+
+/* Stops clipping drawing */
+void ST_RenderClearScissor(void);
+
+/**************************\
+|*     Render Capture     *|
+\**************************/
+/* Records the screen space every drawn spritesheet covers, frame by frame, */
+/*   so fill rate and overdraw can be analyzed off the device with */
+/*   tools/stoverdraw. The file is in the layout of spritetools_capture.h */
+
+/* Starts recording what each frame draws to a file */
+/* Takes an open file and number of frames to record (0 for no limit) */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCaptureStart(FILE *file, u32 frames);
+
+/* Stops recording frames */
+/*   The file is flushed but left open */
+void ST_RenderCaptureStop(void);
+
+/* Returns 1 if frames are being recorded and 0 if not */
+u8 ST_RenderCapturing(void);
+
+/*************************\
+|*     Render Thread     *|
+\*************************/
+/* While the render thread is running, ST_Render* calls are recorded into a */
+/*   command list instead of being drawn. ST_RenderEndRender hands the list */
+/*   to the thread on the second core and the game can start the next frame */
+/*   right away. Spritesheets must stay alive until their frame is drawn, */
+/*   so call ST_RenderThreadSync before freeing one that was just rendered */
+
+/* Starts the render thread */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderThreadStart(void);
+
+/* Waits for all submitted frames and stops the render thread */
+void ST_RenderThreadStop(void);
+
+/* Waits until the render thread has drawn every submitted frame */
+void ST_RenderThreadSync(void);
+
+/* Returns 1 if the render thread is running and 0 if not */
+u8 ST_RenderThreadRunning(void);
+
 /*******************************\
 |*     Render Spritesheets     *|
 \*******************************/
@@ -235,6 +286,44 @@ u8 ST_RenderEntityMainCamera(st_entity *entity);
 /* Returns 1 on success and 0 on failure */
 u8 ST_RenderEntityMainCameraNoSpriteRot(st_entity *entity);
 
+/*******************************\
+|*     Composite Rendering     *|
+\*******************************/
+/* Composites are drawn as one run of commands: their parts' transforms */
+/*   are only worked out again for parts that changed, and then each part */
+/*   just has the root's transform applied */
+
+/* Draws a composite at its position */
+/* Takes a pointer to a composite */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderComposite(st_composite *composite);
+
+/* Draws a composite modified by a camera's values */
+/* Takes a pointer to a composite and a pointer to a camera */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCompositeCamera(st_composite *composite, st_camera *cam);
+
+/* Draws a composite modified by the main camera's values */
+/* Takes a pointer to a composite */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCompositeMainCamera(st_composite *composite);
+
+/******************************\
+|*     Viewport Rendering     *|
+\******************************/
+/* Draws the entities in a viewport's draw list */
+/*   ST_ViewportCull must be called first to fill the list and step the */
+/*   animations, so this only draws their current frames */
+/* Takes a pointer to a viewport */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderViewport(st_viewport *viewport);
+
+/* Draws every viewport that belongs to the current screen */
+/*   Cull all viewports once per frame, then call this after starting */
+/*   each screen's frame */
+/* Takes a list of viewports and number of viewports */
+void ST_RenderViewports(st_viewport **viewports, u8 viewportCount);
+
 #endif
 
 #ifdef __cplusplus
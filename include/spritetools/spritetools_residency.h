@@ -0,0 +1,138 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_residency_h
+
+#define __spritetools_residency_h
+
+#include <spritetools/spritetools_spritesheet.h>
+
+/* Budget used until ST_ResidencySetBudget is called (0 = no limit) */
+#define ST_RESIDENCY_DEFAULT_BUDGET 0
+
+/* Number of frames sampling is counted over before placement is updated */
+#define ST_RESIDENCY_PLACEMENT_WINDOW 60
+
+/* VRAM left free for the application when promoting spritesheets */
+#define ST_RESIDENCY_VRAM_RESERVE 0x40000
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Bookkeeping for one spritesheet */
+typedef struct {
+  st_spritesheet *spritesheet;
+  st_spritesheetsource source;
+  u32 bytes; /* Size of the texture data */
+  u32 lastFrame; /* Frame the spritesheet was last drawn on */
+  u32 pressure; /* Texels drawn from it in the current placement window */
+  u8 resident; /* 1 if the texture data is loaded */
+  u8 moveDue; /* Waiting for ST_ResidencyPlace to move it */
+} st_residency;
+
+/*******************************\
+|*     Residency Functions     *|
+\*******************************/
+/* Every spritesheet made by the ST_Spritesheet loaders is tracked here. */
+/*   When more texture memory is live than the budget allows, the */
+/*   spritesheets drawn longest ago have their texture data freed. The */
+/*   st_spritesheet itself stays valid and is reloaded from its source the */
+/*   next time it's drawn */
+
+/* Inits the residency manager */
+u8 ST_ResidencyInit(void);
+
+/* Frees all bookkeeping. Spritesheets themselves are left alone */
+u8 ST_ResidencyFini(void);
+
+/* Sets the texture memory budget in bytes (0 = no limit) */
+/*   Evicts right away if more than that is in use */
+void ST_ResidencySetBudget(u32 bytes);
+
+/* Returns the texture memory budget in bytes */
+u32 ST_ResidencyGetBudget(void);
+
+/* Returns the bytes of texture data currently loaded */
+u32 ST_ResidencyUsed(void);
+
+/* Starts tracking a spritesheet */
+/* Takes a pointer to a spritesheet and where it was loaded from */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencyAdd(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source);
+
+/* Stops tracking a spritesheet */
+/* Takes a pointer to a spritesheet */
+void ST_ResidencyRemove(st_spritesheet *spritesheet);
+
+/* Returns the bookkeeping of a spritesheet or NULL if it isn't tracked */
+/* Takes a pointer to a spritesheet */
+st_residency *ST_ResidencyGet(st_spritesheet *spritesheet);
+
+/* Marks a spritesheet as drawn this frame, reloading it if needed */
+/* Takes a pointer to a spritesheet */
+/* Returns 1 if the spritesheet is loaded and 0 if it couldn't be */
+u8 ST_ResidencyTouch(st_spritesheet *spritesheet);
+
+/* Same as ST_ResidencyTouch, but also counts how many texels the draw */
+/*   covers so hot spritesheets can be moved to VRAM */
+/*   The ST_Render functions call this for you */
+/* Takes a pointer to a spritesheet and number of texels drawn */
+/* Returns 1 if the spritesheet is loaded and 0 if it couldn't be */
+u8 ST_ResidencyTouchSampled(st_spritesheet *spritesheet, u32 texels);
+
+/* Frees the texture data of a spritesheet until it's drawn again */
+/*   Spritesheets drawn in the last two frames are never evicted */
+/* Takes a pointer to a spritesheet */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencyEvict(st_spritesheet *spritesheet);
+
+/* Returns 1 if a spritesheet's texture data is loaded and 0 if not */
+/* Takes a pointer to a spritesheet */
+u8 ST_ResidencyIsResident(st_spritesheet *spritesheet);
+
+/* Evicts least recently drawn spritesheets until no more than the given */
+/*   number of bytes are in use, or nothing else can be evicted */
+/* Takes a number of bytes */
+/* Returns number of bytes freed */
+u32 ST_ResidencyTrim(u32 bytes);
+
+/* Moves on to the next frame */
+/*   Must only be called once the previous frame is done drawing, since */
+/*   textures it drew can be evicted afterward. ST_RenderEndRender calls */
+/*   it at the right time */
+void ST_ResidencyFrame(void);
+
+/* Changes the placement hint of a spritesheet */
+/*   ST_PLACE_RAM and ST_PLACE_VRAM move it at the end of the frame, */
+/*   since textures can't be moved while a frame is being drawn */
+/* Takes a pointer to a spritesheet and a placement */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencySetPlacement(st_spritesheet *spritesheet,
+  st_placement placement);
+
+/* Moves automatically placed spritesheets between RAM and VRAM */
+/*   The most sampled ones over the last window get the free VRAM, the */
+/*   rest go back to RAM. Only does work once per placement window, and */
+/*   on the frames after, promoting what's left once demoted data the GPU */
+/*   may still read is freed. Also makes the moves asked for by */
+/*   ST_ResidencySetPlacement and by reloads. */
+/*   Must only be called while nothing is recording GPU commands, */
+/*   ST_RenderEndRender calls it at the right time */
+void ST_ResidencyPlace(void);
+
+/* Returns the current frame number */
+u32 ST_ResidencyFrameCount(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,6 +19,7 @@ extern "C"{
 /* more easily and safely update */
 #include <sf2d.h>
 #include <sfil.h>
+#include <spritetools/spritetools_texture.h>
 
 /*******************************\
 |*     Spritesheet Defines     *|
@@ -33,19 +34,131 @@ extern "C"{
   unsigned char pixel_data[];\
 }
 
+/*****************************\
+|*     Spritesheet Types     *|
+\*****************************/
+/* Kind of data a spritesheet was loaded from */
+typedef enum {
+  ST_SOURCE_NONE, /* Can't be reloaded */
+  ST_SOURCE_RGBA8,
+  ST_SOURCE_PNG,
+  ST_SOURCE_BMP,
+  ST_SOURCE_JPEG,
+  ST_SOURCE_TEXTURE, /* Converted texture made by tools/sttexconv */
+  ST_SOURCE_ARCHIVE /* Entry of an st_archive */
+} st_sourcetype;
+
+/* Where a spritesheet's texture data should live */
+typedef enum {
+  ST_PLACE_AUTO, /* Starts in RAM and moves to VRAM when it's sampled a lot */
+  ST_PLACE_RAM, /* Always linear RAM */
+  ST_PLACE_VRAM /* Always VRAM */
+} st_placement;
+
+/* Where the pixels of a spritesheet came from, so it can be reloaded */
+/*   The buffer is not copied and must stay valid until the spritesheet */
+/*   is freed */
+/*   For ARCHIVE, the buffer is the st_archive and must stay open */
+/*   A PNG's size can be 0 if it isn't known, but then it isn't cached */
+typedef struct {
+  st_sourcetype type;
+  const void *buffer;
+  unsigned long size; /* Size for JPEG and PNG, entry index for ARCHIVE */
+  unsigned int width; /* Only used by RGBA8 */
+  unsigned int height; /* Only used by RGBA8 */
+  st_placement placement;
+  unsigned int format; /* Only used by RGBA8, st_texformat to convert to */
+} st_spritesheetsource;
+
+/* Source decoded into ordinary memory, ready to be made into a texture */
+typedef struct {
+  st_spritesheetsource source; /* RGBA8 for images */
+  void *pixels; /* Memory the decoded source owns, or NULL */
+} st_decodedsource;
+
 /*********************************\
 |*     Spritesheet Functions     *|
 \*********************************/
+/* The loaders that take a buffer directly don't keep it: it can be freed */
+/*   once they return, and their spritesheets are never evicted */
+
 /* Load spritesheet from image as a C file */
 /* Takes image */
 /* Returns pointer to st_spritesheet */
 st_spritesheet *ST_SpritesheetCreateSpritesheet(const unsigned char *pixel_data,
     unsigned int width, unsigned int height);
 
+/* Load spritesheet from image, converting it to a smaller texel format */
+/*   Halves the memory the texture takes in exchange for color depth */
+/* Takes image and format (ST_TEXFMT_RGB565, RGB5A1 or RGBA4) */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetFormat(
+  const unsigned char *pixel_data, unsigned int width, unsigned int height,
+  st_texformat format);
+
 /* Free spritesheet */
+/*   Shared spritesheets are only freed when the last reference is */
 /* Takes st_spritesheet */
 void ST_SpritesheetFreeSpritesheet(st_spritesheet *spritesheet);
 
+/* Load spritesheet from a source with a placement hint */
+/*   The spritesheet may be evicted to make room and later reloaded from */
+/*   the source, so its buffer must stay valid until it's freed */
+/*   Loading the same content again, even from another buffer, returns the */
+/*   same spritesheet. Each load must be matched by a free. A load asking */
+/*   for ST_PLACE_VRAM moves a shared spritesheet to VRAM, while other */
+/*   hints leave it where the earlier loads put it */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetSource(
+  const st_spritesheetsource *source);
+
+/* Hands a spritesheet made by ST_SpritesheetLoadSource to the cache and */
+/*   the residency manager, and moves it where its placement hint wants it */
+/*   If the same content was loaded in the meantime, the new spritesheet */
+/*   is freed and the cached one is returned with another reference */
+/* Takes st_spritesheet and pointer to the source it was loaded from */
+/* Returns pointer to the st_spritesheet to use */
+st_spritesheet *ST_SpritesheetTrackSource(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source);
+
+/* Same as ST_SpritesheetTrackSource, but the source's buffer isn't kept */
+/*   The buffer can be freed afterward and the spritesheet is never evicted */
+/* Takes st_spritesheet and pointer to the source it was loaded from */
+/* Returns pointer to the st_spritesheet to use */
+st_spritesheet *ST_SpritesheetTrackBorrowed(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source);
+
+/* Finds a spritesheet already loaded from the same content as a source */
+/*   It's moved to VRAM if the source asks for ST_PLACE_VRAM */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet with another reference, or NULL */
+st_spritesheet *ST_SpritesheetCacheFind(const st_spritesheetsource *source);
+
+/* Returns how many loads share a spritesheet */
+/* Takes st_spritesheet */
+u32 ST_SpritesheetReferences(st_spritesheet *spritesheet);
+
+/* Decodes a source into a new spritesheet without tracking it */
+/*   Used by the loaders below, the residency manager and the loader, */
+/*   so it must not touch anything but the new texture */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet or NULL on failure */
+st_spritesheet *ST_SpritesheetLoadSource(const st_spritesheetsource *source);
+
+/* Decodes a source into ordinary memory without making a texture */
+/*   Images come out as RGBA8 pixels and archive entries are read in, so */
+/*   ST_SpritesheetLoadSource only has to copy the result into a texture. */
+/*   Touches nothing shared, so it can run on any thread */
+/* Takes pointer to a source and pointer to where to put the result */
+/* Returns 1 on success and 0 on failure */
+u8 ST_SpritesheetDecodeSource(const st_spritesheetsource *source,
+  st_decodedsource *decoded);
+
+/* Frees the memory a decoded source owns */
+/* Takes pointer to a decoded source */
+void ST_SpritesheetFreeDecoded(st_decodedsource *decoded);
+
 /**********************************\
 |*     SFILLIB Implimentation     *|
 \**********************************/
@@ -68,6 +181,20 @@ st_spritesheet *ST_SpritesheetCreateSpritesheetBMP(const void *buffer);
 /* Returns pointer to st_spritesheet */
 st_spritesheet *ST_SpritesheetCreateSpritesheetJPEG(const void *buffer, unsigned long buffer_size);
 
+/******************************************\
+|*     Converted Texture Spritesheets     *|
+\******************************************/
+/* Textures converted ahead of time with tools/sttexconv can be RGBA4, */
+/*   RGB5A1, RGB565, ETC1, or ETC1A4, which take a half to an eighth of the */
+/*   memory of RGBA8. No image decoding is done when loading them, and */
+/*   since the tool writes texels in the GPU's tiled order they're copied */
+/*   straight into the texture instead of being swizzled one at a time */
+
+/* Load spritesheet from a converted texture */
+/* Takes buffer */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetTexture(const void *buffer);
+
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,146 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_statemachine_h
+
+#define __spritetools_statemachine_h
+
+#include <spritetools/spritetools_entity.h>
+
+/* Transitions added with this as their source can be taken from any state */
+#define ST_STATE_ANY 0xFF
+
+/* Tests a transition's condition can make */
+/*   The parameter is compared against the transition's value, except for */
+/*   ST_STATE_LOOP_END which is met once the state's animation shows its */
+/*   last frame for the last time before looping */
+typedef enum {
+  ST_STATE_EQUAL,
+  ST_STATE_NOT_EQUAL,
+  ST_STATE_LESS,
+  ST_STATE_LESS_EQUAL,
+  ST_STATE_GREATER,
+  ST_STATE_GREATER_EQUAL,
+  ST_STATE_LOOP_END
+} st_statecondition;
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Transition from one state to another */
+typedef struct {
+  u8 from; /* Source state, or ST_STATE_ANY */
+  u8 to;
+  u8 param;
+  u8 condition; /* st_statecondition */
+  float value;
+} st_statetransition;
+
+/* State machine shared by any number of entities */
+/*   States map to animation ids of the entities using the machine. */
+/*   Transitions are compiled into one table grouped by source state, so */
+/*   ST_StateMachineUpdate only looks at the transitions of each entity's */
+/*   current state. Entities' states and parameters are kept in arrays */
+/*   next to each other rather than in the entities */
+typedef struct {
+  u8 stateCount;
+  u8 paramCount;
+  u8 *animations; /* Animation id of each state */
+  st_statetransition *transitions; /* In the order they were added */
+  u16 transitionCount;
+  u16 transitionCapacity;
+  st_statetransition *table; /* Compiled transitions */
+  u16 *first; /* Where each state's transitions start in the table */
+  u8 dirty; /* Transitions changed since the table was compiled */
+  st_entity **entities; /* NULL for free slots */
+  u8 *states;
+  float *params; /* paramCount for each entity */
+  u16 instanceCount;
+  u16 instanceCapacity;
+} st_statemachine;
+
+/***********************************\
+|*     State Machine Functions     *|
+\***********************************/
+/* Returns a pointer to a state machine */
+/*   Returns NULL if failed */
+/* Takes the number of states and number of parameters */
+/*   State i plays animation i until set otherwise */
+st_statemachine *ST_StateMachineCreate(u8 stateCount, u8 paramCount);
+
+/* Frees a state machine from memory */
+/*   Its entities are not freed */
+/* Takes a pointer to a state machine */
+void ST_StateMachineFree(st_statemachine *machine);
+
+/* Sets the animation a state plays */
+/* Takes a pointer to a state machine, a state and an animation id */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineSetAnimation(st_statemachine *machine, u8 state,
+  u8 animation);
+
+/* Adds a transition */
+/*   When several transitions of a state are met, the first one added wins. */
+/*   Transitions from a state come before ones from ST_STATE_ANY */
+/* Takes a pointer to a state machine, source state (or ST_STATE_ANY), */
+/*   destination state, parameter, condition and value to compare with */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineAddTransition(st_statemachine *machine, u8 from, u8 to,
+  u8 param, st_statecondition condition, float value);
+
+/* Builds the transition table */
+/*   ST_StateMachineUpdate does this itself when transitions changed */
+/* Takes a pointer to a state machine */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineCompile(st_statemachine *machine);
+
+/* Adds an entity to a state machine */
+/*   Its parameters start at 0 and its animation is set to the state's */
+/* Takes a pointer to a state machine, a pointer to an entity and a state */
+/* Returns the entity's instance id, or -1 on failure */
+s32 ST_StateMachineAttach(st_statemachine *machine, st_entity *entity,
+  u8 state);
+
+/* Removes an entity from a state machine */
+/*   Its instance id can be handed out again */
+/* Takes a pointer to a state machine and an instance id */
+void ST_StateMachineDetach(st_statemachine *machine, s32 instance);
+
+/* Sets a parameter of an entity */
+/* Takes a pointer to a state machine, instance id, parameter and value */
+void ST_StateMachineSetParam(st_statemachine *machine, s32 instance,
+  u8 param, float value);
+
+/* Returns a parameter of an entity */
+/* Takes a pointer to a state machine, instance id and parameter */
+float ST_StateMachineGetParam(st_statemachine *machine, s32 instance,
+  u8 param);
+
+/* Moves an entity to a state without a transition */
+/*   The state's animation starts over */
+/* Takes a pointer to a state machine, instance id and state */
+void ST_StateMachineSetState(st_statemachine *machine, s32 instance,
+  u8 state);
+
+/* Returns the state of an entity */
+/* Takes a pointer to a state machine and instance id */
+u8 ST_StateMachineGetState(st_statemachine *machine, s32 instance);
+
+/* Takes at most one transition for every entity of a state machine */
+/*   Entities that change state start their new state's animation over */
+/*   Call once per update, before rendering */
+/* Takes a pointer to a state machine */
+void ST_StateMachineUpdate(st_statemachine *machine);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_texture_h
+
+#define __spritetools_texture_h
+
+/* This header is shared with the host tools in tools/, so it can't */
+/*   depend on anything from the 3DS toolchain */
+#ifdef _3DS
+#include <3ds/types.h>
+#else
+#include <stdint.h>
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int16_t s16;
+typedef int32_t s32;
+#endif
+
+/*************************************\
+|*     Converted Texture Defines     *|
+\*************************************/
+/* Identifies a converted texture ("STTX" read as a little endian u32) */
+#define ST_TEXTURE_MAGIC 0x58545453
+
+/* Version of the converted texture layout */
+#define ST_TEXTURE_VERSION 1
+
+/* Texel data is already in the GPU's tiled order and can just be copied */
+/*   ETC1 and ETC1A4 textures are always tiled */
+#define ST_TEXTURE_TILED 0x1
+
+/* Texel formats. These match sf2d's texfmt values */
+typedef enum {
+  ST_TEXFMT_RGBA8 = 0,
+  ST_TEXFMT_RGB5A1 = 2,
+  ST_TEXFMT_RGB565 = 3,
+  ST_TEXFMT_RGBA4 = 4,
+  ST_TEXFMT_ETC1 = 12,
+  ST_TEXFMT_ETC1A4 = 13
+} st_texformat;
+
+/* Header at the start of a converted texture, followed by its texel data */
+/*   All values are little endian. The data starts 32 bytes in */
+typedef struct {
+  u32 magic; /* ST_TEXTURE_MAGIC */
+  u16 version; /* ST_TEXTURE_VERSION */
+  u16 format; /* st_texformat */
+  u16 width; /* Size of the image */
+  u16 height;
+  u16 pow2Width; /* Size of the texel data (powers of 2, at least 8) */
+  u16 pow2Height;
+  u32 flags;
+  u32 dataSize; /* Bytes of texel data */
+  u32 reserved[2];
+} st_textureheader;
+
+/* Returns the number of bits each texel of a format takes */
+/*   Returns 0 for unknown formats */
+static inline u32 ST_TextureFormatBits(u16 format)
+{
+  switch (format)
+  {
+    case ST_TEXFMT_RGBA8:
+      return 32;
+    case ST_TEXFMT_RGB5A1:
+    case ST_TEXFMT_RGB565:
+    case ST_TEXFMT_RGBA4:
+      return 16;
+    case ST_TEXFMT_ETC1A4:
+      return 8;
+    case ST_TEXFMT_ETC1:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
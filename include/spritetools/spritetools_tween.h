@@ -0,0 +1,136 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_tween_h
+
+#define __spritetools_tween_h
+
+#include <spritetools/spritetools_entity.h>
+
+/* Number of steps each easing curve is sampled at */
+#define ST_TWEEN_LUT_SIZE 256
+
+/* Entity values a tween can change */
+typedef enum {
+  ST_TWEEN_X,
+  ST_TWEEN_Y,
+  ST_TWEEN_SCALE,
+  ST_TWEEN_ROTATION,
+  ST_TWEEN_RED,
+  ST_TWEEN_GREEN,
+  ST_TWEEN_BLUE,
+  ST_TWEEN_ALPHA
+} st_tweenproperty;
+
+/* Easing curves */
+typedef enum {
+  ST_EASE_LINEAR,
+  ST_EASE_QUAD_IN,
+  ST_EASE_QUAD_OUT,
+  ST_EASE_QUAD_IN_OUT,
+  ST_EASE_CUBIC_IN,
+  ST_EASE_CUBIC_OUT,
+  ST_EASE_CUBIC_IN_OUT,
+  ST_EASE_SINE_IN,
+  ST_EASE_SINE_OUT,
+  ST_EASE_SINE_IN_OUT,
+  ST_EASE_BACK_OUT,
+  ST_EASE_BOUNCE_OUT,
+  ST_EASE_COUNT
+} st_tweenease;
+
+/* What a tween does once it reaches its end */
+typedef enum {
+  ST_TWEEN_ONCE, /* Stops */
+  ST_TWEEN_LOOP, /* Starts over */
+  ST_TWEEN_PINGPONG /* Plays back to the start, then forward again */
+} st_tweenrepeat;
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Set of running tweens */
+/*   Each value of a tween has its own array so ST_TweenUpdate streams */
+/*   through them in one pass. Finished tweens are swapped out with the */
+/*   last one, so tweens don't keep their place */
+typedef struct {
+  st_entity **entities;
+  u8 *properties; /* st_tweenproperty */
+  u8 *eases; /* st_tweenease */
+  u8 *repeats; /* st_tweenrepeat */
+  float *starts;
+  float *deltas; /* End minus start */
+  float *elapsed; /* ms */
+  float *rates; /* 1 / duration in ms */
+  u32 count;
+  u32 capacity;
+} st_tweener;
+
+/***************************\
+|*     Tween Functions     *|
+\***************************/
+/* Returns a pointer to a set of tweens */
+/*   Returns NULL if failed */
+/* Takes the number of tweens to make room for (more are added as needed) */
+st_tweener *ST_TweenCreate(u32 capacity);
+
+/* Frees a set of tweens from memory */
+/*   The entities are not freed */
+/* Takes a pointer to a set of tweens */
+void ST_TweenFree(st_tweener *tweener);
+
+/* Starts tweening a value of an entity */
+/*   Replaces any tween already running on the same value */
+/* Takes a pointer to a set of tweens, a pointer to an entity, the value */
+/*   to change, its start and end, duration in ms, easing and repeat mode */
+/* Returns 1 on success and 0 on failure */
+u8 ST_TweenStart(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property, float start, float end, float duration,
+  st_tweenease ease, st_tweenrepeat repeat);
+
+/* Starts tweening a value of an entity from where it is now */
+/* Takes a pointer to a set of tweens, a pointer to an entity, the value */
+/*   to change, its end, duration in ms, easing and repeat mode */
+/* Returns 1 on success and 0 on failure */
+u8 ST_TweenTo(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property, float end, float duration,
+  st_tweenease ease, st_tweenrepeat repeat);
+
+/* Stops the tween on a value of an entity, leaving the value as it is */
+/* Takes a pointer to a set of tweens, a pointer to an entity and a value */
+/* Returns 1 if a tween was stopped and 0 if there wasn't one */
+u8 ST_TweenStop(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property);
+
+/* Stops every tween on an entity */
+/*   Call this before freeing an entity that's being tweened */
+/* Takes a pointer to a set of tweens and a pointer to an entity */
+void ST_TweenStopEntity(st_tweener *tweener, st_entity *entity);
+
+/* Returns 1 if a value of an entity is being tweened and 0 if not */
+/* Takes a pointer to a set of tweens, a pointer to an entity and a value */
+u8 ST_TweenActive(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property);
+
+/* Advances every tween and writes the results to the entities */
+/*   Tweens that reach their end are set to it and removed */
+/* Takes a pointer to a set of tweens and the time that passed in ms */
+void ST_TweenUpdate(st_tweener *tweener, double ms);
+
+/* Returns an easing curve at a point */
+/*   Read from the same table the tweens use */
+/* Takes an easing and how far along (0.0 to 1.0) */
+float ST_TweenEase(st_tweenease ease, float t);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifndef __spritetools_viewport_h
+
+#define __spritetools_viewport_h
+
+#include <3ds.h>
+#include <spritetools/spritetools_entity.h>
+#include <spritetools/spritetools_camera.h>
+
+/* Extra space in pixels around a viewport where entities are still drawn */
+/*   Shrinks as the governor lowers the quality level */
+#define ST_VIEWPORT_CULL_MARGIN 16.0
+
+/********************\
+|*     Typedefs     *|
+\********************/
+/* Entity that passed culling, already moved into the viewport's space */
+typedef struct {
+  st_entity *entity;
+  float x, y; /* Position on screen */
+  float distance; /* Distance from the camera in world units */
+} st_viewportdraw;
+
+/* Rectangle of a screen that shows the world through a camera */
+typedef struct {
+  gfxScreen_t screen;
+  s16 x, y; /* Top left of the viewport on its screen */
+  u16 width, height;
+  st_camera *camera;
+  u8 scissor; /* Clip drawing to the viewport */
+  u8 rotateSprites; /* Rotate sprites with the camera */
+  st_viewportdraw *draws; /* Filled by ST_ViewportCull */
+  u32 drawCount;
+  u32 drawCapacity;
+} st_viewport;
+
+/******************************\
+|*     Viewport Functions     *|
+\******************************/
+/* Returns a pointer to a viewport */
+/*   Returns NULL if failed */
+/* Takes the screen, the rectangle on it, and the camera to view through */
+st_viewport *ST_ViewportCreate(gfxScreen_t screen, s16 x, s16 y,
+  u16 width, u16 height, st_camera *cam);
+
+/* Frees a viewport from memory */
+/*   The camera is not freed */
+/* Takes a pointer to a viewport */
+void ST_ViewportFree(st_viewport *viewport);
+
+/* Moves and resizes a viewport */
+/* Takes a pointer to a viewport and the new rectangle */
+void ST_ViewportSetRect(st_viewport *viewport, s16 x, s16 y,
+  u16 width, u16 height);
+
+/* Sets the camera of a viewport */
+/* Takes a pointer to a viewport and a pointer to a camera */
+void ST_ViewportSetCamera(st_viewport *viewport, st_camera *cam);
+
+/* Turns clipping to the viewport's rectangle on (1) or off (0) */
+/* Takes a pointer to a viewport and the state to set */
+void ST_ViewportSetScissor(st_viewport *viewport, u8 state);
+
+/* Turns rotating sprites with the camera on (1) or off (0) */
+/* Takes a pointer to a viewport and the state to set */
+void ST_ViewportSetRotateSprites(st_viewport *viewport, u8 state);
+
+/* Builds the draw lists of several viewports in one pass over entities */
+/*   Each viewport's list holds only the entities it can see. Every */
+/*   entity's animation is also stepped once here, seen or not, so call */
+/*   this once a frame */
+/* Takes a list of viewports, number of viewports, a list of entities, */
+/*   and number of entities */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ViewportCull(st_viewport **viewports, u8 viewportCount,
+  st_entity **entities, u32 entityCount);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,6 +20,12 @@ u8 ST_Init(void)
     return 0;
   if (!ST_CollisionInit())
     return 0;
+  if (!ST_GovernorInit())
+    return 0;
+  if (!ST_ResidencyInit())
+    return 0;
+  if (!ST_LoaderInit())
+    return 0;
 
   return 1;
 }
@@ -30,8 +36,14 @@ u8 ST_Fini(void)
 {
   if (!ST_DebugFini())
     return 0;
+  if (!ST_LoaderFini())
+    return 0;
   if (!ST_RenderFini())
     return 0;
+  if (!ST_ResidencyFini())
+    return 0;
+  if (!ST_AnimationFini())
+    return 0;
 
   return 1;
 }
@@ -7,6 +7,127 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include "spritetools/spritetools_animation.h"
+#include "spritetools/spritetools_pixel.h"
+
+/* Number of fired events a new event buffer has room for */
+#define ST_EVENT_BUFFER_START 64
+
+/* Events fired since the last drain go into st_eventBuffers[st_eventWrite] */
+/*   and the other buffer holds what the last drain handed out */
+static st_firedevent *st_eventBuffers[2];
+static u32 st_eventCounts[2];
+static u32 st_eventCapacities[2];
+static u8 st_eventWrite = 0;
+
+/* Adds an event to the buffer of fired events */
+static void fireEvent(st_animation *animation, const st_animationevent *event)
+{
+  st_firedevent *fired;
+  u8 b = st_eventWrite;
+
+  if (st_eventCounts[b] >= st_eventCapacities[b])
+  {
+    u32 capacity = st_eventCapacities[b] ?
+      st_eventCapacities[b] * 2 : ST_EVENT_BUFFER_START;
+    st_firedevent *events = realloc(st_eventBuffers[b],
+      capacity * sizeof(st_firedevent));
+    if (!events)
+      return;
+    st_eventBuffers[b] = events;
+    st_eventCapacities[b] = capacity;
+  }
+
+  fired = &st_eventBuffers[b][st_eventCounts[b]++];
+  fired->animation = animation;
+  fired->data = animation->eventData;
+  fired->frame = event->frame;
+  fired->id = event->id;
+}
+
+/* Returns nonzero if a texel of a spritesheet isn't fully transparent */
+/*   The spritesheet must be tiled and have an alpha channel */
+static u8 texelVisible(st_spritesheet *spritesheet, u32 x, u32 y)
+{
+  u32 offset = ST_PixelTiledOffset(x, spritesheet->tex.height - 1 - y,
+    spritesheet->tex.width);
+
+  switch (spritesheet->pixel_format)
+  {
+    case ST_TEXFMT_RGBA8:
+      return ((u8 *)spritesheet->tex.data)[offset * 4];
+    case ST_TEXFMT_RGBA4:
+      return ((u16 *)spritesheet->tex.data)[offset] & 0xF;
+    default:
+      return ((u16 *)spritesheet->tex.data)[offset] & 0x1;
+  }
+}
+
+/* Returns nonzero if texelVisible can read a spritesheet */
+static u8 texelsReadable(st_spritesheet *spritesheet)
+{
+  if (!spritesheet || !spritesheet->tex.data || !spritesheet->tiled)
+    return 0;
+  switch (spritesheet->pixel_format)
+  {
+    case ST_TEXFMT_RGBA8:
+    case ST_TEXFMT_RGBA4:
+    case ST_TEXFMT_RGB5A1:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/* Returns nonzero if any texel in a rectangle of a spritesheet is visible */
+static u8 rectVisible(st_spritesheet *spritesheet, u32 left, u32 top,
+  u32 width, u32 height)
+{
+  u32 x, y;
+
+  for (y = top; y < top + height; y++)
+    for (x = left; x < left + width; x++)
+      if (texelVisible(spritesheet, x, y))
+        return 1;
+  return 0;
+}
+
+/* Fills in a frame and its cached values */
+static void initFrame(st_frame *frame, st_spritesheet *spritesheet,
+  u32 xleft, u32 ytop, u32 width, u32 height, s32 xoff, s32 yoff)
+{
+  frame->spritesheet = spritesheet;
+  frame->xleft = xleft;
+  frame->ytop = ytop;
+  frame->width = width;
+  frame->height = height;
+  frame->sourceWidth = width;
+  frame->sourceHeight = height;
+  frame->xoff = xoff;
+  frame->yoff = yoff;
+  ST_AnimationFrameRefresh(frame);
+}
+
+/* Returns an animation with room for its frame pointers in the same */
+/*   allocation, for animations of frames that belong to something else */
+static st_animation *createSharedAnimation(s16 fpf, u16 loopFrame,
+  u16 length)
+{
+  st_animation *animation;
+
+  if (!length)
+    return NULL;
+  animation = calloc(1, sizeof(st_animation) + length * sizeof(st_frame *));
+  if (!animation)
+    return NULL;
+
+  animation->fpf = fpf;
+  animation->loopFrame = loopFrame < length ? loopFrame : length - 1;
+  animation->length = length;
+  animation->frames = (st_frame **)(animation + 1);
+  animation->shared = ST_ANIMATION_SHARED_FRAMES | ST_ANIMATION_SHARED_LIST;
+
+  return animation;
+}
 
 /***************************\
 |*     Frame Functions     *|
@@ -23,13 +144,7 @@ st_frame *ST_AnimationCreateFrame(st_spritesheet *spritesheet,
   if (!tempframe)
     return 0;
 
-  tempframe->spritesheet = spritesheet;
-  tempframe->xleft = xleft;
-  tempframe->ytop = ytop;
-  tempframe->width = width;
-  tempframe->height = height;
-  tempframe->xoff = 0;
-  tempframe->yoff = 0;
+  initFrame(tempframe, spritesheet, xleft, ytop, width, height, 0, 0);
 
   return tempframe;
 }
@@ -49,13 +164,7 @@ st_frame *ST_AnimationCreateFrameOffset(st_spritesheet *spritesheet,
   if (!tempframe)
     return 0;
 
-  tempframe->spritesheet = spritesheet;
-  tempframe->xleft = xleft;
-  tempframe->ytop = ytop;
-  tempframe->width = width;
-  tempframe->height = height;
-  tempframe->xoff = xoff;
-  tempframe->yoff = yoff;
+  initFrame(tempframe, spritesheet, xleft, ytop, width, height, xoff, yoff);
 
   return tempframe;
 }
@@ -67,6 +176,168 @@ void ST_AnimationFreeFrame(st_frame *frame)
   free(frame);
 }
 
+/* Recalculates the cached texture coordinates and draw size of a frame */
+/* Takes a pointer to a frame */
+void ST_AnimationFrameRefresh(st_frame *frame)
+{
+  /* Rendering is done with even sizes until sf2d is rewritten */
+  frame->drawWidth = (frame->width + 1) / 2 * 2;
+  frame->drawHeight = (frame->height + 1) / 2 * 2;
+
+  if (!frame->spritesheet || !frame->spritesheet->tex.width ||
+    !frame->spritesheet->tex.height)
+  {
+    frame->u0 = frame->v0 = frame->u1 = frame->v1 = 0.0f;
+    return;
+  }
+
+  frame->u0 = frame->xleft / (float)frame->spritesheet->tex.width;
+  frame->v0 = frame->ytop / (float)frame->spritesheet->tex.height;
+  frame->u1 = (frame->xleft + frame->drawWidth) /
+    (float)frame->spritesheet->tex.width;
+  frame->v1 = (frame->ytop + frame->drawHeight) /
+    (float)frame->spritesheet->tex.height;
+}
+
+/* Changes the spritesheet of a frame and refreshes its cached values */
+/* Takes a pointer to a frame and a pointer to a spritesheet */
+void ST_AnimationFrameSetSpritesheet(st_frame *frame,
+  st_spritesheet *spritesheet)
+{
+  frame->spritesheet = spritesheet;
+  ST_AnimationFrameRefresh(frame);
+}
+
+/* Shrinks a frame to the part of it that isn't fully transparent */
+/*   The frame still draws in the same place, it just covers fewer pixels */
+/*   The spritesheet must be loaded and RGBA8, RGBA4, or RGB5A1 */
+/* Takes a pointer to a frame */
+/* Returns 1 if the frame was trimmed, 0 if it couldn't be */
+u8 ST_AnimationFrameTrim(st_frame *frame)
+{
+  st_spritesheet *spritesheet = frame->spritesheet;
+  u32 left, top, right, bottom, x, y, xend, yend, drawWidth, drawHeight;
+
+  if (!texelsReadable(spritesheet))
+    return 0;
+
+  xend = frame->xleft + frame->width;
+  yend = frame->ytop + frame->height;
+  if (xend > spritesheet->width)
+    xend = spritesheet->width;
+  if (yend > spritesheet->height)
+    yend = spritesheet->height;
+
+  left = xend;
+  top = yend;
+  right = bottom = 0;
+  for (y = frame->ytop; y < yend; y++)
+  {
+    for (x = frame->xleft; x < xend; x++)
+    {
+      if (!texelVisible(spritesheet, x, y))
+        continue;
+      if (x < left)
+        left = x;
+      if (x + 1 > right)
+        right = x + 1;
+      if (y < top)
+        top = y;
+      bottom = y + 1;
+    }
+  }
+
+  /* Nothing visible, so nothing to draw */
+  if (left >= right)
+  {
+    frame->width = frame->height = 0;
+    ST_AnimationFrameRefresh(frame);
+    return 1;
+  }
+
+  /* Frames are drawn around their center, so move the center by as much */
+  /*   as the trimmed rectangle's left edge and even-rounded size moved */
+  drawWidth = (right - left + 1) / 2 * 2;
+  drawHeight = (bottom - top + 1) / 2 * 2;
+  frame->trimX += (s32)(left - frame->xleft) +
+    ((s32)drawWidth - (s32)frame->drawWidth) / 2;
+  frame->trimY += (s32)(top - frame->ytop) +
+    ((s32)drawHeight - (s32)frame->drawHeight) / 2;
+
+  frame->xleft = left;
+  frame->ytop = top;
+  frame->width = right - left;
+  frame->height = bottom - top;
+  ST_AnimationFrameRefresh(frame);
+
+  return 1;
+}
+
+/* Cuts a spritesheet into a grid of same sized frames */
+/*   All of the frames are in one array, in order left to right, then top */
+/*   to bottom, and are freed together with ST_AnimationFreeFrames */
+/*   Skipping empty cells needs the spritesheet to be loaded and RGBA8, */
+/*   RGBA4, or RGB5A1, otherwise every cell is kept */
+/* Takes a pointer to a spritesheet, the size of each cell, the space */
+/*   around the grid and between cells, whether to skip cells that are */
+/*   fully transparent, and where to store the number of frames */
+/* Returns the frames, or NULL if failed or no cells fit */
+st_frame *ST_AnimationSliceSpritesheet(st_spritesheet *spritesheet,
+  u32 cellWidth, u32 cellHeight, u32 margin, u32 spacing, u8 skipEmpty,
+  u32 *count)
+{
+  st_frame *frames;
+  u32 columns, rows, column, row, x, y, kept = 0;
+
+  *count = 0;
+  if (!spritesheet || !cellWidth || !cellHeight ||
+    spritesheet->width < margin * 2 + cellWidth ||
+    spritesheet->height < margin * 2 + cellHeight)
+    return NULL;
+
+  columns = (spritesheet->width - margin * 2 + spacing) /
+    (cellWidth + spacing);
+  rows = (spritesheet->height - margin * 2 + spacing) /
+    (cellHeight + spacing);
+  frames = calloc(columns * rows, sizeof(st_frame));
+  if (!frames)
+    return NULL;
+  if (skipEmpty && !texelsReadable(spritesheet))
+    skipEmpty = 0;
+
+  /* Skipped cells leave room unused at the end rather than costing */
+  /*   another allocation to shrink the array */
+  for (row = 0; row < rows; row++)
+  {
+    y = margin + row * (cellHeight + spacing);
+    for (column = 0; column < columns; column++)
+    {
+      x = margin + column * (cellWidth + spacing);
+      if (skipEmpty && !rectVisible(spritesheet, x, y, cellWidth, cellHeight))
+        continue;
+      initFrame(&frames[kept++], spritesheet, x, y, cellWidth, cellHeight,
+        0, 0);
+    }
+  }
+
+  if (!kept)
+  {
+    free(frames);
+    return NULL;
+  }
+  *count = kept;
+
+  return frames;
+}
+
+/* Frees an array of frames from ST_AnimationSliceSpritesheet */
+/*   Animations using them must be freed first */
+/* Takes a pointer to the frames */
+void ST_AnimationFreeFrames(st_frame *frames)
+{
+  free(frames);
+}
+
 /*******************************\
 |*     Animation Functions     *|
 \*******************************/
@@ -108,13 +379,59 @@ st_animation *ST_AnimationCreateAnimation(s16 fpf, u16 loopFrame,
   return tempanim;
 }
 
+/* Returns a pointer to an animation of consecutive frames in an array */
+/*   The frames aren't freed with the animation */
+/*   Returns NULL if failed */
+/* Takes speed of animation (in frames between each frame of animation) */
+/*   Takes frame to loop to when the animation has reached its end */
+/*   Takes the array of frames, the first to use and how many */
+st_animation *ST_AnimationCreateAnimationRange(s16 fpf, u16 loopFrame,
+  st_frame *frames, u32 first, u16 length)
+{
+  st_animation *animation = createSharedAnimation(fpf, loopFrame, length);
+  u16 i;
+
+  if (!animation)
+    return NULL;
+  for (i = 0; i < length; i++)
+    animation->frames[i] = &frames[first + i];
+
+  return animation;
+}
+
+/* Returns a pointer to an animation of frames in an array, picked by index */
+/*   The frames aren't freed with the animation */
+/*   Returns NULL if failed */
+/* Takes speed of animation (in frames between each frame of animation) */
+/*   Takes frame to loop to when the animation has reached its end */
+/*   Takes the array of frames, indices into it and how many there are */
+st_animation *ST_AnimationCreateAnimationIndices(s16 fpf, u16 loopFrame,
+  st_frame *frames, const u16 *indices, u16 length)
+{
+  st_animation *animation = createSharedAnimation(fpf, loopFrame, length);
+  u16 i;
+
+  if (!animation)
+    return NULL;
+  for (i = 0; i < length; i++)
+    animation->frames[i] = &frames[indices[i]];
+
+  return animation;
+}
+
 /* Frees an animation and all of its frames from memory */
+/*   Frames it shares with something else are left alone */
 /* Takes a pointer to an animation */
 void ST_AnimationFreeAnimation(st_animation *animation)
 {
   u16 i;
-  for (i = 0; i < animation->length; i++)
-    ST_AnimationFreeFrame(animation->frames[i]);
+  if (!(animation->shared & ST_ANIMATION_SHARED_FRAMES))
+    for (i = 0; i < animation->length; i++)
+      ST_AnimationFreeFrame(animation->frames[i]);
+  if (!(animation->shared & ST_ANIMATION_SHARED_LIST))
+    free(animation->frames);
+  if (!(animation->shared & ST_ANIMATION_SHARED_EVENTS))
+    free(animation->events);
   free(animation);
 }
 
@@ -132,6 +449,7 @@ void ST_AnimationNextFrame(st_animation *animation)
   animation->currentFrame++;
   if (animation->currentFrame >= animation->length)
     animation->currentFrame = 0;
+  ST_AnimationDispatchEvents(animation);
 }
 
 /* Subs 1 from the current frame of an animation */
@@ -142,6 +460,21 @@ void ST_AnimationPreviousFrame(st_animation *animation)
   animation->currentFrame--;
   if (animation->currentFrame >= animation->length)
     animation->currentFrame = animation->length;
+  ST_AnimationDispatchEvents(animation);
+}
+
+/* Trims every frame of an animation */
+/* Takes a pointer to an animation */
+/* Returns the number of frames trimmed */
+u16 ST_AnimationTrimAnimation(st_animation *animation)
+{
+  u16 i, trimmed = 0;
+
+  for (i = 0; i < animation->length; i++)
+    if (animation->frames[i])
+      trimmed += ST_AnimationFrameTrim(animation->frames[i]);
+
+  return trimmed;
 }
 
 /* Sets the speed (fpf) of an animation */
@@ -150,3 +483,150 @@ void ST_AnimationSetSpeed(st_animation *animation, s16 speed)
 {
   animation->fpf = speed;
 }
+
+/* Moves an animation on by a number of played frames without drawing it */
+/*   Keeps the timing of ST_RenderAnimationPlayAdvanced, showing each */
+/*   frame for fpf + 1 frames, and frames left over after moving onto a */
+/*   new frame count toward the next one */
+/* Takes a pointer to an animation and the number of frames */
+void ST_AnimationStep(st_animation *animation, u16 frames)
+{
+  u32 period = (animation->fpf >= 0 ? animation->fpf : -animation->fpf) + 1;
+  u32 ftn = animation->ftn + frames;
+
+  if (!animation->length)
+    return;
+
+  while (ftn >= period)
+  {
+    ftn -= period;
+    if (animation->fpf >= 0)
+      animation->currentFrame++;
+    else
+      animation->currentFrame--;
+    if (animation->currentFrame >= animation->length)
+      animation->currentFrame = animation->loopFrame;
+    ST_AnimationDispatchEvents(animation);
+  }
+  animation->ftn = ftn;
+}
+
+/****************************\
+|*     Animation Events     *|
+\****************************/
+/* Adds an event to an animation */
+/* Takes a pointer to an animation, the frame it's on, and its id */
+/* Returns 1 on success and 0 on failure */
+u8 ST_AnimationAddEvent(st_animation *animation, u16 frame, u16 id)
+{
+  st_animationevent *events;
+  u16 i;
+
+  if (frame >= animation->length || animation->eventCount == 0xFFFF ||
+    (animation->shared & ST_ANIMATION_SHARED_EVENTS))
+    return 0;
+
+  events = realloc(animation->events,
+    (animation->eventCount + 1) * sizeof(st_animationevent));
+  if (!events)
+    return 0;
+  animation->events = events;
+
+  /* Events on the same frame fire in the order they were added */
+  i = animation->eventCount;
+  while (i && events[i - 1].frame > frame)
+  {
+    events[i] = events[i - 1];
+    i--;
+  }
+  events[i].frame = frame;
+  events[i].id = id;
+  animation->eventCount++;
+  animation->eventCursor = 0;
+
+  return 1;
+}
+
+/* Removes every event from an animation */
+/* Takes a pointer to an animation */
+void ST_AnimationClearEvents(st_animation *animation)
+{
+  if (!(animation->shared & ST_ANIMATION_SHARED_EVENTS))
+    free(animation->events);
+  animation->events = NULL;
+  animation->eventCount = 0;
+  animation->eventCursor = 0;
+}
+
+/* Sets the pointer passed along with an animation's events */
+/* Takes a pointer to an animation and a pointer to pass along */
+void ST_AnimationSetEventData(st_animation *animation, void *data)
+{
+  animation->eventData = data;
+}
+
+/* Fires the events on the current frame of an animation */
+/*   Done for you when playback moves onto a frame */
+/* Takes a pointer to an animation */
+void ST_AnimationDispatchEvents(st_animation *animation)
+{
+  const st_animationevent *events = animation->events;
+  u16 count = animation->eventCount;
+  u16 frame = animation->currentFrame;
+  u16 cursor = animation->eventCursor, low, high, mid;
+
+  if (!count)
+    return;
+
+  /* Playing forward leaves the cursor on the first event at or after the */
+  /*   new frame. Anything else (looping, reversing, jumps) looks it up */
+  if (cursor > count || (cursor < count && events[cursor].frame < frame) ||
+    (cursor && events[cursor - 1].frame >= frame))
+  {
+    low = 0;
+    high = count;
+    while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (events[mid].frame < frame)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    cursor = low;
+  }
+
+  while (cursor < count && events[cursor].frame == frame)
+    fireEvent(animation, &events[cursor++]);
+  animation->eventCursor = cursor;
+}
+
+/* Returns the events fired since the last call, oldest first */
+/*   They stay valid until the next call */
+/* Takes a pointer to where to store the number of events */
+const st_firedevent *ST_AnimationDrainEvents(u32 *count)
+{
+  u8 b = st_eventWrite;
+
+  *count = st_eventCounts[b];
+  st_eventWrite ^= 1;
+  st_eventCounts[st_eventWrite] = 0;
+
+  return st_eventBuffers[b];
+}
+
+/* Frees the fired event buffers */
+u8 ST_AnimationFini(void)
+{
+  u8 i;
+
+  for (i = 0; i < 2; i++)
+  {
+    free(st_eventBuffers[i]);
+    st_eventBuffers[i] = NULL;
+    st_eventCounts[i] = 0;
+    st_eventCapacities[i] = 0;
+  }
+
+  return 1;
+}
@@ -0,0 +1,381 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spritetools/spritetools_animfile.h"
+
+/* Most records of any one kind, which keeps all of the size math in u32 */
+#define ST_ANIMFILE_MAX_RECORDS 0x100000
+
+/* Largest strings section */
+#define ST_ANIMFILE_MAX_STRINGS 0x1000000
+
+/* Rounds a size up so every part of the block stays 8 byte aligned */
+#define ST_ANIMFILE_ALIGN(n) (((n) + 7) & ~7)
+
+/* Returns the size of a file from its header, or 0 if it isn't usable */
+static u32 checkHeader(const st_animfileheader *header)
+{
+  if (header->magic != ST_ANIMFILE_MAGIC ||
+    header->version != ST_ANIMFILE_VERSION ||
+    header->sheetCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->frameCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->animationCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->eventCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->setCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->indexCount > ST_ANIMFILE_MAX_RECORDS ||
+    header->stringsSize > ST_ANIMFILE_MAX_STRINGS)
+    return 0;
+
+  return ST_AnimFileSize(header);
+}
+
+/* Returns the bytes of the block that come before the file itself */
+static u32 runtimeSize(const st_animfileheader *header)
+{
+  return ST_ANIMFILE_ALIGN(sizeof(st_animfile)) +
+    ST_ANIMFILE_ALIGN(header->sheetCount * sizeof(st_spritesheet *)) +
+    ST_ANIMFILE_ALIGN(header->frameCount * sizeof(st_frame)) +
+    ST_ANIMFILE_ALIGN(header->indexCount * sizeof(st_frame *)) +
+    ST_ANIMFILE_ALIGN(header->animationCount * sizeof(st_animation));
+}
+
+/* Allocates the block for a file and lays it out */
+/*   Sets data to where the file itself goes */
+static st_animfile *allocate(const st_animfileheader *header, u8 **data)
+{
+  u32 runtime = runtimeSize(header);
+  u8 *block = calloc(1, runtime + ST_AnimFileSize(header));
+  u8 *p = block;
+  st_animfile *file = (st_animfile *)block;
+
+  if (!block)
+    return NULL;
+
+  p += ST_ANIMFILE_ALIGN(sizeof(st_animfile));
+  file->sheets = (st_spritesheet **)p;
+  p += ST_ANIMFILE_ALIGN(header->sheetCount * sizeof(st_spritesheet *));
+  file->frames = (st_frame *)p;
+  p += ST_ANIMFILE_ALIGN(header->frameCount * sizeof(st_frame));
+  file->frameLists = (st_frame **)p;
+  p += ST_ANIMFILE_ALIGN(header->indexCount * sizeof(st_frame *));
+  file->animations = (st_animation *)p;
+  *data = block + runtime;
+
+  return file;
+}
+
+/* Checks that a range of records fits in a section */
+static u8 inRange(u32 first, u32 count, u32 size)
+{
+  return first <= size && count <= size - first;
+}
+
+/* Checks every record of a loaded file and turns indices into pointers */
+/*   Returns 1 if the file is usable, 0 if not */
+static u8 relocate(st_animfile *file, const u8 *data,
+  st_animfileresolve resolve, void *resolveData)
+{
+  const st_animfileheader *header = (const st_animfileheader *)data;
+  const st_animfilesheet *sheets = (const st_animfilesheet *)(header + 1);
+  const st_animfileframe *frames =
+    (const st_animfileframe *)(sheets + header->sheetCount);
+  const st_animfileanimation *animations =
+    (const st_animfileanimation *)(frames + header->frameCount);
+  const st_animfileevent *events =
+    (const st_animfileevent *)(animations + header->animationCount);
+  const st_animfileset *sets =
+    (const st_animfileset *)(events + header->eventCount);
+  const u32 *indices = (const u32 *)(sets + header->setCount);
+  const char *strings = (const char *)(indices + header->indexCount);
+  const st_animfileanimation *record;
+  st_animation *animation;
+  st_frame *frame;
+  u32 i, j;
+
+  file->header = header;
+  file->animationRecords = animations;
+  file->sets = sets;
+  file->indices = indices;
+  file->strings = strings;
+
+  /* Names are only looked up if every one of them ends inside the strings */
+  if (header->stringsSize && strings[header->stringsSize - 1])
+    return 0;
+
+  for (i = 0; i < header->sheetCount; i++)
+  {
+    if (sheets[i].name >= header->stringsSize || !resolve)
+      return 0;
+    file->sheets[i] = resolve(strings + sheets[i].name, resolveData);
+    if (!file->sheets[i])
+      return 0;
+  }
+
+  for (i = 0; i < header->frameCount; i++)
+  {
+    if (frames[i].sheet >= header->sheetCount)
+      return 0;
+    frame = &file->frames[i];
+    frame->spritesheet = file->sheets[frames[i].sheet];
+    frame->xleft = frames[i].xleft;
+    frame->ytop = frames[i].ytop;
+    frame->width = frames[i].width;
+    frame->height = frames[i].height;
+    frame->sourceWidth = frames[i].sourceWidth;
+    frame->sourceHeight = frames[i].sourceHeight;
+    frame->xoff = frames[i].xoff;
+    frame->yoff = frames[i].yoff;
+    frame->trimX = frames[i].trimX;
+    frame->trimY = frames[i].trimY;
+    ST_AnimationFrameRefresh(frame);
+  }
+
+  /* Indices past the frames are animation indices used by sets */
+  for (i = 0; i < header->indexCount; i++)
+    file->frameLists[i] = indices[i] < header->frameCount ?
+      &file->frames[indices[i]] : NULL;
+
+  for (i = 0; i < header->animationCount; i++)
+  {
+    record = &animations[i];
+    if (record->name >= header->stringsSize || !record->length ||
+      record->loopFrame >= record->length ||
+      !inRange(record->frames, record->length, header->indexCount) ||
+      !inRange(record->events, record->eventCount, header->eventCount))
+      return 0;
+    for (j = 0; j < record->length; j++)
+      if (!file->frameLists[record->frames + j])
+        return 0;
+    for (j = 0; j < record->eventCount; j++)
+    {
+      if (events[record->events + j].frame >= record->length ||
+        (j && events[record->events + j].frame <
+        events[record->events + j - 1].frame))
+        return 0;
+    }
+
+    animation = &file->animations[i];
+    animation->fpf = record->fpf;
+    animation->loopFrame = record->loopFrame;
+    animation->length = record->length;
+    animation->frames = &file->frameLists[record->frames];
+    animation->events = (st_animationevent *)&events[record->events];
+    animation->eventCount = record->eventCount;
+    animation->shared = ST_ANIMATION_SHARED_FRAMES |
+      ST_ANIMATION_SHARED_EVENTS | ST_ANIMATION_SHARED_LIST;
+  }
+
+  for (i = 0; i < header->setCount; i++)
+  {
+    if (sets[i].name >= header->stringsSize || sets[i].count > 0xFF ||
+      !inRange(sets[i].animations, sets[i].count, header->indexCount))
+      return 0;
+    for (j = 0; j < sets[i].count; j++)
+      if (indices[sets[i].animations + j] >= header->animationCount)
+        return 0;
+  }
+
+  return 1;
+}
+
+/* Finds spritesheets in the archive an animation file came from */
+static st_spritesheet *archiveResolve(const char *name, void *data)
+{
+  return ST_ArchiveLoadSpritesheet((st_archive *)data, name, ST_PLACE_AUTO);
+}
+
+/************************************\
+|*     Animation File Functions     *|
+\************************************/
+/* Loads an animation file */
+/* Takes path, a function to find spritesheets by name, and data for it */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoad(const char *path, st_animfileresolve resolve,
+  void *data)
+{
+  st_animfileheader header;
+  st_animfile *file;
+  FILE *in;
+  u8 *fileData;
+  u32 size;
+
+  in = fopen(path, "rb");
+  if (!in)
+    return NULL;
+
+  /* The header says how big everything is, then the rest is one read */
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+    !(size = checkHeader(&header)) || !(file = allocate(&header, &fileData)))
+  {
+    fclose(in);
+    return NULL;
+  }
+  memcpy(fileData, &header, sizeof(header));
+  if (size > sizeof(header) &&
+    fread(fileData + sizeof(header), size - sizeof(header), 1, in) != 1)
+  {
+    fclose(in);
+    ST_AnimFileFree(file);
+    return NULL;
+  }
+  fclose(in);
+
+  if (!relocate(file, fileData, resolve, data))
+  {
+    ST_AnimFileFree(file);
+    return NULL;
+  }
+
+  return file;
+}
+
+/* Loads an animation file already in memory */
+/*   The buffer is copied and can be freed afterwards */
+/* Takes buffer, its size in bytes, a function to find spritesheets by */
+/*   name, and data for it */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoadMemory(const void *buffer, u32 size,
+  st_animfileresolve resolve, void *data)
+{
+  st_animfileheader header;
+  st_animfile *file;
+  u8 *fileData;
+  u32 fileSize;
+
+  if (size < sizeof(header))
+    return NULL;
+  memcpy(&header, buffer, sizeof(header));
+  fileSize = checkHeader(&header);
+  if (!fileSize || fileSize > size || !(file = allocate(&header, &fileData)))
+    return NULL;
+
+  memcpy(fileData, buffer, fileSize);
+  if (!relocate(file, fileData, resolve, data))
+  {
+    ST_AnimFileFree(file);
+    return NULL;
+  }
+
+  return file;
+}
+
+/* Loads an animation file from an archive */
+/*   Its spritesheets are loaded from the same archive */
+/* Takes pointer to st_archive and the name of the file */
+/* Returns pointer to st_animfile or NULL on failure */
+st_animfile *ST_AnimFileLoadArchive(st_archive *archive, const char *name)
+{
+  st_animfileheader header;
+  const st_archiveentry *entry;
+  st_animfile *file;
+  u8 *fileData;
+  u32 size;
+  s32 index = ST_ArchiveFind(archive, name);
+
+  entry = ST_ArchiveEntry(archive, index);
+  if (!entry || ST_ArchiveRead(archive, index, 0, &header, sizeof(header)) !=
+    sizeof(header))
+    return NULL;
+  size = checkHeader(&header);
+  if (!size || size > entry->size || !(file = allocate(&header, &fileData)))
+    return NULL;
+
+  if (ST_ArchiveRead(archive, index, 0, fileData, size) != size ||
+    !relocate(file, fileData, archiveResolve, archive))
+  {
+    ST_AnimFileFree(file);
+    return NULL;
+  }
+
+  return file;
+}
+
+/* Frees an animation file and releases its spritesheets */
+/*   Entities made from it must be freed first */
+/* Takes pointer to st_animfile */
+void ST_AnimFileFree(st_animfile *file)
+{
+  u32 i;
+
+  if (!file)
+    return;
+
+  /* A file that failed to load may not have a header yet */
+  if (file->header)
+    for (i = 0; i < file->header->sheetCount; i++)
+      if (file->sheets[i])
+        ST_SpritesheetFreeSpritesheet(file->sheets[i]);
+  free(file);
+}
+
+/* Finds an animation by name */
+/*   The animation is shared, so playing it directly moves it for */
+/*   everything else that plays it */
+/* Takes pointer to st_animfile and name */
+/* Returns pointer to the animation or NULL if there isn't one */
+st_animation *ST_AnimFileFindAnimation(st_animfile *file, const char *name)
+{
+  u32 i;
+
+  for (i = 0; i < file->header->animationCount; i++)
+    if (!strcmp(file->strings + file->animationRecords[i].name, name))
+      return &file->animations[i];
+  return NULL;
+}
+
+/* Makes an entity with the animations of a set */
+/*   The entity gets its own copy of each animation so it plays them on */
+/*   its own, but the frames and events stay in the file */
+/* Takes pointer to st_animfile, name of the set and a position */
+/* Returns pointer to st_entity or NULL on failure */
+st_entity *ST_AnimFileCreateEntity(st_animfile *file, const char *set,
+  double x, double y)
+{
+  const st_animfileset *record = NULL;
+  st_animation *animation;
+  st_entity *entity;
+  u32 i, id;
+
+  for (i = 0; i < file->header->setCount; i++)
+  {
+    if (!strcmp(file->strings + file->sets[i].name, set))
+    {
+      record = &file->sets[i];
+      break;
+    }
+  }
+  if (!record)
+    return NULL;
+
+  entity = ST_EntityCreateEntity(x, y, record->count);
+  if (!entity)
+    return NULL;
+
+  for (i = 0; i < record->count; i++)
+  {
+    id = file->indices[record->animations + i];
+    animation = malloc(sizeof(st_animation));
+    if (!animation)
+    {
+      ST_EntityFreeEntity(entity);
+      return NULL;
+    }
+    *animation = file->animations[id];
+    if (!ST_EntityAddAnimation(entity, animation,
+      (char *)file->strings + file->animationRecords[id].name))
+    {
+      free(animation);
+      ST_EntityFreeEntity(entity);
+      return NULL;
+    }
+  }
+
+  return entity;
+}
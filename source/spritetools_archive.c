@@ -0,0 +1,224 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spritetools/spritetools_archive.h"
+
+/* Checks an index and points the archive's table and names into it */
+/*   Returns 1 if it's usable, 0 if not */
+static u8 setIndex(st_archive *archive, st_archiveheader *header, u32 size)
+{
+  u32 tableBytes;
+
+  if (size < sizeof(st_archiveheader) || header->magic != ST_ARCHIVE_MAGIC ||
+    header->version != ST_ARCHIVE_VERSION || header->indexSize > size)
+    return 0;
+  /* The table must be a power of 2 with at least one empty slot */
+  if (!header->tableSize || (header->tableSize & (header->tableSize - 1)) ||
+    header->entryCount >= header->tableSize)
+    return 0;
+  tableBytes = header->tableSize * sizeof(st_archiveentry);
+  if (tableBytes / sizeof(st_archiveentry) != header->tableSize ||
+    sizeof(st_archiveheader) + tableBytes + header->namesSize !=
+    header->indexSize)
+    return 0;
+
+  archive->header = header;
+  archive->table = (st_archiveentry *)(header + 1);
+  archive->names = (const char *)archive->table + tableBytes;
+  return 1;
+}
+
+/*****************************\
+|*     Archive Functions     *|
+\*****************************/
+/* Opens an archive file, reading only its index */
+/*   Works with romfs:/ and sdmc:/ paths */
+/* Takes path */
+/* Returns pointer to st_archive or NULL on failure */
+st_archive *ST_ArchiveOpen(const char *path)
+{
+  st_archive *archive;
+  st_archiveheader header;
+  st_archiveheader *index;
+
+  archive = calloc(1, sizeof(st_archive));
+  if (!archive)
+    return NULL;
+  LightLock_Init(&archive->lock);
+  archive->file = fopen(path, "rb");
+  if (!archive->file)
+  {
+    free(archive);
+    return NULL;
+  }
+
+  /* The header says how much more to read for the rest of the index */
+  if (fread(&header, sizeof(header), 1, archive->file) != 1 ||
+    header.magic != ST_ARCHIVE_MAGIC ||
+    header.indexSize < sizeof(header) || header.indexSize > 0x1000000 ||
+    !(index = malloc(header.indexSize)))
+  {
+    fclose(archive->file);
+    free(archive);
+    return NULL;
+  }
+  memcpy(index, &header, sizeof(header));
+  if (fread(index + 1, header.indexSize - sizeof(header), 1,
+    archive->file) != 1 || !setIndex(archive, index, header.indexSize))
+  {
+    free(index);
+    fclose(archive->file);
+    free(archive);
+    return NULL;
+  }
+
+  return archive;
+}
+
+/* Opens an archive already in memory, such as one linked into the program */
+/*   The buffer is not copied and must stay valid */
+/* Takes buffer and its size in bytes */
+/* Returns pointer to st_archive or NULL on failure */
+st_archive *ST_ArchiveOpenMemory(const void *buffer, u32 size)
+{
+  st_archive *archive = calloc(1, sizeof(st_archive));
+  st_archiveheader *header = (st_archiveheader *)buffer;
+
+  if (!archive)
+    return NULL;
+  LightLock_Init(&archive->lock);
+  if (!setIndex(archive, header, size) ||
+    header->indexSize + header->dataSize > size)
+  {
+    free(archive);
+    return NULL;
+  }
+  archive->memory = buffer;
+
+  return archive;
+}
+
+/* Closes an archive */
+/*   Spritesheets loaded from it must be freed first */
+/* Takes pointer to st_archive */
+void ST_ArchiveClose(st_archive *archive)
+{
+  if (!archive)
+    return;
+  if (archive->file)
+  {
+    fclose(archive->file);
+    free(archive->header);
+  }
+  free(archive);
+}
+
+/* Finds an entry by name */
+/* Takes pointer to st_archive and name */
+/* Returns entry index or -1 if there isn't one */
+s32 ST_ArchiveFind(st_archive *archive, const char *name)
+{
+  u32 hash = ST_ArchiveHash(name);
+  u32 mask = archive->header->tableSize - 1;
+  u32 i = hash & mask, probes;
+  st_archiveentry *entry;
+
+  /* Linear probing, stopping at the first empty slot. entryCount can't */
+  /*   be trusted to mean the table has one, so never go round twice */
+  for (probes = 0; probes <= mask; probes++)
+  {
+    entry = &archive->table[i];
+    if (entry->name == ST_ARCHIVE_EMPTY)
+      return -1;
+    if (entry->hash == hash && entry->name < archive->header->namesSize &&
+      !strncmp(archive->names + entry->name, name,
+      archive->header->namesSize - entry->name))
+      return i;
+    i = (i + 1) & mask;
+  }
+
+  return -1;
+}
+
+/* Returns pointer to an entry */
+/* Takes pointer to st_archive and entry index */
+/* Returns pointer to st_archiveentry or NULL if the index is bad */
+const st_archiveentry *ST_ArchiveEntry(st_archive *archive, s32 index)
+{
+  if (index < 0 || (u32)index >= archive->header->tableSize ||
+    archive->table[index].name == ST_ARCHIVE_EMPTY)
+    return NULL;
+  return &archive->table[index];
+}
+
+/* Returns a pointer to an entry's payload if the archive is in memory */
+/* Takes pointer to st_archive and entry index */
+/* Returns pointer to the payload or NULL */
+const void *ST_ArchiveData(st_archive *archive, s32 index)
+{
+  const st_archiveentry *entry = ST_ArchiveEntry(archive, index);
+  u32 end = archive->header->indexSize + archive->header->dataSize;
+
+  if (!entry || !archive->memory || entry->offset > end ||
+    entry->size > end - entry->offset)
+    return NULL;
+  return archive->memory + entry->offset;
+}
+
+/* Copies part of an entry's payload */
+/* Takes pointer to st_archive, entry index, offset into the payload, */
+/*   destination and number of bytes */
+/* Returns number of bytes copied */
+u32 ST_ArchiveRead(st_archive *archive, s32 index, u32 offset, void *dst,
+  u32 size)
+{
+  const st_archiveentry *entry = ST_ArchiveEntry(archive, index);
+  const u8 *data;
+
+  if (!entry || offset > entry->size)
+    return 0;
+  if (size > entry->size - offset)
+    size = entry->size - offset;
+
+  if (archive->memory)
+  {
+    data = ST_ArchiveData(archive, index);
+    if (!data)
+      return 0;
+    memcpy(dst, data + offset, size);
+    return size;
+  }
+
+  LightLock_Lock(&archive->lock);
+  if (fseek(archive->file, entry->offset + offset, SEEK_SET))
+    size = 0;
+  else
+    size = fread(dst, 1, size, archive->file);
+  LightLock_Unlock(&archive->lock);
+  return size;
+}
+
+/* Loads a spritesheet from an entry */
+/*   Converted textures from an archive file are read straight into their */
+/*   texture without a copy on the heap */
+/* Takes pointer to st_archive, name and a placement hint */
+/* Returns pointer to st_spritesheet or NULL on failure */
+st_spritesheet *ST_ArchiveLoadSpritesheet(st_archive *archive,
+  const char *name, st_placement placement)
+{
+  st_spritesheetsource source = {ST_SOURCE_ARCHIVE, archive, 0, 0, 0,
+    placement};
+  s32 index = ST_ArchiveFind(archive, name);
+
+  if (index < 0)
+    return NULL;
+  source.size = index;
+
+  return ST_SpritesheetCreateSpritesheetSource(&source);
+}
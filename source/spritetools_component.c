@@ -0,0 +1,380 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spritetools/spritetools_component.h"
+
+/* Number of components a store makes room for the first time */
+#define ST_COMPONENT_START 16
+
+/* Returns a store, or NULL if the type isn't registered */
+static st_componentstore *getStore(st_componentregistry *registry, u16 type)
+{
+  if (type >= registry->storeCount)
+    return NULL;
+  return &registry->stores[type];
+}
+
+/* Returns where a handle's component is in a store, or -1 */
+static s32 findComponent(const st_componentstore *store, st_handle handle)
+{
+  u32 index = ST_HANDLE_INDEX(handle), place;
+
+  if (index >= store->sparseSize || !store->sparse[index])
+    return -1;
+  place = store->sparse[index] - 1;
+  /* A reused index with a different handle isn't a match */
+  if (store->handles[place] != handle)
+    return -1;
+  return place;
+}
+
+/* Swaps two components of a store, along with their handles */
+static void swapComponents(st_componentstore *store, u32 a, u32 b)
+{
+  u8 *spare = store->data + store->capacity * store->size;
+  st_handle handle;
+
+  if (a == b)
+    return;
+
+  memcpy(spare, store->data + a * store->size, store->size);
+  memcpy(store->data + a * store->size, store->data + b * store->size,
+    store->size);
+  memcpy(store->data + b * store->size, spare, store->size);
+
+  handle = store->handles[a];
+  store->handles[a] = store->handles[b];
+  store->handles[b] = handle;
+  store->sparse[ST_HANDLE_INDEX(store->handles[a])] = a + 1;
+  store->sparse[ST_HANDLE_INDEX(store->handles[b])] = b + 1;
+}
+
+/* Removes the component at a place in a store */
+static void removeAt(st_componentstore *store, u32 place)
+{
+  u32 last = store->count - 1;
+
+  store->sparse[ST_HANDLE_INDEX(store->handles[place])] = 0;
+  if (place != last)
+  {
+    memcpy(store->data + place * store->size,
+      store->data + last * store->size, store->size);
+    store->handles[place] = store->handles[last];
+    store->sparse[ST_HANDLE_INDEX(store->handles[place])] = place + 1;
+  }
+  store->count--;
+}
+
+/*******************************\
+|*     Component Functions     *|
+\*******************************/
+/* Returns a pointer to a component registry */
+/*   Returns NULL if failed */
+st_componentregistry *ST_ComponentCreateRegistry(void)
+{
+  return calloc(1, sizeof(st_componentregistry));
+}
+
+/* Frees a component registry and every component in it */
+/* Takes a pointer to a component registry */
+void ST_ComponentFreeRegistry(st_componentregistry *registry)
+{
+  u16 i;
+
+  if (!registry)
+    return;
+
+  for (i = 0; i < registry->storeCount; i++)
+  {
+    free(registry->stores[i].sparse);
+    free(registry->stores[i].handles);
+    free(registry->stores[i].data);
+  }
+  free(registry->stores);
+  free(registry);
+}
+
+/* Adds a component type */
+/* Takes a pointer to a component registry and the size of the component */
+/* Returns the type, or -1 on failure */
+s32 ST_ComponentRegister(st_componentregistry *registry, u32 size)
+{
+  st_componentstore *store;
+
+  if (!size || registry->storeCount == 0xFFFF)
+    return -1;
+
+  if (registry->storeCount >= registry->storeCapacity)
+  {
+    u16 capacity = registry->storeCapacity ? registry->storeCapacity * 2 : 8;
+    st_componentstore *stores = realloc(registry->stores,
+      capacity * sizeof(st_componentstore));
+    if (!stores)
+      return -1;
+    registry->stores = stores;
+    registry->storeCapacity = capacity;
+  }
+
+  store = &registry->stores[registry->storeCount];
+  memset(store, 0, sizeof(st_componentstore));
+  store->size = size;
+
+  return registry->storeCount++;
+}
+
+/* Adds a component to a handle */
+/*   New components are zeroed. Pointers to components of a type stay */
+/*   valid until one of that type is added or removed */
+/* Takes a pointer to a component registry, the type and the handle */
+/* Returns the component (the one already there if there is one), */
+/*   or NULL on failure */
+void *ST_ComponentAdd(st_componentregistry *registry, u16 type,
+  st_handle handle)
+{
+  st_componentstore *store = getStore(registry, type);
+  u32 index = ST_HANDLE_INDEX(handle);
+  s32 place;
+
+  if (!store || handle == ST_HANDLE_NONE)
+    return NULL;
+  place = findComponent(store, handle);
+  if (place >= 0)
+    return store->data + place * store->size;
+  /* The index belongs to a handle that's gone, so its component goes too */
+  if (index < store->sparseSize && store->sparse[index])
+    removeAt(store, store->sparse[index] - 1);
+
+  if (index >= store->sparseSize)
+  {
+    u32 sparseSize = store->sparseSize ? store->sparseSize : 64;
+    u32 *sparse;
+
+    while (sparseSize <= index)
+      sparseSize *= 2;
+    sparse = realloc(store->sparse, sparseSize * sizeof(u32));
+    if (!sparse)
+      return NULL;
+    memset(sparse + store->sparseSize, 0,
+      (sparseSize - store->sparseSize) * sizeof(u32));
+    store->sparse = sparse;
+    store->sparseSize = sparseSize;
+  }
+
+  if (store->count >= store->capacity)
+  {
+    u32 capacity = store->capacity ? store->capacity * 2 : ST_COMPONENT_START;
+    st_handle *handles;
+    u8 *data;
+
+    handles = realloc(store->handles, capacity * sizeof(st_handle));
+    if (!handles)
+      return NULL;
+    store->handles = handles;
+    data = realloc(store->data, (capacity + 1) * store->size);
+    if (!data)
+      return NULL;
+    store->data = data;
+    store->capacity = capacity;
+  }
+
+  place = store->count++;
+  store->handles[place] = handle;
+  store->sparse[index] = place + 1;
+  memset(store->data + place * store->size, 0, store->size);
+
+  return store->data + place * store->size;
+}
+
+/* Removes a component from a handle */
+/*   The last component of the type takes its place */
+/* Takes a pointer to a component registry, the type and the handle */
+/* Returns 1 if there was one to remove, 0 if not */
+u8 ST_ComponentRemove(st_componentregistry *registry, u16 type,
+  st_handle handle)
+{
+  st_componentstore *store = getStore(registry, type);
+  s32 place;
+
+  if (!store || (place = findComponent(store, handle)) < 0)
+    return 0;
+
+  removeAt(store, place);
+  return 1;
+}
+
+/* Removes every component of a handle */
+/* Takes a pointer to a component registry and the handle */
+void ST_ComponentRemoveAll(st_componentregistry *registry, st_handle handle)
+{
+  u16 i;
+
+  for (i = 0; i < registry->storeCount; i++)
+    ST_ComponentRemove(registry, i, handle);
+}
+
+/* Returns a handle's component, or NULL if it doesn't have one */
+/* Takes a pointer to a component registry, the type and the handle */
+void *ST_ComponentGet(st_componentregistry *registry, u16 type,
+  st_handle handle)
+{
+  st_componentstore *store = getStore(registry, type);
+  s32 place;
+
+  if (!store || (place = findComponent(store, handle)) < 0)
+    return NULL;
+  return store->data + place * store->size;
+}
+
+/* Returns the number of components of a type */
+/* Takes a pointer to a component registry and the type */
+u32 ST_ComponentCount(st_componentregistry *registry, u16 type)
+{
+  st_componentstore *store = getStore(registry, type);
+  return store ? store->count : 0;
+}
+
+/* Returns the packed components of a type */
+/* Takes a pointer to a component registry and the type */
+void *ST_ComponentData(st_componentregistry *registry, u16 type)
+{
+  st_componentstore *store = getStore(registry, type);
+  return store ? store->data : NULL;
+}
+
+/* Returns the handles of the packed components of a type, in order */
+/* Takes a pointer to a component registry and the type */
+const st_handle *ST_ComponentHandles(st_componentregistry *registry,
+  u16 type)
+{
+  st_componentstore *store = getStore(registry, type);
+  return store ? store->handles : NULL;
+}
+
+/***************************\
+|*     Query Functions     *|
+\***************************/
+/* Starts going through everything with all of a set of component types */
+/* Takes a pointer to a query, a pointer to a component registry, the */
+/*   number of types and the types */
+/* Returns 1 on success and 0 if the types aren't valid */
+u8 ST_ComponentQueryStart(st_componentquery *query,
+  st_componentregistry *registry, u8 typeCount, const u16 *types)
+{
+  u8 i;
+
+  query->registry = registry;
+  query->typeCount = 0;
+  query->position = 0;
+  query->handle = ST_HANDLE_NONE;
+  if (!typeCount || typeCount > ST_QUERY_MAX_TYPES)
+    return 0;
+
+  /* Walking the smallest store means looking at the fewest candidates */
+  query->lead = types[0];
+  for (i = 0; i < typeCount; i++)
+  {
+    if (types[i] >= registry->storeCount)
+      return 0;
+    query->types[i] = types[i];
+    if (registry->stores[types[i]].count <
+      registry->stores[query->lead].count)
+      query->lead = types[i];
+  }
+  query->typeCount = typeCount;
+  query->position = registry->stores[query->lead].count;
+
+  return 1;
+}
+
+/* Moves a query on to the next match */
+/*   Components of the current match can be removed before calling this */
+/* Takes a pointer to a query */
+/* Returns 1 if there's a match, with its handle and components in the */
+/*   query, or 0 once there are no more */
+u8 ST_ComponentQueryNext(st_componentquery *query)
+{
+  st_componentregistry *registry = query->registry;
+  st_componentstore *lead, *store;
+  st_handle handle;
+  s32 place;
+  u8 i;
+
+  if (!query->typeCount)
+    return 0;
+  lead = &registry->stores[query->lead];
+
+  /* Going from the end back, removing the current match only moves one */
+  /*   that was already looked at into its place */
+  while (query->position)
+  {
+    if (--query->position >= lead->count)
+      continue;
+    handle = lead->handles[query->position];
+    for (i = 0; i < query->typeCount; i++)
+    {
+      store = &registry->stores[query->types[i]];
+      place = findComponent(store, handle);
+      if (place < 0)
+        break;
+      query->components[i] = store->data + place * store->size;
+    }
+    if (i == query->typeCount)
+    {
+      query->handle = handle;
+      return 1;
+    }
+  }
+
+  query->handle = ST_HANDLE_NONE;
+  return 0;
+}
+
+/* Reorders the stores of a query's types so every match is at the front */
+/*   of each, in the same order */
+/*   Afterward the first count components of each type from */
+/*   ST_ComponentData belong together and can be gone through like plain */
+/*   arrays, until a component of one of the types is added or removed */
+/* Takes a pointer to a query */
+/* Returns the number of matches */
+u32 ST_ComponentQueryPack(st_componentquery *query)
+{
+  st_componentregistry *registry = query->registry;
+  st_componentstore *lead, *store;
+  st_handle handle;
+  u32 packed = 0, position;
+  s32 place;
+  u8 i;
+
+  if (!query->typeCount)
+    return 0;
+  lead = &registry->stores[query->lead];
+
+  for (position = 0; position < lead->count; position++)
+  {
+    handle = lead->handles[position];
+    for (i = 0; i < query->typeCount; i++)
+      if (findComponent(&registry->stores[query->types[i]], handle) < 0)
+        break;
+    if (i < query->typeCount)
+      continue;
+
+    /* Everything before packed already matched, so this only ever moves */
+    /*   a component back to where the next match goes */
+    for (i = 0; i < query->typeCount; i++)
+    {
+      store = &registry->stores[query->types[i]];
+      place = findComponent(store, handle);
+      swapComponents(store, packed, place);
+    }
+    packed++;
+  }
+
+  query->position = lead->count;
+  return packed;
+}
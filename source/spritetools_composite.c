@@ -0,0 +1,285 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <math.h>
+#include "spritetools/spritetools_composite.h"
+
+/* Returns a part of a composite, or NULL if there isn't one */
+static st_compositepart *getPart(st_composite *composite, u16 part)
+{
+  if (part >= composite->partCount)
+    return NULL;
+  return &composite->parts[part];
+}
+
+/*******************************\
+|*     Composite Functions     *|
+\*******************************/
+/* Returns a pointer to a composite */
+/*   Returns NULL if failed */
+/* Takes a position and the number of parts to make room for */
+st_composite *ST_CompositeCreate(double x, double y, u16 partCount)
+{
+  st_composite *composite = calloc(1, sizeof(st_composite));
+  if (!composite)
+    return NULL;
+
+  if (!partCount)
+    partCount = 8;
+  composite->parts = calloc(partCount, sizeof(st_compositepart));
+  composite->order = calloc(partCount, sizeof(u16));
+  if (!composite->parts || !composite->order)
+  {
+    ST_CompositeFree(composite);
+    return NULL;
+  }
+  composite->partCapacity = partCount;
+  composite->xpos = x;
+  composite->ypos = y;
+  composite->rotation = 0.0;
+  composite->scale = 1.0;
+
+  return composite;
+}
+
+/* Frees a composite from memory */
+/*   Its frames are not freed */
+/* Takes a pointer to a composite */
+void ST_CompositeFree(st_composite *composite)
+{
+  if (!composite)
+    return;
+
+  free(composite->parts);
+  free(composite->order);
+  free(composite);
+}
+
+/* Adds a part to a composite */
+/*   Parts start unrotated, unscaled and untinted */
+/* Takes a pointer to a composite, a frame, the parent part (an earlier */
+/*   part or ST_COMPOSITE_ROOT), an offset from the parent and a layer */
+/* Returns the index of the part, or -1 on failure */
+s32 ST_CompositeAddPart(st_composite *composite, st_frame *frame,
+  s16 parent, float x, float y, s16 layer)
+{
+  st_compositepart *part;
+
+  if (parent < ST_COMPOSITE_ROOT || parent >= composite->partCount ||
+    composite->partCount == 0x7FFF)
+    return -1;
+
+  if (composite->partCount >= composite->partCapacity)
+  {
+    u16 capacity = composite->partCapacity * 2;
+    st_compositepart *parts;
+    u16 *order;
+
+    if (capacity > 0x7FFF)
+      capacity = 0x7FFF;
+    parts = realloc(composite->parts, capacity * sizeof(st_compositepart));
+    if (!parts)
+      return -1;
+    composite->parts = parts;
+    order = realloc(composite->order, capacity * sizeof(u16));
+    if (!order)
+      return -1;
+    composite->order = order;
+    composite->partCapacity = capacity;
+  }
+
+  part = &composite->parts[composite->partCount];
+  part->frame = frame;
+  part->parent = parent;
+  part->layer = layer;
+  part->x = x;
+  part->y = y;
+  part->rotation = 0.0f;
+  part->scale = 1.0f;
+  part->red = 0xFF;
+  part->green = 0xFF;
+  part->blue = 0xFF;
+  part->alpha = 0xFF;
+  part->dirty = 1;
+  composite->dirty = 1;
+  composite->order[composite->partCount] = composite->partCount;
+  composite->orderDirty = 1;
+
+  return composite->partCount++;
+}
+
+/* Sets the offset of a part from its parent */
+/* Takes a pointer to a composite, the part and an offset */
+void ST_CompositeSetPartPosition(st_composite *composite, u16 part,
+  float x, float y)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (!p || (p->x == x && p->y == y))
+    return;
+
+  p->x = x;
+  p->y = y;
+  p->dirty = 1;
+  composite->dirty = 1;
+}
+
+/* Sets the rotation of a part relative to its parent */
+/* Takes a pointer to a composite, the part and a rotation in radians */
+void ST_CompositeSetPartRotation(st_composite *composite, u16 part,
+  float rotation)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (!p || p->rotation == rotation)
+    return;
+
+  p->rotation = rotation;
+  p->dirty = 1;
+  composite->dirty = 1;
+}
+
+/* Sets the scale of a part relative to its parent */
+/* Takes a pointer to a composite, the part and a scale */
+void ST_CompositeSetPartScale(st_composite *composite, u16 part,
+  float scale)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (!p || p->scale == scale)
+    return;
+
+  p->scale = scale;
+  p->dirty = 1;
+  composite->dirty = 1;
+}
+
+/* Sets the frame a part draws */
+/* Takes a pointer to a composite, the part and a frame */
+void ST_CompositeSetPartFrame(st_composite *composite, u16 part,
+  st_frame *frame)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (p)
+    p->frame = frame;
+}
+
+/* Sets the color to blend a part with */
+/* Takes a pointer to a composite, the part, and red, green, blue, alpha */
+void ST_CompositeSetPartColor(st_composite *composite, u16 part,
+  u8 red, u8 green, u8 blue, u8 alpha)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (!p)
+    return;
+
+  p->red = red;
+  p->green = green;
+  p->blue = blue;
+  p->alpha = alpha;
+}
+
+/* Sets the layer of a part */
+/* Takes a pointer to a composite, the part and a layer */
+void ST_CompositeSetPartLayer(st_composite *composite, u16 part, s16 layer)
+{
+  st_compositepart *p = getPart(composite, part);
+  if (!p || p->layer == layer)
+    return;
+
+  p->layer = layer;
+  composite->orderDirty = 1;
+}
+
+/* Sets the position of a composite's root */
+/* Takes a pointer to a composite and a position */
+void ST_CompositeSetPosition(st_composite *composite, double x, double y)
+{
+  composite->xpos = x;
+  composite->ypos = y;
+}
+
+/* Sets the rotation of a composite's root */
+/* Takes a pointer to a composite and a rotation in radians */
+void ST_CompositeSetRotation(st_composite *composite, double rotation)
+{
+  composite->rotation = rotation;
+}
+
+/* Sets the scale of a composite's root */
+/* Takes a pointer to a composite and a scale */
+void ST_CompositeSetScale(st_composite *composite, double scale)
+{
+  composite->scale = scale;
+}
+
+/* Works out the world values of parts that changed and their children, */
+/*   and sorts the draw order if layers changed */
+/*   Rendering a composite does this for you */
+/* Takes a pointer to a composite */
+void ST_CompositeUpdate(st_composite *composite)
+{
+  st_compositepart *part, *parent;
+  float c, s;
+  u16 i, j, index;
+
+  /* World values are relative to the root, so moving, turning or scaling */
+  /*   the whole composite never dirties its parts */
+  if (composite->dirty)
+  {
+    for (i = 0; i < composite->partCount; i++)
+    {
+      part = &composite->parts[i];
+      parent = part->parent == ST_COMPOSITE_ROOT ?
+        NULL : &composite->parts[part->parent];
+
+      /* Parents come first, so a recomputed parent is still marked dirty */
+      if (parent && parent->dirty)
+        part->dirty = 1;
+      if (!part->dirty)
+        continue;
+
+      if (!parent)
+      {
+        part->worldX = part->x;
+        part->worldY = part->y;
+        part->worldRotation = part->rotation;
+        part->worldScale = part->scale;
+        continue;
+      }
+
+      c = cosf(parent->worldRotation) * parent->worldScale;
+      s = sinf(parent->worldRotation) * parent->worldScale;
+      part->worldX = parent->worldX + part->x * c - part->y * s;
+      part->worldY = parent->worldY + part->x * s + part->y * c;
+      part->worldRotation = parent->worldRotation + part->rotation;
+      part->worldScale = parent->worldScale * part->scale;
+    }
+
+    for (i = 0; i < composite->partCount; i++)
+      composite->parts[i].dirty = 0;
+    composite->dirty = 0;
+  }
+
+  /* Layers rarely change between frames, so an insertion sort over the */
+  /*   already mostly sorted order is cheap and keeps equal layers in the */
+  /*   order their parts were added */
+  if (composite->orderDirty)
+  {
+    for (i = 1; i < composite->partCount; i++)
+    {
+      index = composite->order[i];
+      j = i;
+      while (j && composite->parts[composite->order[j - 1]].layer >
+        composite->parts[index].layer)
+      {
+        composite->order[j] = composite->order[j - 1];
+        j--;
+      }
+      composite->order[j] = index;
+    }
+    composite->orderDirty = 0;
+  }
+}
@@ -12,6 +12,42 @@
 #define PI 3.1415926535897932384626433832795
 #endif
 
+/* Pool slot states */
+enum {
+  ST_POOL_FREE,
+  ST_POOL_ALIVE,
+  ST_POOL_DESTROYED
+};
+
+/* Sets an entity's values to what a new entity starts with */
+/*   Its animation lists are kept but emptied */
+static void resetEntity(st_entity *entity, double x, double y)
+{
+  entity->animationCount = 0;
+  entity->xpos = x;
+  entity->ypos = y;
+  entity->scale = 1.0;
+  entity->rotation = 0.0;
+  entity->red = 0xFF;
+  entity->green = 0xFF;
+  entity->blue = 0xFF;
+  entity->alpha = 0xFF;
+  entity->dir = "east";
+  entity->currentAnim = 0;
+  entity->flags = 0;
+}
+
+/* Returns the slot a handle refers to, or -1 if it's out of date */
+static s32 poolSlot(st_entitypool *pool, st_handle handle)
+{
+  u32 index = ST_HANDLE_INDEX(handle);
+
+  if (index >= pool->capacity ||
+    pool->generations[index] != handle >> ST_HANDLE_INDEX_BITS)
+    return -1;
+  return index;
+}
+
 /***************************\
 |*     Entity Creation     *|
 \***************************/
@@ -26,19 +62,8 @@ st_entity *ST_EntityCreateEntity(double x, double y, u8 animCount)
 
   tempent->animations = calloc(sizeof(st_animation*), animCount);
   tempent->names = calloc(sizeof(char*), animCount);
-  tempent->animationCount = 0;
   tempent->totalAnims = animCount;
-  tempent->xpos = x;
-  tempent->ypos = y;
-  tempent->scale = 1.0;
-  tempent->rotation = 0.0;
-  tempent->red = 0xFF;
-  tempent->green = 0xFF;
-  tempent->blue = 0xFF;
-  tempent->alpha = 0xFF;
-  tempent->dir = "east";
-  tempent->currentAnim = 0;
-  tempent->flags = 0;
+  resetEntity(tempent, x, y);
 
   return tempent;
 }
@@ -68,6 +93,8 @@ u8 ST_EntityAddAnimation(st_entity *entity, st_animation *anim, char *name)
     entity->animations[entity->animationCount] = anim;
     if (!entity->animations[entity->animationCount])
       return 0;
+    if (!anim->eventData)
+      anim->eventData = entity;
     entity->names[entity->animationCount] = name;
     if (!entity->names[entity->animationCount])
       return 0;
@@ -77,6 +104,178 @@ u8 ST_EntityAddAnimation(st_entity *entity, st_animation *anim, char *name)
   return 0;
 }
 
+/************************\
+|*     Entity Pools     *|
+\************************/
+/* Returns a pointer to an entity pool */
+/*   Returns NULL if failed */
+/* Takes the number of entities and of animations each can have */
+st_entitypool *ST_EntityPoolCreate(u32 capacity, u8 animCount)
+{
+  st_entitypool *pool;
+  u32 i;
+
+  /* The last index is left out so no handle is ever ST_HANDLE_NONE */
+  if (!capacity || capacity >= (1 << ST_HANDLE_INDEX_BITS) - 1)
+    return NULL;
+  pool = calloc(1, sizeof(st_entitypool));
+  if (!pool)
+    return NULL;
+
+  pool->entities = calloc(capacity, sizeof(st_entity));
+  pool->animations = calloc(capacity * (animCount ? animCount : 1),
+    sizeof(st_animation *));
+  pool->names = calloc(capacity * (animCount ? animCount : 1),
+    sizeof(char *));
+  pool->generations = calloc(capacity, sizeof(u16));
+  pool->states = calloc(capacity, sizeof(u8));
+  pool->freeList = malloc(capacity * sizeof(u32));
+  pool->destroyed = malloc(capacity * sizeof(st_handle));
+  if (!pool->entities || !pool->animations || !pool->names ||
+    !pool->generations || !pool->states || !pool->freeList ||
+    !pool->destroyed)
+  {
+    ST_EntityPoolFree(pool);
+    return NULL;
+  }
+  pool->capacity = capacity;
+  pool->animCount = animCount;
+
+  /* Slots are handed out from the end of the free list, lowest first */
+  for (i = 0; i < capacity; i++)
+  {
+    pool->freeList[i] = capacity - 1 - i;
+    pool->entities[i].animations = &pool->animations[i * animCount];
+    pool->entities[i].names = &pool->names[i * animCount];
+    pool->entities[i].totalAnims = animCount;
+  }
+  pool->freeCount = capacity;
+
+  return pool;
+}
+
+/* Frees an entity pool and all of its entities */
+/*   Animations added to its entities are not freed */
+/* Takes a pointer to an entity pool */
+void ST_EntityPoolFree(st_entitypool *pool)
+{
+  if (!pool)
+    return;
+
+  free(pool->entities);
+  free(pool->animations);
+  free(pool->names);
+  free(pool->generations);
+  free(pool->states);
+  free(pool->freeList);
+  free(pool->destroyed);
+  free(pool);
+}
+
+/* Sets a component registry whose components are removed along with */
+/*   destroyed entities when the pool is flushed */
+/* Takes a pointer to an entity pool and a pointer to a component registry */
+void ST_EntityPoolSetRegistry(st_entitypool *pool,
+  st_componentregistry *registry)
+{
+  pool->registry = registry;
+}
+
+/* Takes an entity from a pool, set up like ST_EntityCreateEntity does */
+/*   Entities from a pool must not be freed with ST_EntityFreeEntity */
+/* Takes a pointer to an entity pool and a position */
+/* Returns the entity's handle, or ST_HANDLE_NONE if the pool is empty */
+st_handle ST_EntityPoolSpawn(st_entitypool *pool, double x, double y)
+{
+  u32 index;
+
+  if (!pool->freeCount)
+    return ST_HANDLE_NONE;
+
+  index = pool->freeList[--pool->freeCount];
+  resetEntity(&pool->entities[index], x, y);
+  pool->states[index] = ST_POOL_ALIVE;
+  pool->aliveCount++;
+
+  return index | (u32)pool->generations[index] << ST_HANDLE_INDEX_BITS;
+}
+
+/* Returns the entity a handle refers to */
+/*   Returns NULL if it was destroyed */
+/* Takes a pointer to an entity pool and a handle */
+st_entity *ST_EntityPoolGet(st_entitypool *pool, st_handle handle)
+{
+  s32 slot = poolSlot(pool, handle);
+
+  if (slot < 0 || pool->states[slot] != ST_POOL_ALIVE)
+    return NULL;
+  return &pool->entities[slot];
+}
+
+/* Destroys an entity */
+/*   It stays in memory, untouched, until the pool is flushed */
+/* Takes a pointer to an entity pool and a handle */
+/* Returns 1 on success and 0 if it was already destroyed */
+u8 ST_EntityPoolDestroy(st_entitypool *pool, st_handle handle)
+{
+  s32 slot = poolSlot(pool, handle);
+
+  if (slot < 0 || pool->states[slot] != ST_POOL_ALIVE)
+    return 0;
+
+  /* Each slot is queued at most once, so the queue can't overflow */
+  pool->states[slot] = ST_POOL_DESTROYED;
+  pool->destroyed[pool->destroyedCount++] = handle;
+  pool->aliveCount--;
+
+  return 1;
+}
+
+/* Gives the slots of destroyed entities back to a pool */
+/*   Call this where nothing is going through entities, like the end of an */
+/*   update. ST_LoopSetPool does it after every update */
+/* Takes a pointer to an entity pool */
+void ST_EntityPoolFlush(st_entitypool *pool)
+{
+  u32 i, index;
+
+  for (i = 0; i < pool->destroyedCount; i++)
+  {
+    if (pool->registry)
+      ST_ComponentRemoveAll(pool->registry, pool->destroyed[i]);
+    index = ST_HANDLE_INDEX(pool->destroyed[i]);
+    pool->generations[index] = (pool->generations[index] + 1) &
+      ((1 << (32 - ST_HANDLE_INDEX_BITS)) - 1);
+    pool->states[index] = ST_POOL_FREE;
+    pool->freeList[pool->freeCount++] = index;
+  }
+  pool->destroyedCount = 0;
+}
+
+/* Goes through the entities of a pool that are alive */
+/*   Start the cursor at 0 */
+/* Takes a pointer to an entity pool, a pointer to the cursor and where */
+/*   to store the entity's handle (or NULL) */
+/* Returns the next entity, or NULL once there are no more */
+st_entity *ST_EntityPoolNext(st_entitypool *pool, u32 *cursor,
+  st_handle *handle)
+{
+  u32 index;
+
+  while (*cursor < pool->capacity)
+  {
+    index = (*cursor)++;
+    if (pool->states[index] != ST_POOL_ALIVE)
+      continue;
+    if (handle)
+      *handle = index |
+        (u32)pool->generations[index] << ST_HANDLE_INDEX_BITS;
+    return &pool->entities[index];
+  }
+
+  return NULL;
+}
+
 /**************************\
 |*     Setting Values     *|
 \**************************/
@@ -0,0 +1,253 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdint.h>
+#include "spritetools/spritetools_governor.h"
+#include "spritetools/spritetools_animation.h"
+
+/* System ticks in a millisecond */
+#define TICKS_PER_MS (SYSCLOCK_ARM11 / 1000.0)
+
+/* Weight of the newest frame in the smoothed frame time */
+#define SMOOTHING 0.1
+
+/* Fraction of the budget that counts as comfortably under it */
+#define HEADROOM 0.75
+
+typedef struct {
+  st_governorworkload workload;
+  void *data;
+} st_workload;
+
+static double st_budget = ST_GOVERNOR_DEFAULT_BUDGET;
+static double st_average = 0.0;
+static u8 st_quality = ST_GOVERNOR_MAX_QUALITY;
+static u32 st_frameCount = 0;
+static u32 st_overFrames = 0;
+static u32 st_underFrames = 0;
+static u64 st_workStart = 0;
+static double st_otherWork = 0.0;
+static st_workload st_workloads[ST_GOVERNOR_MAX_WORKLOADS];
+
+/* Tells every workload about the current quality level */
+static void notify(void)
+{
+  u8 i;
+  for (i = 0; i < ST_GOVERNOR_MAX_WORKLOADS; i++)
+  {
+    if (st_workloads[i].workload)
+      st_workloads[i].workload(st_quality, st_workloads[i].data);
+  }
+}
+
+/******************************\
+|*     Governor Functions     *|
+\******************************/
+/* Inits the governor */
+u8 ST_GovernorInit(void)
+{
+  st_average = 0.0;
+  st_quality = ST_GOVERNOR_MAX_QUALITY;
+  st_frameCount = 0;
+  st_overFrames = 0;
+  st_underFrames = 0;
+  st_otherWork = 0.0;
+  st_workStart = svcGetSystemTick();
+
+  return 1;
+}
+
+/* Sets the frame budget in ms */
+void ST_GovernorSetBudget(double budget)
+{
+  if (budget > 0.0)
+    st_budget = budget;
+}
+
+/* Returns the frame budget in ms */
+double ST_GovernorGetBudget(void)
+{
+  return st_budget;
+}
+
+/* Feeds the governor the length of the last frame in ms */
+void ST_GovernorFrame(double ms)
+{
+  st_frameCount++;
+  if (st_frameCount == 1)
+    st_average = ms;
+  else
+    st_average += (ms - st_average) * SMOOTHING;
+
+  /* Drop quickly so hitches are short, raise slowly so it doesn't flicker */
+  if (st_average > st_budget)
+  {
+    st_underFrames = 0;
+    if (++st_overFrames >= ST_GOVERNOR_DROP_FRAMES && st_quality > 0)
+    {
+      st_overFrames = 0;
+      st_quality--;
+      /* Start over from the budget so one spike can't drop more than once */
+      /*   while it fades out of the average */
+      st_average = st_budget;
+      notify();
+    }
+  }
+  else if (st_average < st_budget * HEADROOM)
+  {
+    st_overFrames = 0;
+    if (++st_underFrames >= ST_GOVERNOR_RAISE_FRAMES &&
+      st_quality < ST_GOVERNOR_MAX_QUALITY)
+    {
+      st_underFrames = 0;
+      st_quality++;
+      notify();
+    }
+  }
+  else
+  {
+    st_overFrames = 0;
+    st_underFrames = 0;
+  }
+}
+
+/* Marks the start of a frame's work */
+void ST_GovernorStartWork(void)
+{
+  st_workStart = svcGetSystemTick();
+}
+
+/* Reports work done for this frame somewhere else, like another thread */
+/* Takes the length of the work in ms */
+void ST_GovernorWork(double ms)
+{
+  if (ms > st_otherWork)
+    st_otherWork = ms;
+}
+
+/* Measures the work since ST_GovernorStartWork (or the last call) and */
+/*   feeds it to the governor */
+void ST_GovernorTick(void)
+{
+  u64 tick = svcGetSystemTick();
+  double ms = (tick - st_workStart) / TICKS_PER_MS;
+
+  if (ms < st_otherWork)
+    ms = st_otherWork;
+  ST_GovernorFrame(ms);
+  st_otherWork = 0.0;
+  st_workStart = tick;
+}
+
+/* Returns the smoothed frame time in ms */
+double ST_GovernorAverage(void)
+{
+  return st_average;
+}
+
+/* Returns the current quality level */
+u8 ST_GovernorQuality(void)
+{
+  return st_quality;
+}
+
+/* Forces the quality level and notifies all workloads */
+void ST_GovernorSetQuality(u8 quality)
+{
+  if (quality > ST_GOVERNOR_MAX_QUALITY)
+    quality = ST_GOVERNOR_MAX_QUALITY;
+  st_quality = quality;
+  st_overFrames = 0;
+  st_underFrames = 0;
+  notify();
+}
+
+/* Returns the quality level scaled to 0.0 - 1.0 */
+double ST_GovernorScale(void)
+{
+  return (double)st_quality / ST_GOVERNOR_MAX_QUALITY;
+}
+
+/* Returns the number of frames the governor has seen */
+u32 ST_GovernorFrameCount(void)
+{
+  return st_frameCount;
+}
+
+/* Registers a workload to be told when the quality level changes */
+/* Takes a callback and user data */
+/* Returns id of the workload or -1 on failure */
+s8 ST_GovernorRegister(st_governorworkload workload, void *data)
+{
+  s8 id;
+
+  if (!workload)
+    return -1;
+
+  for (id = 0; id < ST_GOVERNOR_MAX_WORKLOADS; id++)
+  {
+    if (!st_workloads[id].workload)
+    {
+      st_workloads[id].workload = workload;
+      st_workloads[id].data = data;
+      workload(st_quality, data);
+      return id;
+    }
+  }
+
+  return -1;
+}
+
+/* Removes a workload */
+/* Takes id of the workload */
+void ST_GovernorUnregister(s8 id)
+{
+  if (id < 0 || id >= ST_GOVERNOR_MAX_WORKLOADS)
+    return;
+  st_workloads[id].workload = NULL;
+  st_workloads[id].data = NULL;
+}
+
+/***********************************\
+|*     Library Scaling Helpers     *|
+\***********************************/
+/* Returns how many frames an entity at the given distance from the */
+/*   camera should wait between animation updates (1 = every frame) */
+u8 ST_GovernorAnimationDivisor(double distance)
+{
+  if (distance < 0.0)
+    distance = -distance;
+  if (distance <= ST_GOVERNOR_NEAR_DISTANCE)
+    return 1;
+
+  return 1 + ST_GOVERNOR_MAX_QUALITY - st_quality;
+}
+
+/* Steps an animation for this frame, only every few frames when it's far */
+/*   from the camera and the quality is lowered, keeping its speed */
+/* Takes a pointer to an animation and its distance from the camera */
+void ST_GovernorStepAnimation(st_animation *animation, double distance)
+{
+  u8 divisor = ST_GovernorAnimationDivisor(distance);
+  u32 phase;
+
+  if (divisor > 1)
+  {
+    /* Spread by address so far animations don't all step on one frame */
+    phase = (u32)((uintptr_t)animation >> 3) * 2654435761u >> 16;
+    if ((st_frameCount + phase) % divisor)
+      return;
+  }
+  ST_AnimationStep(animation, divisor);
+}
+
+/* Returns a culling margin shrunk to match the quality level */
+/* Takes the margin used at full quality */
+double ST_GovernorCullMargin(double margin)
+{
+  return margin * ST_GovernorScale();
+}
@@ -0,0 +1,396 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spritetools/spritetools_hierarchy.h"
+
+/* Place of an id that isn't in use */
+#define ST_HIERARCHY_NONE 0xFFFFFFFF
+
+/* Returns the place of a node by id, or ST_HIERARCHY_NONE */
+static u32 findPlace(st_hierarchy *hierarchy, u32 id)
+{
+  if (id >= hierarchy->nextId)
+    return ST_HIERARCHY_NONE;
+  return hierarchy->places[id];
+}
+
+/* Makes room for twice as many nodes */
+static u8 grow(st_hierarchy *hierarchy)
+{
+  u32 capacity = hierarchy->capacity * 2;
+  st_hierarchynode *nodes;
+  u32 *places;
+
+  nodes = realloc(hierarchy->nodes, capacity * sizeof(st_hierarchynode));
+  if (!nodes)
+    return 0;
+  hierarchy->nodes = nodes;
+  nodes = realloc(hierarchy->sorted, capacity * sizeof(st_hierarchynode));
+  if (!nodes)
+    return 0;
+  hierarchy->sorted = nodes;
+  places = realloc(hierarchy->places, capacity * sizeof(u32));
+  if (!places)
+    return 0;
+  hierarchy->places = places;
+  places = realloc(hierarchy->freeIds, capacity * sizeof(u32));
+  if (!places)
+    return 0;
+  hierarchy->freeIds = places;
+  places = realloc(hierarchy->scratch, capacity * 2 * sizeof(u32));
+  if (!places)
+    return 0;
+  hierarchy->scratch = places;
+  hierarchy->capacity = capacity;
+
+  return 1;
+}
+
+/* Puts the nodes back in an order with every parent before its children */
+/*   Nodes keep their order apart from ancestors being moved up in front */
+/*   of them, which is all a reparent can need */
+static void sortNodes(st_hierarchy *hierarchy)
+{
+  st_hierarchynode *nodes = hierarchy->nodes, *sorted = hierarchy->sorted;
+  u32 *moved = hierarchy->scratch, *stack = hierarchy->scratch +
+    hierarchy->capacity;
+  u32 out = 0, depth, i, j;
+
+  for (i = 0; i < hierarchy->count; i++)
+    moved[i] = ST_HIERARCHY_NONE;
+
+  for (i = 0; i < hierarchy->count; i++)
+  {
+    /* Gather the ancestors not placed yet, then place them top down */
+    depth = 0;
+    for (j = i; moved[j] == ST_HIERARCHY_NONE;)
+    {
+      stack[depth++] = j;
+      if (nodes[j].parent == ST_HIERARCHY_ROOT)
+        break;
+      j = nodes[j].parent;
+    }
+    while (depth)
+    {
+      j = stack[--depth];
+      sorted[out] = nodes[j];
+      moved[j] = out++;
+    }
+  }
+
+  for (i = 0; i < hierarchy->count; i++)
+  {
+    if (sorted[i].parent != ST_HIERARCHY_ROOT)
+      sorted[i].parent = moved[sorted[i].parent];
+    hierarchy->places[sorted[i].id] = i;
+  }
+
+  hierarchy->nodes = sorted;
+  hierarchy->sorted = nodes;
+  hierarchy->orderDirty = 0;
+}
+
+/*******************************\
+|*     Hierarchy Functions     *|
+\*******************************/
+/* Returns a pointer to a hierarchy */
+/*   Returns NULL if failed */
+/* Takes the number of nodes to make room for */
+st_hierarchy *ST_HierarchyCreate(u32 capacity)
+{
+  st_hierarchy *hierarchy = calloc(1, sizeof(st_hierarchy));
+  if (!hierarchy)
+    return NULL;
+
+  if (!capacity)
+    capacity = 16;
+  hierarchy->nodes = calloc(capacity, sizeof(st_hierarchynode));
+  hierarchy->sorted = calloc(capacity, sizeof(st_hierarchynode));
+  hierarchy->places = calloc(capacity, sizeof(u32));
+  hierarchy->freeIds = calloc(capacity, sizeof(u32));
+  hierarchy->scratch = calloc(capacity * 2, sizeof(u32));
+  if (!hierarchy->nodes || !hierarchy->sorted || !hierarchy->places ||
+    !hierarchy->freeIds || !hierarchy->scratch)
+  {
+    ST_HierarchyFree(hierarchy);
+    return NULL;
+  }
+  hierarchy->capacity = capacity;
+
+  return hierarchy;
+}
+
+/* Frees a hierarchy from memory */
+/*   Its entities are not freed */
+/* Takes a pointer to a hierarchy */
+void ST_HierarchyFree(st_hierarchy *hierarchy)
+{
+  if (!hierarchy)
+    return;
+
+  free(hierarchy->nodes);
+  free(hierarchy->sorted);
+  free(hierarchy->places);
+  free(hierarchy->freeIds);
+  free(hierarchy->scratch);
+  free(hierarchy);
+}
+
+/* Adds an entity to a hierarchy */
+/*   Children start at an offset from their parent, unrotated and */
+/*   unscaled. Roots start where their entity is */
+/* Takes a pointer to a hierarchy, the entity, the id of the parent (or */
+/*   ST_HIERARCHY_ROOT) and the offset from the parent */
+/* Returns the id of the node, or -1 on failure */
+s32 ST_HierarchyAdd(st_hierarchy *hierarchy, st_entity *entity, s32 parent,
+  double x, double y)
+{
+  st_hierarchynode *node;
+  u32 parentPlace = ST_HIERARCHY_NONE, id;
+
+  if (!entity || hierarchy->count >= 0x7FFFFFFF)
+    return -1;
+  if (parent != ST_HIERARCHY_ROOT)
+  {
+    if (parent < 0 ||
+      (parentPlace = findPlace(hierarchy, parent)) == ST_HIERARCHY_NONE)
+      return -1;
+  }
+  if (hierarchy->count >= hierarchy->capacity && !grow(hierarchy))
+    return -1;
+
+  /* New nodes go last, after their parent, so the order still holds */
+  id = hierarchy->freeCount ? hierarchy->freeIds[--hierarchy->freeCount] :
+    hierarchy->nextId++;
+  node = &hierarchy->nodes[hierarchy->count];
+  node->entity = entity;
+  node->id = id;
+  if (parent == ST_HIERARCHY_ROOT)
+  {
+    node->parent = ST_HIERARCHY_ROOT;
+    node->x = entity->xpos;
+    node->y = entity->ypos;
+    node->rotation = entity->rotation;
+    node->scale = entity->scale;
+  }
+  else
+  {
+    node->parent = parentPlace;
+    node->x = x;
+    node->y = y;
+    node->rotation = 0.0;
+    node->scale = 1.0;
+  }
+  node->dirty = 1;
+  hierarchy->places[id] = hierarchy->count++;
+
+  return id;
+}
+
+/* Removes a node from a hierarchy */
+/*   Its children are attached to its parent and stay where they are */
+/* Takes a pointer to a hierarchy and the id of the node */
+void ST_HierarchyRemove(st_hierarchy *hierarchy, u32 id)
+{
+  st_hierarchynode *nodes = hierarchy->nodes, *node, *child;
+  u32 place = findPlace(hierarchy, id), i;
+  double c, s, x;
+
+  if (place == ST_HIERARCHY_NONE)
+    return;
+  node = &nodes[place];
+
+  /* Fold the node's local values into its children's so they don't move */
+  c = cos(node->rotation) * node->scale;
+  s = sin(node->rotation) * node->scale;
+  for (i = 0; i < hierarchy->count; i++)
+  {
+    child = &nodes[i];
+    if (child->parent != (s32)place)
+      continue;
+    x = child->x;
+    child->x = node->x + x * c - child->y * s;
+    child->y = node->y + x * s + child->y * c;
+    child->rotation += node->rotation;
+    child->scale *= node->scale;
+    child->parent = node->parent;
+    child->dirty = 1;
+  }
+
+  hierarchy->count--;
+  memmove(node, node + 1, (hierarchy->count - place) *
+    sizeof(st_hierarchynode));
+  for (i = 0; i < hierarchy->count; i++)
+  {
+    if (nodes[i].parent > (s32)place)
+      nodes[i].parent--;
+    if (i >= place)
+      hierarchy->places[nodes[i].id] = i;
+  }
+
+  hierarchy->places[id] = ST_HIERARCHY_NONE;
+  hierarchy->freeIds[hierarchy->freeCount++] = id;
+}
+
+/* Attaches a node to another parent, keeping its local values */
+/* Takes a pointer to a hierarchy, the id of the node and the id of the */
+/*   parent (or ST_HIERARCHY_ROOT) */
+/* Returns 1 on success and 0 if the parent is the node or its child */
+u8 ST_HierarchySetParent(st_hierarchy *hierarchy, u32 id, s32 parent)
+{
+  st_hierarchynode *nodes = hierarchy->nodes;
+  u32 place = findPlace(hierarchy, id), parentPlace;
+  s32 ancestor;
+
+  if (place == ST_HIERARCHY_NONE)
+    return 0;
+
+  if (parent == ST_HIERARCHY_ROOT)
+  {
+    nodes[place].parent = ST_HIERARCHY_ROOT;
+    nodes[place].dirty = 1;
+    return 1;
+  }
+
+  if (parent < 0 ||
+    (parentPlace = findPlace(hierarchy, parent)) == ST_HIERARCHY_NONE)
+    return 0;
+  for (ancestor = parentPlace; ancestor != ST_HIERARCHY_ROOT;
+    ancestor = nodes[ancestor].parent)
+    if (ancestor == (s32)place)
+      return 0;
+
+  nodes[place].parent = parentPlace;
+  nodes[place].dirty = 1;
+  if (parentPlace > place)
+    hierarchy->orderDirty = 1;
+
+  return 1;
+}
+
+/* Sets the offset of a node from its parent */
+/* Takes a pointer to a hierarchy, the id of the node and an offset */
+void ST_HierarchySetPosition(st_hierarchy *hierarchy, u32 id,
+  double x, double y)
+{
+  st_hierarchynode *node = ST_HierarchyGetNode(hierarchy, id);
+  if (!node || (node->x == x && node->y == y))
+    return;
+
+  node->x = x;
+  node->y = y;
+  node->dirty = 1;
+}
+
+/* Sets the rotation of a node relative to its parent */
+/* Takes a pointer to a hierarchy, the id of the node and a rotation in */
+/*   radians */
+void ST_HierarchySetRotation(st_hierarchy *hierarchy, u32 id,
+  double rotation)
+{
+  st_hierarchynode *node = ST_HierarchyGetNode(hierarchy, id);
+  if (!node || node->rotation == rotation)
+    return;
+
+  node->rotation = rotation;
+  node->dirty = 1;
+}
+
+/* Sets the scale of a node relative to its parent */
+/* Takes a pointer to a hierarchy, the id of the node and a scale */
+void ST_HierarchySetScale(st_hierarchy *hierarchy, u32 id, double scale)
+{
+  st_hierarchynode *node = ST_HierarchyGetNode(hierarchy, id);
+  if (!node || node->scale == scale)
+    return;
+
+  node->scale = scale;
+  node->dirty = 1;
+}
+
+/* Returns a node of a hierarchy, or NULL if there isn't one */
+/*   The pointer is good until nodes are added, removed or reparented */
+/* Takes a pointer to a hierarchy and the id of the node */
+st_hierarchynode *ST_HierarchyGetNode(st_hierarchy *hierarchy, u32 id)
+{
+  u32 place = findPlace(hierarchy, id);
+
+  if (place == ST_HIERARCHY_NONE)
+    return NULL;
+  return &hierarchy->nodes[place];
+}
+
+/* Works out the world values of nodes that changed and their children, */
+/*   and gives them to their entities */
+/*   Roots whose entity was moved, turned or scaled count as changed */
+/* Takes a pointer to a hierarchy */
+void ST_HierarchyUpdate(st_hierarchy *hierarchy)
+{
+  st_hierarchynode *node, *parent;
+  st_entity *entity;
+  double c, s;
+  u32 i;
+
+  if (hierarchy->orderDirty)
+    sortNodes(hierarchy);
+
+  for (i = 0; i < hierarchy->count; i++)
+  {
+    node = &hierarchy->nodes[i];
+    entity = node->entity;
+
+    if (node->parent == ST_HIERARCHY_ROOT)
+    {
+      /* Changes made through the hierarchy win over the entity's own */
+      if (!node->dirty && (entity->xpos != node->worldX ||
+        entity->ypos != node->worldY ||
+        entity->rotation != node->worldRotation ||
+        entity->scale != node->worldScale))
+      {
+        node->x = entity->xpos;
+        node->y = entity->ypos;
+        node->rotation = entity->rotation;
+        node->scale = entity->scale;
+        node->dirty = 1;
+      }
+      if (!node->dirty)
+        continue;
+
+      node->worldX = node->x;
+      node->worldY = node->y;
+      node->worldRotation = node->rotation;
+      node->worldScale = node->scale;
+    }
+    else
+    {
+      /* Parents come first, so a recomputed parent is still marked dirty */
+      parent = &hierarchy->nodes[node->parent];
+      if (parent->dirty)
+        node->dirty = 1;
+      if (!node->dirty)
+        continue;
+
+      c = cos(parent->worldRotation) * parent->worldScale;
+      s = sin(parent->worldRotation) * parent->worldScale;
+      node->worldX = parent->worldX + node->x * c - node->y * s;
+      node->worldY = parent->worldY + node->x * s + node->y * c;
+      node->worldRotation = parent->worldRotation + node->rotation;
+      node->worldScale = parent->worldScale * node->scale;
+    }
+
+    entity->xpos = node->worldX;
+    entity->ypos = node->worldY;
+    entity->rotation = node->worldRotation;
+    entity->scale = node->worldScale;
+  }
+
+  for (i = 0; i < hierarchy->count; i++)
+    hierarchy->nodes[i].dirty = 0;
+}
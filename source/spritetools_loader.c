@@ -0,0 +1,381 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include "spritetools/spritetools_loader.h"
+#include "spritetools/spritetools_residency.h"
+
+/* Jobs are passed between the threads in two lists under one lock */
+static LightLock st_loaderLock;
+static LightEvent st_loaderEvent;
+static Thread st_loaderThread = NULL;
+static vu32 st_loaderQuit = 0;
+static st_loadjob *st_queueHead = NULL;
+static st_loadjob *st_queueTail = NULL;
+static st_loadjob *st_decodedHead = NULL;
+static st_loadjob *st_decodedTail = NULL;
+static u32 st_pending = 0; /* Only touched on the main thread */
+static u8 st_loaderReady = 0;
+
+/* Adds a job to the end of a list. The lock must be held */
+static void listPush(st_loadjob **head, st_loadjob **tail, st_loadjob *job)
+{
+  job->next = NULL;
+  if (*tail)
+    (*tail)->next = job;
+  else
+    *head = job;
+  *tail = job;
+}
+
+/* Decodes queued jobs until told to quit */
+/*   Only ordinary memory is touched here. Textures are made on the main */
+/*   thread so they never race the GPU or VRAM moves */
+static void loaderThreadMain(void *arg)
+{
+  st_loadjob *job;
+
+  (void)arg;
+  for (;;)
+  {
+    LightLock_Lock(&st_loaderLock);
+    job = st_queueHead;
+    if (job)
+    {
+      st_queueHead = job->next;
+      if (!st_queueHead)
+        st_queueTail = NULL;
+      __atomic_store_n(&job->state, ST_LOAD_LOADING, __ATOMIC_RELEASE);
+    }
+    LightLock_Unlock(&st_loaderLock);
+
+    if (!job)
+    {
+      if (__atomic_load_n(&st_loaderQuit, __ATOMIC_ACQUIRE))
+        break;
+      LightEvent_Wait(&st_loaderEvent);
+      continue;
+    }
+
+    ST_SpritesheetDecodeSource(&job->source, &job->decoded);
+
+    LightLock_Lock(&st_loaderLock);
+    __atomic_store_n(&job->state, ST_LOAD_DECODED, __ATOMIC_RELEASE);
+    listPush(&st_decodedHead, &st_decodedTail, job);
+    LightLock_Unlock(&st_loaderLock);
+  }
+}
+
+/* Starts the loader thread if it isn't running */
+static u8 startThread(void)
+{
+  s32 prio = 0x30;
+
+  if (st_loaderThread)
+    return 1;
+
+  /* One step below the game so decoding only uses its spare time */
+  st_loaderQuit = 0;
+  svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+  st_loaderThread = threadCreate(loaderThreadMain, NULL,
+    ST_LOADER_THREAD_STACK, prio + 1, ST_LOADER_THREAD_CORE, false);
+
+  return st_loaderThread != NULL;
+}
+
+/* Makes the texture of a decoded job and hands it to the cache and the */
+/*   residency manager, making room the same way the direct loaders do */
+static st_spritesheet *uploadJob(st_loadjob *job)
+{
+  st_spritesheet *spritesheet;
+
+  /* A source that couldn't be decoded won't load with more room either */
+  if (job->decoded.source.type == ST_SOURCE_NONE)
+    return NULL;
+
+  spritesheet = ST_SpritesheetLoadSource(&job->decoded.source);
+  if (!spritesheet && ST_ResidencyTrim(0))
+    spritesheet = ST_SpritesheetLoadSource(&job->decoded.source);
+  if (!spritesheet)
+    return NULL;
+
+  if (job->borrowed)
+    return ST_SpritesheetTrackBorrowed(spritesheet, &job->source);
+  return ST_SpritesheetTrackSource(spritesheet, &job->source);
+}
+
+/* Finishes a job and lets the game know. Frees it if it was released */
+static void finishJob(st_loadjob *job, st_loadstate state)
+{
+  job->state = state;
+  st_pending--;
+
+  if (job->released)
+  {
+    if (job->spritesheet)
+      ST_SpritesheetFreeSpritesheet(job->spritesheet);
+    free(job);
+    return;
+  }
+
+  if (job->callback)
+    job->callback(job, job->data);
+}
+
+/* Queues a job for a source */
+static st_loadjob *queueSource(const st_spritesheetsource *source,
+  st_loadcallback callback, void *data, u8 borrowed)
+{
+  st_loadjob *job;
+
+  if (!st_loaderReady && !ST_LoaderInit())
+    return NULL;
+  if (!startThread())
+    return NULL;
+
+  job = calloc(1, sizeof(st_loadjob));
+  if (!job)
+    return NULL;
+  job->source = *source;
+  job->callback = callback;
+  job->data = data;
+  job->borrowed = borrowed;
+  job->state = ST_LOAD_QUEUED;
+  st_pending++;
+
+  /* Already loaded content skips the thread but still finishes in */
+  /*   ST_LoaderUpdate, so callbacks always run from the same place */
+  job->spritesheet = ST_SpritesheetCacheFind(source);
+  if (job->spritesheet)
+  {
+    job->cached = 1;
+    job->state = ST_LOAD_DECODED;
+    LightLock_Lock(&st_loaderLock);
+    listPush(&st_decodedHead, &st_decodedTail, job);
+    LightLock_Unlock(&st_loaderLock);
+    return job;
+  }
+
+  LightLock_Lock(&st_loaderLock);
+  listPush(&st_queueHead, &st_queueTail, job);
+  LightLock_Unlock(&st_loaderLock);
+  LightEvent_Signal(&st_loaderEvent);
+
+  return job;
+}
+
+/****************************\
+|*     Loader Functions     *|
+\****************************/
+/* Inits the loader */
+/* Returns 1 on success, 0 on failure */
+u8 ST_LoaderInit(void)
+{
+  if (st_loaderReady)
+    return 1;
+
+  LightLock_Init(&st_loaderLock);
+  LightEvent_Init(&st_loaderEvent, RESET_ONESHOT);
+  st_queueHead = st_queueTail = NULL;
+  st_decodedHead = st_decodedTail = NULL;
+  st_pending = 0;
+  st_loaderReady = 1;
+
+  return 1;
+}
+
+/* Cancels every queued load, waits for the current one and stops the */
+/*   loader thread */
+/* Returns 1 on success, 0 on failure */
+u8 ST_LoaderFini(void)
+{
+  st_loadjob *job, *next;
+
+  if (!st_loaderReady)
+    return 1;
+
+  LightLock_Lock(&st_loaderLock);
+  job = st_queueHead;
+  st_queueHead = st_queueTail = NULL;
+  LightLock_Unlock(&st_loaderLock);
+
+  for (; job; job = next)
+  {
+    next = job->next;
+    job->state = ST_LOAD_CANCELLED;
+    st_pending--;
+    if (job->released)
+      free(job);
+  }
+
+  if (st_loaderThread)
+  {
+    __atomic_store_n(&st_loaderQuit, 1, __ATOMIC_RELEASE);
+    LightEvent_Signal(&st_loaderEvent);
+    threadJoin(st_loaderThread, U64_MAX);
+    threadFree(st_loaderThread);
+    st_loaderThread = NULL;
+  }
+
+  /* Hand over whatever was decoded before the thread stopped */
+  ST_LoaderUpdate();
+  st_loaderReady = 0;
+
+  return 1;
+}
+
+/* Queues a spritesheet to be loaded from a source */
+/*   The spritesheet may be evicted and later reloaded from the source, so */
+/*   its buffer must stay valid until the spritesheet is freed */
+/* Takes pointer to a source, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueue(const st_spritesheetsource *source,
+  st_loadcallback callback, void *data)
+{
+  return queueSource(source, callback, data, 0);
+}
+
+/* Queues a spritesheet to be loaded from a PNG file */
+/* Takes buffer, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueuePNG(const void *buffer, st_loadcallback callback,
+  void *data)
+{
+  st_spritesheetsource source = {ST_SOURCE_PNG, buffer, 0, 0, 0,
+    ST_PLACE_AUTO};
+  return queueSource(&source, callback, data, 1);
+}
+
+/* Queues a spritesheet to be loaded from a BMP file */
+/* Takes buffer, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueueBMP(const void *buffer, st_loadcallback callback,
+  void *data)
+{
+  st_spritesheetsource source = {ST_SOURCE_BMP, buffer, 0, 0, 0,
+    ST_PLACE_AUTO};
+  return queueSource(&source, callback, data, 1);
+}
+
+/* Queues a spritesheet to be loaded from a JPEG file */
+/* Takes buffer, its size, a callback (or NULL) and data for it */
+/* Returns pointer to st_loadjob or NULL on failure */
+st_loadjob *ST_LoaderQueueJPEG(const void *buffer, unsigned long buffer_size,
+  st_loadcallback callback, void *data)
+{
+  st_spritesheetsource source = {ST_SOURCE_JPEG, buffer, buffer_size, 0, 0,
+    ST_PLACE_AUTO};
+  return queueSource(&source, callback, data, 1);
+}
+
+/* Finishes decoded loads and runs their callbacks */
+/*   Called by ST_RenderEndRender, but can be called more often */
+/* Returns the number of loads still queued or decoding */
+u32 ST_LoaderUpdate(void)
+{
+  st_loadjob *job, *next;
+
+  if (!st_loaderReady)
+    return 0;
+
+  LightLock_Lock(&st_loaderLock);
+  job = st_decodedHead;
+  st_decodedHead = st_decodedTail = NULL;
+  LightLock_Unlock(&st_loaderLock);
+
+  for (; job; job = next)
+  {
+    next = job->next;
+
+    /* Textures, caching, residency and VRAM moves only ever happen on */
+    /*   this thread */
+    if (!job->cached)
+    {
+      if (!job->released)
+        job->spritesheet = uploadJob(job);
+      ST_SpritesheetFreeDecoded(&job->decoded);
+    }
+    finishJob(job, job->spritesheet ? ST_LOAD_DONE : ST_LOAD_FAILED);
+  }
+
+  return st_pending;
+}
+
+/* Returns the state of a load */
+/* Takes pointer to st_loadjob */
+st_loadstate ST_LoaderState(st_loadjob *job)
+{
+  return __atomic_load_n(&job->state, __ATOMIC_ACQUIRE);
+}
+
+/* Returns 1 if a load has finished one way or another, 0 if not */
+/* Takes pointer to st_loadjob */
+u8 ST_LoaderFinished(st_loadjob *job)
+{
+  return ST_LoaderState(job) >= ST_LOAD_DONE;
+}
+
+/* Returns the loaded spritesheet, or NULL if it isn't done */
+/* Takes pointer to st_loadjob */
+st_spritesheet *ST_LoaderSpritesheet(st_loadjob *job)
+{
+  if (ST_LoaderState(job) != ST_LOAD_DONE)
+    return NULL;
+  return job->spritesheet;
+}
+
+/* Cancels a load that hasn't started decoding yet */
+/* Takes pointer to st_loadjob */
+/* Returns 1 if it was cancelled, 0 if it's too late */
+u8 ST_LoaderCancel(st_loadjob *job)
+{
+  st_loadjob *prev = NULL, *it;
+
+  LightLock_Lock(&st_loaderLock);
+  for (it = st_queueHead; it && it != job; it = it->next)
+    prev = it;
+  if (!it)
+  {
+    LightLock_Unlock(&st_loaderLock);
+    return 0;
+  }
+
+  if (prev)
+    prev->next = job->next;
+  else
+    st_queueHead = job->next;
+  if (st_queueTail == job)
+    st_queueTail = prev;
+  job->state = ST_LOAD_CANCELLED;
+  LightLock_Unlock(&st_loaderLock);
+
+  st_pending--;
+  return 1;
+}
+
+/* Returns the number of loads still queued or decoding */
+u32 ST_LoaderPending(void)
+{
+  return st_pending;
+}
+
+/* Frees a load handle, not the spritesheet it loaded */
+/*   Unfinished loads are cancelled if they can be, otherwise their */
+/*   spritesheet is freed when it arrives */
+/* Takes pointer to st_loadjob */
+void ST_LoaderFree(st_loadjob *job)
+{
+  if (!job)
+    return;
+
+  if (ST_LoaderFinished(job) || ST_LoaderCancel(job))
+  {
+    free(job);
+    return;
+  }
+  job->released = 1;
+}
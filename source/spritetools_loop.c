@@ -0,0 +1,248 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <math.h>
+#include "spritetools/spritetools_loop.h"
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+/* System ticks in a millisecond */
+#define TICKS_PER_MS (SYSCLOCK_ARM11 / 1000.0)
+
+/* Returns the tracked state of an entity or NULL if it isn't tracked */
+static st_loopstate *findState(st_loop *loop, st_entity *entity)
+{
+  u32 i;
+  for (i = 0; i < loop->stateCount; i++)
+  {
+    if (loop->states[i].entity == entity)
+      return &loop->states[i];
+  }
+  return NULL;
+}
+
+/* Copies an entity's current position into the previous position */
+static void snapState(st_loopstate *state)
+{
+  state->prevx = state->entity->xpos;
+  state->prevy = state->entity->ypos;
+  state->prevrot = state->entity->rotation;
+}
+
+/**************************\
+|*     Loop Functions     *|
+\**************************/
+/* Returns a pointer to a loop */
+/*   Returns NULL if failed */
+/* Takes number of updates per second, an update and a render function, */
+/*   and user data passed to both */
+st_loop *ST_LoopCreate(double rate, st_loopupdate update,
+  st_looprender render, void *data)
+{
+  st_loop *temploop;
+
+  if (rate <= 0.0)
+    return NULL;
+
+  temploop = calloc(sizeof(st_loop), 1);
+  if (!temploop)
+    return NULL;
+
+  temploop->step = 1000.0 / rate;
+  temploop->maxSteps = ST_LOOP_DEFAULT_MAX_STEPS;
+  temploop->update = update;
+  temploop->render = render;
+  temploop->data = data;
+  temploop->lastTick = svcGetSystemTick();
+
+  return temploop;
+}
+
+/* Frees a loop from memory */
+/* Takes a pointer to a loop */
+void ST_LoopFree(st_loop *loop)
+{
+  if (!loop)
+    return;
+  free(loop->states);
+  free(loop);
+}
+
+/* Sets the most updates a single frame may catch up on */
+/* Takes a pointer to a loop and a number of updates */
+void ST_LoopSetMaxSteps(st_loop *loop, u32 maxSteps)
+{
+  if (maxSteps < 1)
+    maxSteps = 1;
+  loop->maxSteps = maxSteps;
+}
+
+/* Sets an entity pool to flush after every update */
+/*   Destroyed entities are untracked before their slots are reused */
+/* Takes a pointer to a loop and a pointer to an entity pool (or NULL) */
+void ST_LoopSetPool(st_loop *loop, st_entitypool *pool)
+{
+  loop->pool = pool;
+}
+
+/* Runs one frame: as many fixed updates as time allows, then a render */
+/* Takes a pointer to a loop */
+/* Returns the interpolation value given to the render function */
+double ST_LoopTick(st_loop *loop)
+{
+  u64 tick = svcGetSystemTick();
+  u32 steps = 0;
+  u32 i;
+  st_loopstate *state;
+
+  loop->accumulator += (tick - loop->lastTick) / TICKS_PER_MS;
+  loop->lastTick = tick;
+
+  while (loop->accumulator >= loop->step)
+  {
+    /* Drop whatever time is left instead of spiraling */
+    if (steps >= loop->maxSteps)
+    {
+      loop->accumulator = 0.0;
+      break;
+    }
+
+    for (i = 0; i < loop->stateCount; i++)
+      snapState(&loop->states[i]);
+    if (loop->update)
+      loop->update(loop->step, loop->data);
+    if (loop->pool)
+    {
+      for (i = 0; i < loop->pool->destroyedCount; i++)
+        ST_LoopUntrackEntity(loop, &loop->pool->entities[
+          ST_HANDLE_INDEX(loop->pool->destroyed[i])]);
+      ST_EntityPoolFlush(loop->pool);
+    }
+    loop->accumulator -= loop->step;
+    loop->stepCount++;
+    steps++;
+  }
+
+  loop->alpha = loop->accumulator / loop->step;
+
+  if (!loop->render)
+    return loop->alpha;
+
+  /* Draw tracked entities between their last two states... */
+  for (i = 0; i < loop->stateCount; i++)
+  {
+    state = &loop->states[i];
+    state->currx = state->entity->xpos;
+    state->curry = state->entity->ypos;
+    state->currrot = state->entity->rotation;
+    state->entity->xpos = state->prevx +
+      (state->currx - state->prevx) * loop->alpha;
+    state->entity->ypos = state->prevy +
+      (state->curry - state->prevy) * loop->alpha;
+    /* Turn the short way, so crossing a wrap doesn't spin all the way round */
+    state->entity->rotation = state->prevrot +
+      remainder(state->currrot - state->prevrot, 2 * PI) * loop->alpha;
+  }
+
+  loop->render(loop->alpha, loop->data);
+
+  /* ...then put their real values back */
+  for (i = 0; i < loop->stateCount; i++)
+  {
+    state = &loop->states[i];
+    state->entity->xpos = state->currx;
+    state->entity->ypos = state->curry;
+    state->entity->rotation = state->currrot;
+  }
+
+  return loop->alpha;
+}
+
+/* Runs frames until ST_LoopStop is called or the app is closed */
+/* Takes a pointer to a loop */
+void ST_LoopRun(st_loop *loop)
+{
+  loop->running = 1;
+  loop->lastTick = svcGetSystemTick();
+  loop->accumulator = 0.0;
+
+  while (loop->running && aptMainLoop())
+    ST_LoopTick(loop);
+
+  loop->running = 0;
+}
+
+/* Makes ST_LoopRun return after the current frame */
+/* Takes a pointer to a loop */
+void ST_LoopStop(st_loop *loop)
+{
+  loop->running = 0;
+}
+
+/* Returns the interpolation value of the last rendered frame */
+/* Takes a pointer to a loop */
+double ST_LoopAlpha(st_loop *loop)
+{
+  return loop->alpha;
+}
+
+/****************************\
+|*     Entity Smoothing     *|
+\****************************/
+/* Starts interpolating an entity when rendering */
+/* Takes a pointer to a loop and a pointer to an entity */
+/* Returns 1 on success and 0 on failure */
+u8 ST_LoopTrackEntity(st_loop *loop, st_entity *entity)
+{
+  st_loopstate *states;
+  u32 capacity;
+
+  if (!entity)
+    return 0;
+  if (findState(loop, entity))
+    return 1;
+
+  if (loop->stateCount >= loop->stateCapacity)
+  {
+    capacity = loop->stateCapacity ? loop->stateCapacity * 2 : 16;
+    states = realloc(loop->states, capacity * sizeof(st_loopstate));
+    if (!states)
+      return 0;
+    loop->states = states;
+    loop->stateCapacity = capacity;
+  }
+
+  loop->states[loop->stateCount].entity = entity;
+  snapState(&loop->states[loop->stateCount]);
+  loop->stateCount++;
+
+  return 1;
+}
+
+/* Stops interpolating an entity */
+/* Takes a pointer to a loop and a pointer to an entity */
+void ST_LoopUntrackEntity(st_loop *loop, st_entity *entity)
+{
+  st_loopstate *state = findState(loop, entity);
+  if (!state)
+    return;
+
+  /* Order doesn't matter, so fill the hole with the last state */
+  *state = loop->states[--loop->stateCount];
+}
+
+/* Makes a tracked entity skip interpolation for its next frame */
+/* Takes a pointer to a loop and a pointer to an entity */
+void ST_LoopSnapEntity(st_loop *loop, st_entity *entity)
+{
+  st_loopstate *state = findState(loop, entity);
+  if (state)
+    snapState(state);
+}
@@ -0,0 +1,546 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <string.h>
+#include "spritetools/spritetools_pixel.h"
+
+#if !defined(ST_PIXEL_NO_SIMD) && defined(__SSE2__)
+#define ST_PIXEL_SSE2
+#include <emmintrin.h>
+#elif !defined(ST_PIXEL_NO_SIMD) && defined(__ARM_NEON)
+#define ST_PIXEL_NEON
+#include <arm_neon.h>
+#endif
+
+/* Returns offset in texels of a texel inside an 8x8 tile (Morton order) */
+static inline u32 morton(u32 x, u32 y)
+{
+  return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
+    ((x & 4) << 2) | ((y & 4) << 3);
+}
+
+/* Returns x * a / 255, rounded */
+static inline u32 mul255(u32 x, u32 a)
+{
+  u32 t = x * a + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+/* Packs one RGBA8 texel into a 16 bit format */
+static inline u16 pack16(const u8 *p, u16 format)
+{
+  switch (format)
+  {
+    case ST_TEXFMT_RGB565:
+      return ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+    case ST_TEXFMT_RGB5A1:
+      return ((p[0] >> 3) << 11) | ((p[1] >> 3) << 6) | ((p[2] >> 3) << 1) |
+        (p[3] >> 7);
+    default:
+      return ((p[0] >> 4) << 12) | ((p[1] >> 4) << 8) | ((p[2] >> 4) << 4) |
+        (p[3] >> 4);
+  }
+}
+
+/************************\
+|*     SSE2 Kernels     *|
+\************************/
+#if defined(ST_PIXEL_SSE2)
+
+/* Reverses the bytes of four texels */
+static inline __m128i swap4(__m128i v)
+{
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  v = _mm_shufflelo_epi16(v, 0xB1);
+  return _mm_shufflehi_epi16(v, 0xB1);
+}
+
+/* Returns how many texels were handled, the rest are done without SIMD */
+static u32 swapSimd(const u32 *src, u32 *dst, u32 count)
+{
+  u32 i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+    _mm_storeu_si128((__m128i *)(dst + i),
+      swap4(_mm_loadu_si128((const __m128i *)(src + i))));
+  return i;
+}
+
+/* Premultiplies two texels widened to 16 bits a channel */
+static inline __m128i premultiply2(__m128i v)
+{
+  const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(128));
+
+  t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+  return _mm_or_si128(_mm_andnot_si128(alphaMask, t),
+    _mm_and_si128(alphaMask, v));
+}
+
+static u32 premultiplySimd(u8 *rgba, u32 count)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i v;
+  u32 i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+  {
+    v = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+    v = _mm_packus_epi16(premultiply2(_mm_unpacklo_epi8(v, zero)),
+      premultiply2(_mm_unpackhi_epi8(v, zero)));
+    _mm_storeu_si128((__m128i *)(rgba + i * 4), v);
+  }
+  return i;
+}
+
+/* Packs four texels into the low 16 bits of each lane */
+static inline __m128i pack4(__m128i v, u16 format)
+{
+  const __m128i byte = _mm_set1_epi32(0xFF);
+  __m128i r = _mm_and_si128(v, byte);
+  __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), byte);
+  __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), byte);
+  __m128i a = _mm_srli_epi32(v, 24);
+
+  switch (format)
+  {
+    case ST_TEXFMT_RGB565:
+      return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_srli_epi32(r, 3), 11),
+        _mm_slli_epi32(_mm_srli_epi32(g, 2), 5)), _mm_srli_epi32(b, 3));
+    case ST_TEXFMT_RGB5A1:
+      return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_srli_epi32(r, 3), 11),
+        _mm_slli_epi32(_mm_srli_epi32(g, 3), 6)), _mm_or_si128(
+        _mm_slli_epi32(_mm_srli_epi32(b, 3), 1), _mm_srli_epi32(a, 7)));
+    default:
+      return _mm_or_si128(_mm_or_si128(
+        _mm_slli_epi32(_mm_srli_epi32(r, 4), 12),
+        _mm_slli_epi32(_mm_srli_epi32(g, 4), 8)), _mm_or_si128(
+        _mm_slli_epi32(_mm_srli_epi32(b, 4), 4), _mm_srli_epi32(a, 4)));
+  }
+}
+
+static u32 pack16Simd(const u8 *rgba, u16 *dst, u32 count, u16 format)
+{
+  /* packs is signed, so values are moved into its range and back */
+  const __m128i bias32 = _mm_set1_epi32(0x8000);
+  const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+  __m128i lo, hi;
+  u32 i;
+
+  for (i = 0; i + 8 <= count; i += 8)
+  {
+    lo = pack4(_mm_loadu_si128((const __m128i *)(rgba + i * 4)), format);
+    hi = pack4(_mm_loadu_si128((const __m128i *)(rgba + i * 4 + 16)),
+      format);
+    lo = _mm_packs_epi32(_mm_sub_epi32(lo, bias32),
+      _mm_sub_epi32(hi, bias32));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(lo, bias16));
+  }
+  return i;
+}
+
+/* Tiles a whole 8x8 tile of 32 bit texels */
+static void tile32(const u32 *rows[8], u32 *tile, u8 swap)
+{
+  __m128i a0, a1, b0, b1;
+  u32 *base;
+  u32 y;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    a0 = _mm_loadu_si128((const __m128i *)rows[y]);
+    a1 = _mm_loadu_si128((const __m128i *)(rows[y] + 4));
+    b0 = _mm_loadu_si128((const __m128i *)rows[y + 1]);
+    b1 = _mm_loadu_si128((const __m128i *)(rows[y + 1] + 4));
+    if (swap)
+    {
+      a0 = swap4(a0);
+      a1 = swap4(a1);
+      b0 = swap4(b0);
+      b1 = swap4(b1);
+    }
+
+    /* Pairs of texels from two rows sit side by side in a tile */
+    base = tile + morton(0, y);
+    _mm_storeu_si128((__m128i *)base, _mm_unpacklo_epi64(a0, b0));
+    _mm_storeu_si128((__m128i *)(base + 4), _mm_unpackhi_epi64(a0, b0));
+    _mm_storeu_si128((__m128i *)(base + 16), _mm_unpacklo_epi64(a1, b1));
+    _mm_storeu_si128((__m128i *)(base + 20), _mm_unpackhi_epi64(a1, b1));
+  }
+}
+
+/* Tiles a whole 8x8 tile of 16 bit texels */
+static void tile16(const u16 *rows[8], u16 *tile)
+{
+  __m128i a, b;
+  u16 *base;
+  u32 y;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    a = _mm_loadu_si128((const __m128i *)rows[y]);
+    b = _mm_loadu_si128((const __m128i *)rows[y + 1]);
+    base = tile + morton(0, y);
+    _mm_storeu_si128((__m128i *)base, _mm_unpacklo_epi32(a, b));
+    _mm_storeu_si128((__m128i *)(base + 16), _mm_unpackhi_epi32(a, b));
+  }
+}
+
+/************************\
+|*     NEON Kernels     *|
+\************************/
+#elif defined(ST_PIXEL_NEON)
+
+static inline uint32x4_t swap4(uint32x4_t v)
+{
+  return vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(v)));
+}
+
+static u32 swapSimd(const u32 *src, u32 *dst, u32 count)
+{
+  u32 i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+    vst1q_u32(dst + i, swap4(vld1q_u32(src + i)));
+  return i;
+}
+
+/* Returns x * a / 255, rounded, for eight channels */
+static inline uint8x8_t mul255x8(uint8x8_t x, uint8x8_t a)
+{
+  uint16x8_t m = vmull_u8(x, a);
+  return vrshrn_n_u16(vaddq_u16(m, vrshrq_n_u16(m, 8)), 8);
+}
+
+static u32 premultiplySimd(u8 *rgba, u32 count)
+{
+  uint8x8x4_t v;
+  u32 i;
+
+  for (i = 0; i + 8 <= count; i += 8)
+  {
+    v = vld4_u8(rgba + i * 4);
+    v.val[0] = mul255x8(v.val[0], v.val[3]);
+    v.val[1] = mul255x8(v.val[1], v.val[3]);
+    v.val[2] = mul255x8(v.val[2], v.val[3]);
+    vst4_u8(rgba + i * 4, v);
+  }
+  return i;
+}
+
+static u32 pack16Simd(const u8 *rgba, u16 *dst, u32 count, u16 format)
+{
+  uint8x8x4_t v;
+  uint16x8_t out;
+  u32 i;
+
+  for (i = 0; i + 8 <= count; i += 8)
+  {
+    v = vld4_u8(rgba + i * 4);
+    switch (format)
+    {
+      case ST_TEXFMT_RGB565:
+        out = vorrq_u16(vorrq_u16(
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[0], 3)), 11),
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[1], 2)), 5)),
+          vmovl_u8(vshr_n_u8(v.val[2], 3)));
+        break;
+      case ST_TEXFMT_RGB5A1:
+        out = vorrq_u16(vorrq_u16(
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[0], 3)), 11),
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[1], 3)), 6)), vorrq_u16(
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[2], 3)), 1),
+          vmovl_u8(vshr_n_u8(v.val[3], 7))));
+        break;
+      default:
+        out = vorrq_u16(vorrq_u16(
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[0], 4)), 12),
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[1], 4)), 8)), vorrq_u16(
+          vshlq_n_u16(vmovl_u8(vshr_n_u8(v.val[2], 4)), 4),
+          vmovl_u8(vshr_n_u8(v.val[3], 4))));
+        break;
+    }
+    vst1q_u16(dst + i, out);
+  }
+  return i;
+}
+
+static void tile32(const u32 *rows[8], u32 *tile, u8 swap)
+{
+  uint32x4_t a0, a1, b0, b1;
+  u32 *base;
+  u32 y;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    a0 = vld1q_u32(rows[y]);
+    a1 = vld1q_u32(rows[y] + 4);
+    b0 = vld1q_u32(rows[y + 1]);
+    b1 = vld1q_u32(rows[y + 1] + 4);
+    if (swap)
+    {
+      a0 = swap4(a0);
+      a1 = swap4(a1);
+      b0 = swap4(b0);
+      b1 = swap4(b1);
+    }
+
+    /* Pairs of texels from two rows sit side by side in a tile */
+    base = tile + morton(0, y);
+    vst1q_u32(base, vcombine_u32(vget_low_u32(a0), vget_low_u32(b0)));
+    vst1q_u32(base + 4, vcombine_u32(vget_high_u32(a0), vget_high_u32(b0)));
+    vst1q_u32(base + 16, vcombine_u32(vget_low_u32(a1), vget_low_u32(b1)));
+    vst1q_u32(base + 20,
+      vcombine_u32(vget_high_u32(a1), vget_high_u32(b1)));
+  }
+}
+
+static void tile16(const u16 *rows[8], u16 *tile)
+{
+  uint32x4x2_t z;
+  u16 *base;
+  u32 y;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    z = vzipq_u32(vreinterpretq_u32_u16(vld1q_u16(rows[y])),
+      vreinterpretq_u32_u16(vld1q_u16(rows[y + 1])));
+    base = tile + morton(0, y);
+    vst1q_u16(base, vreinterpretq_u16_u32(z.val[0]));
+    vst1q_u16(base + 16, vreinterpretq_u16_u32(z.val[1]));
+  }
+}
+
+/**************************\
+|*     Scalar Kernels     *|
+\**************************/
+#else
+
+/* Offset of each pair of texels in a tile row from the row's start */
+static const u8 st_pairOffsets[4] = {0, 4, 16, 20};
+
+static u32 swapSimd(const u32 *src, u32 *dst, u32 count)
+{
+  (void)src;
+  (void)dst;
+  (void)count;
+  return 0;
+}
+
+static u32 premultiplySimd(u8 *rgba, u32 count)
+{
+  (void)rgba;
+  (void)count;
+  return 0;
+}
+
+static u32 pack16Simd(const u8 *rgba, u16 *dst, u32 count, u16 format)
+{
+  (void)rgba;
+  (void)dst;
+  (void)count;
+  (void)format;
+  return 0;
+}
+
+/* Pairs of texels are moved together. On the ARM11 each swap is one REV */
+static void tile32(const u32 *rows[8], u32 *tile, u8 swap)
+{
+  const u32 *a, *b;
+  u32 *base, *out;
+  u32 y, p;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    a = rows[y];
+    b = rows[y + 1];
+    base = tile + morton(0, y);
+    for (p = 0; p < 4; p++)
+    {
+      out = base + st_pairOffsets[p];
+      if (swap)
+      {
+        out[0] = __builtin_bswap32(a[p * 2]);
+        out[1] = __builtin_bswap32(a[p * 2 + 1]);
+        out[2] = __builtin_bswap32(b[p * 2]);
+        out[3] = __builtin_bswap32(b[p * 2 + 1]);
+      }
+      else
+      {
+        out[0] = a[p * 2];
+        out[1] = a[p * 2 + 1];
+        out[2] = b[p * 2];
+        out[3] = b[p * 2 + 1];
+      }
+    }
+  }
+}
+
+static void tile16(const u16 *rows[8], u16 *tile)
+{
+  const u16 *a, *b;
+  u16 *base, *out;
+  u32 y, p;
+
+  for (y = 0; y < 8; y += 2)
+  {
+    a = rows[y];
+    b = rows[y + 1];
+    base = tile + morton(0, y);
+    for (p = 0; p < 4; p++)
+    {
+      out = base + st_pairOffsets[p];
+      out[0] = a[p * 2];
+      out[1] = a[p * 2 + 1];
+      out[2] = b[p * 2];
+      out[3] = b[p * 2 + 1];
+    }
+  }
+}
+
+#endif
+
+/***************************\
+|*     Pixel Functions     *|
+\***************************/
+/* Returns the name of the kernels compiled in ("sse2", "neon" or "scalar") */
+const char *ST_PixelPath(void)
+{
+#if defined(ST_PIXEL_SSE2)
+  return "sse2";
+#elif defined(ST_PIXEL_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+/* Reverses the bytes of RGBA8 texels, turning RGBA into the GPU's ABGR */
+/*   src and dst can be the same */
+/* Takes source, destination and number of texels */
+void ST_PixelSwapRGBA8(const u32 *src, u32 *dst, u32 count)
+{
+  u32 i = swapSimd(src, dst, count);
+
+  for (; i < count; i++)
+    dst[i] = __builtin_bswap32(src[i]);
+}
+
+/* Multiplies the color of RGBA8 texels by their alpha, in place */
+/* Takes texels and number of texels */
+void ST_PixelPremultiply(u8 *rgba, u32 count)
+{
+  u32 i = premultiplySimd(rgba, count);
+  u8 *p;
+
+  for (; i < count; i++)
+  {
+    p = rgba + i * 4;
+    p[0] = mul255(p[0], p[3]);
+    p[1] = mul255(p[1], p[3]);
+    p[2] = mul255(p[2], p[3]);
+  }
+}
+
+/* Packs RGBA8 texels into a 16 bit format */
+/* Takes source, destination, number of texels and format (RGB565, RGB5A1 */
+/*   or RGBA4) */
+/* Returns 1 on success, 0 if the format isn't 16 bit */
+u8 ST_PixelPack16(const u8 *rgba, u16 *dst, u32 count, u16 format)
+{
+  u32 i;
+
+  if (ST_TextureFormatBits(format) != 16)
+    return 0;
+
+  for (i = pack16Simd(rgba, dst, count, format); i < count; i++)
+    dst[i] = pack16(rgba + i * 4, format);
+  return 1;
+}
+
+/* Tiles a linear image of 32 bit texels into a texture */
+/*   The image's top row goes to the top of the texture, which the GPU */
+/*   stores last. Texels of the texture outside the image are left alone */
+/* Takes source, source stride in texels, image width and height, */
+/*   destination, texture width and height (multiples of 8), and whether */
+/*   to swap RGBA into ABGR on the way */
+void ST_PixelTile32(const u32 *src, u32 stride, u32 width, u32 height,
+  u32 *dst, u32 texWidth, u32 texHeight, u8 swap)
+{
+  const u32 *rows[8];
+  u32 top = texHeight - height; /* First texture row holding the image */
+  u32 tx, ty, x, y, v;
+  u32 *tile;
+
+  for (ty = 0; ty < texHeight; ty += 8)
+  {
+    if (ty + 8 <= top)
+      continue;
+    for (tx = 0; tx < width; tx += 8)
+    {
+      tile = dst + ty * texWidth + tx * 8;
+      if (tx + 8 <= width && ty >= top)
+      {
+        for (y = 0; y < 8; y++)
+          rows[y] = src + (texHeight - 1 - ty - y) * stride + tx;
+        tile32(rows, tile, swap);
+        continue;
+      }
+
+      /* Tiles on the image's edges go a texel at a time */
+      for (y = 0; y < 8; y++)
+      {
+        if (ty + y < top)
+          continue;
+        for (x = 0; x < 8 && tx + x < width; x++)
+        {
+          v = src[(texHeight - 1 - ty - y) * stride + tx + x];
+          tile[morton(x, y)] = swap ? __builtin_bswap32(v) : v;
+        }
+      }
+    }
+  }
+}
+
+/* Tiles a linear image of 16 bit texels into a texture */
+/* Takes source, source stride in texels, image width and height, */
+/*   destination, and texture width and height (multiples of 8) */
+void ST_PixelTile16(const u16 *src, u32 stride, u32 width, u32 height,
+  u16 *dst, u32 texWidth, u32 texHeight)
+{
+  const u16 *rows[8];
+  u32 top = texHeight - height;
+  u32 tx, ty, x, y;
+  u16 *tile;
+
+  for (ty = 0; ty < texHeight; ty += 8)
+  {
+    if (ty + 8 <= top)
+      continue;
+    for (tx = 0; tx < width; tx += 8)
+    {
+      tile = dst + ty * texWidth + tx * 8;
+      if (tx + 8 <= width && ty >= top)
+      {
+        for (y = 0; y < 8; y++)
+          rows[y] = src + (texHeight - 1 - ty - y) * stride + tx;
+        tile16(rows, tile);
+        continue;
+      }
+
+      for (y = 0; y < 8; y++)
+      {
+        if (ty + y < top)
+          continue;
+        for (x = 0; x < 8 && tx + x < width; x++)
+          tile[morton(x, y)] = src[(texHeight - 1 - ty - y) * stride + tx + x];
+      }
+    }
+  }
+}
@@ -5,10 +5,30 @@
 */
 
 #include <3ds.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "spritetools/spritetools_render.h"
+#include "spritetools/spritetools_capture.h"
 #include "spritetools/spritetools_entity.h"
+#include "spritetools/spritetools_governor.h"
+#include "spritetools/spritetools_residency.h"
+#include "spritetools/spritetools_loader.h"
+
+/* Stack size and core of the render thread */
+#define ST_RENDER_THREAD_STACK 0x4000
+#define ST_RENDER_THREAD_CORE 1
+
+/* Lowest app CPU time limit that can be set, put back on stop when no */
+/*   limit had been set before */
+#define ST_RENDER_MIN_CPU_TIME_LIMIT 5
+
+/* Number of commands a new command list has room for */
+#define ST_RENDER_LIST_START 256
 
 static u32 st_background = 0;
+static gfxScreen_t st_currentScreen = GFX_TOP;
 
 static u8 addu8(u8 num1, u8 num2)
 {
@@ -19,6 +39,366 @@ static u8 addu8(u8 num1, u8 num2)
   return newnum;
 }
 
+/********************************\
+|*     Render Command Lists     *|
+\********************************/
+/* Every sf2d call made by this module goes through a command so it can */
+/*   either be run right away or recorded for the render thread */
+typedef enum {
+  ST_RCMD_START_FRAME,
+  ST_RCMD_CLEAR_COLOR,
+  ST_RCMD_SCISSOR,
+  ST_RCMD_TEXTURE, /* Commands from here on draw a spritesheet */
+  ST_RCMD_PART,
+  ST_RCMD_PART_SCALE,
+  ST_RCMD_PART_ROTATE_SCALE_BLEND,
+  ST_RCMD_QUAD_UV_BLEND
+} st_rendercmdtype;
+
+typedef struct {
+  st_rendercmdtype type;
+  st_spritesheet *spritesheet;
+  float x, y; /* Position, or left and top for quads */
+  float x2, y2; /* Right and bottom for quads */
+  float u0, v0, u1, v1;
+  float scale;
+  float rotate;
+  s32 xleft, ytop;
+  s32 width, height;
+  u32 color; /* Blend color, clear color, or screen */
+} st_rendercmd;
+
+typedef struct {
+  st_rendercmd *cmds;
+  u32 count;
+  u32 capacity;
+  vu32 busy; /* Set while the render thread owns the list */
+  u32 workTicks; /* Time the render thread spent drawing it, before vsync */
+} st_renderlist;
+
+static st_renderlist st_lists[2];
+static u8 st_writeList = 0;
+static u8 st_threaded = 0;
+static vu32 st_threadQuit = 0;
+static vs32 st_pendingList = -1; /* List handed to the render thread */
+static Thread st_renderThread = NULL;
+static u32 st_oldCpuTimeLimit = 0; /* Put back when the thread stops */
+static LightEvent st_submitEvent;
+static LightEvent st_doneEvent;
+
+/* Runs a single command */
+static void cmdExecute(const st_rendercmd *cmd)
+{
+  switch (cmd->type)
+  {
+    case ST_RCMD_START_FRAME:
+      if (cmd->color == GFX_TOP)
+        sf2d_start_frame(GFX_TOP, GFX_LEFT);
+      else
+        sf2d_start_frame(GFX_BOTTOM, (gfx3dSide_t)NULL);
+      break;
+    case ST_RCMD_CLEAR_COLOR:
+      sf2d_set_clear_color(cmd->color);
+      break;
+    case ST_RCMD_SCISSOR:
+      if (cmd->width && cmd->height)
+        sf2d_set_scissor_test(GPU_SCISSOR_NORMAL, cmd->xleft, cmd->ytop,
+          cmd->width, cmd->height);
+      else
+        sf2d_set_scissor_test(GPU_SCISSOR_DISABLE, 0, 0, 0, 0);
+      break;
+    case ST_RCMD_TEXTURE:
+      sf2d_draw_texture(cmd->spritesheet, cmd->x, cmd->y);
+      break;
+    case ST_RCMD_PART:
+      sf2d_draw_texture_part(cmd->spritesheet, cmd->x, cmd->y,
+        cmd->xleft, cmd->ytop, cmd->width, cmd->height);
+      break;
+    case ST_RCMD_PART_SCALE:
+      sf2d_draw_texture_part_scale(cmd->spritesheet, cmd->x, cmd->y,
+        cmd->xleft, cmd->ytop, cmd->width, cmd->height,
+        cmd->scale, cmd->scale);
+      break;
+    case ST_RCMD_PART_ROTATE_SCALE_BLEND:
+      sf2d_draw_texture_part_rotate_scale_blend(cmd->spritesheet,
+        cmd->x, cmd->y, cmd->rotate,
+        cmd->xleft, cmd->ytop, cmd->width, cmd->height,
+        cmd->scale, cmd->scale, cmd->color);
+      break;
+    case ST_RCMD_QUAD_UV_BLEND:
+      sf2d_draw_quad_uv_blend(cmd->spritesheet,
+        cmd->x, cmd->y, cmd->x2, cmd->y2,
+        cmd->u0, cmd->v0, cmd->u1, cmd->v1, cmd->color);
+      break;
+  }
+}
+
+/* Returns roughly how many texels a drawing command samples */
+static u32 cmdTexels(const st_rendercmd *cmd)
+{
+  switch (cmd->type)
+  {
+    case ST_RCMD_TEXTURE:
+      return cmd->spritesheet->width * cmd->spritesheet->height;
+    case ST_RCMD_PART:
+      return cmd->width * cmd->height;
+    case ST_RCMD_PART_SCALE:
+    case ST_RCMD_PART_ROTATE_SCALE_BLEND:
+      return cmd->width * cmd->height * cmd->scale * cmd->scale;
+    case ST_RCMD_QUAD_UV_BLEND:
+      return (cmd->x2 - cmd->x) * (cmd->y2 - cmd->y);
+    default:
+      return 0;
+  }
+}
+
+/**************************\
+|*     Render Capture     *|
+\**************************/
+static FILE *st_captureFile = NULL;
+static u32 st_captureFrames = 0; /* Frames left to capture, 0 for no limit */
+
+/* Writes a record to the capture, stopping the capture if it can't */
+static void captureWrite(u16 type, u16 value, const float *x, const float *y)
+{
+  st_capturerecord record;
+
+  memset(&record, 0, sizeof(record));
+  record.type = type;
+  record.value = value;
+  if (x)
+    memcpy(record.x, x, sizeof(record.x));
+  if (y)
+    memcpy(record.y, y, sizeof(record.y));
+  if (fwrite(&record, sizeof(record), 1, st_captureFile) != 1)
+    ST_RenderCaptureStop();
+}
+
+/* Sets the corners of an unrotated rectangle */
+static void captureRect(float *x, float *y,
+  float left, float top, float right, float bottom)
+{
+  x[0] = x[3] = left;
+  x[1] = x[2] = right;
+  y[0] = y[1] = top;
+  y[2] = y[3] = bottom;
+}
+
+/* Records a command and the part of the screen it covers */
+/*   Corners are worked out the same way sf2d places its vertices */
+static void captureCmd(const st_rendercmd *cmd)
+{
+  float x[4], y[4], w2, h2, c, s, px, py;
+  u8 i;
+
+  switch (cmd->type)
+  {
+    case ST_RCMD_START_FRAME:
+      captureWrite(ST_CAPTURE_SCREEN,
+        cmd->color == GFX_TOP ? ST_CAPTURE_TOP : ST_CAPTURE_BOTTOM,
+        NULL, NULL);
+      return;
+    case ST_RCMD_SCISSOR:
+      captureRect(x, y, cmd->xleft, cmd->ytop, cmd->xleft + cmd->width,
+        cmd->ytop + cmd->height);
+      captureWrite(ST_CAPTURE_SCISSOR, cmd->width && cmd->height, x, y);
+      return;
+    case ST_RCMD_TEXTURE:
+      captureRect(x, y, cmd->x, cmd->y, cmd->x + cmd->spritesheet->width,
+        cmd->y + cmd->spritesheet->height);
+      break;
+    case ST_RCMD_PART:
+      captureRect(x, y, cmd->x, cmd->y, cmd->x + cmd->width,
+        cmd->y + cmd->height);
+      break;
+    case ST_RCMD_PART_SCALE:
+      captureRect(x, y, cmd->x, cmd->y, cmd->x + cmd->width * cmd->scale,
+        cmd->y + cmd->height * cmd->scale);
+      break;
+    case ST_RCMD_PART_ROTATE_SCALE_BLEND:
+      w2 = cmd->width * cmd->scale / 2.0f;
+      h2 = cmd->height * cmd->scale / 2.0f;
+      c = cosf(cmd->rotate);
+      s = sinf(cmd->rotate);
+      captureRect(x, y, -w2, -h2, w2, h2);
+      for (i = 0; i < 4; i++)
+      {
+        px = x[i];
+        py = y[i];
+        x[i] = cmd->x + px * c - py * s;
+        y[i] = cmd->y + px * s + py * c;
+      }
+      break;
+    case ST_RCMD_QUAD_UV_BLEND:
+      captureRect(x, y, cmd->x, cmd->y, cmd->x2, cmd->y2);
+      break;
+    default:
+      return;
+  }
+  captureWrite(ST_CAPTURE_QUAD, cmd->spritesheet->pixel_format, x, y);
+}
+
+/* Runs a command now, or appends it to the current list when threaded */
+static void cmdSubmit(const st_rendercmd *cmd)
+{
+  st_renderlist *list;
+
+  /* Evicted spritesheets are reloaded before anything can draw them */
+  if (cmd->type >= ST_RCMD_TEXTURE &&
+    !ST_ResidencyTouchSampled(cmd->spritesheet, cmdTexels(cmd)))
+    return;
+  if (st_captureFile)
+    captureCmd(cmd);
+
+  if (!st_threaded)
+  {
+    cmdExecute(cmd);
+    return;
+  }
+
+  list = &st_lists[st_writeList];
+  if (list->count >= list->capacity)
+  {
+    u32 capacity = list->capacity ? list->capacity * 2 : ST_RENDER_LIST_START;
+    st_rendercmd *cmds = realloc(list->cmds, capacity * sizeof(st_rendercmd));
+    if (!cmds)
+      return;
+    list->cmds = cmds;
+    list->capacity = capacity;
+  }
+  list->cmds[list->count++] = *cmd;
+}
+
+/* Makes room in the current list for several commands at once */
+static void cmdReserve(u32 count)
+{
+  st_renderlist *list = &st_lists[st_writeList];
+  st_rendercmd *cmds;
+  u32 capacity;
+
+  if (!st_threaded || list->count + count <= list->capacity)
+    return;
+
+  capacity = list->capacity ? list->capacity : ST_RENDER_LIST_START;
+  while (capacity < list->count + count)
+    capacity *= 2;
+  cmds = realloc(list->cmds, capacity * sizeof(st_rendercmd));
+  if (!cmds)
+    return;
+  list->cmds = cmds;
+  list->capacity = capacity;
+}
+
+/* Waits until the render thread is done with a list */
+static void listWait(st_renderlist *list)
+{
+  while (__atomic_load_n(&list->busy, __ATOMIC_ACQUIRE))
+    LightEvent_Wait(&st_doneEvent);
+}
+
+/* Render thread loop: replays each submitted list and swaps buffers */
+static void renderThreadMain(void *arg)
+{
+  s32 index;
+  u32 i;
+  u64 start;
+  st_renderlist *list;
+
+  (void)arg;
+  while (1)
+  {
+    LightEvent_Wait(&st_submitEvent);
+    index = __atomic_exchange_n(&st_pendingList, -1, __ATOMIC_ACQ_REL);
+    if (index >= 0)
+    {
+      list = &st_lists[index];
+      start = svcGetSystemTick();
+      for (i = 0; i < list->count; i++)
+        cmdExecute(&list->cmds[i]);
+      list->workTicks = svcGetSystemTick() - start;
+      sf2d_swapbuffers();
+      list->count = 0;
+      __atomic_store_n(&list->busy, 0, __ATOMIC_RELEASE);
+      LightEvent_Signal(&st_doneEvent);
+    }
+    if (__atomic_load_n(&st_threadQuit, __ATOMIC_ACQUIRE))
+      break;
+  }
+}
+
+/* Draws a frame centered on x and y using its cached texture coordinates */
+static void renderFrame(st_frame *frame, s64 x, s64 y,
+  double scale, double rotate, u32 color)
+{
+  st_rendercmd cmd;
+  int w2, h2;
+  double c, s;
+
+  if (!frame->drawWidth || !frame->drawHeight)
+    return;
+
+  /* Trimmed frames keep drawing where the untrimmed frame would have */
+  if (frame->trimX || frame->trimY)
+  {
+    c = cos(rotate);
+    s = sin(rotate);
+    x += floor((frame->trimX * c - frame->trimY * s) * scale + 0.5);
+    y += floor((frame->trimX * s + frame->trimY * c) * scale + 0.5);
+  }
+
+  cmd.spritesheet = frame->spritesheet;
+  cmd.color = color;
+  if (rotate != 0.0)
+  {
+    cmd.type = ST_RCMD_PART_ROTATE_SCALE_BLEND;
+    cmd.x = x;
+    cmd.y = y;
+    cmd.rotate = rotate;
+    cmd.scale = scale;
+    cmd.xleft = frame->xleft;
+    cmd.ytop = frame->ytop;
+    cmd.width = frame->drawWidth;
+    cmd.height = frame->drawHeight;
+    cmdSubmit(&cmd);
+    return;
+  }
+
+  /* Same truncation as sf2d so unrotated and rotated frames line up */
+  w2 = (frame->drawWidth * scale) / 2.0;
+  h2 = (frame->drawHeight * scale) / 2.0;
+  cmd.type = ST_RCMD_QUAD_UV_BLEND;
+  cmd.x = x - w2;
+  cmd.y = y - h2;
+  cmd.x2 = x + w2;
+  cmd.y2 = y + h2;
+  cmd.u0 = frame->u0;
+  cmd.v0 = frame->v0;
+  cmd.u1 = frame->u1;
+  cmd.v1 = frame->v1;
+  cmdSubmit(&cmd);
+}
+
+/* Draws part of a spritesheet through the given kind of command */
+static void renderPart(st_rendercmdtype type, st_spritesheet *spritesheet,
+  u32 xleft, u32 ytop, u32 width, u32 height, s64 x, s64 y,
+  double scale, double rotate, u32 color)
+{
+  st_rendercmd cmd;
+
+  cmd.type = type;
+  cmd.spritesheet = spritesheet;
+  cmd.x = x;
+  cmd.y = y;
+  cmd.xleft = xleft;
+  cmd.ytop = ytop;
+  cmd.width = width;
+  cmd.height = height;
+  cmd.scale = scale;
+  cmd.rotate = rotate;
+  cmd.color = color;
+  cmdSubmit(&cmd);
+}
+
 /*****************************\
 |*     General Functions     *|
 \*****************************/
@@ -38,6 +418,7 @@ u8 ST_RenderInit(void)
 /* Returns 1 on success, 0 on failure */
 u8 ST_RenderFini(void)
 {
+  ST_RenderThreadStop();
   if (!sf2d_fini())
     return 0;
 
@@ -48,26 +429,61 @@ u8 ST_RenderFini(void)
 /* Takes screen (GFX_TOP or GFX_BOTTOM) */
 void ST_RenderStartFrame(gfxScreen_t screen)
 {
-  if (screen == GFX_TOP)
-  {
-    sf2d_start_frame(screen, GFX_LEFT);
-  }
-  else
-  {
-    sf2d_start_frame(screen, (gfx3dSide_t)NULL);
-  }
+  st_rendercmd cmd;
+
+  cmd.type = ST_RCMD_START_FRAME;
+  cmd.color = screen;
+  st_currentScreen = screen;
+  cmdSubmit(&cmd);
 }
 
 /* Ends frame */
+/*   When the render thread is running, this hands the recorded frame to it */
+/*   once it has finished drawing the previous one, then returns so the */
+/*   next frame can be recorded into the other list */
 void ST_RenderEndRender(void)
 {
-  sf2d_swapbuffers();
+  if (st_captureFile)
+  {
+    captureWrite(ST_CAPTURE_END_FRAME, 0, NULL, NULL);
+    if (st_captureFrames && !--st_captureFrames)
+      ST_RenderCaptureStop();
+  }
+  /* Waiting for vsync or the render thread isn't work, so it's left out */
+  ST_GovernorTick();
+  if (!st_threaded)
+  {
+    sf2d_swapbuffers();
+    ST_GovernorStartWork();
+    ST_ResidencyFrame();
+    ST_LoaderUpdate();
+    ST_ResidencyPlace();
+    return;
+  }
+
+  /* Only one list is ever in flight, so the mailbox is always empty here */
+  listWait(&st_lists[st_writeList ^ 1]);
+  /* The render thread's drawing counts toward the next frame it's seen in */
+  ST_GovernorWork(st_lists[st_writeList ^ 1].workTicks /
+    (SYSCLOCK_ARM11 / 1000.0));
+  ST_GovernorStartWork();
+
+  /* The render thread is idle, so only now can the frame move on and */
+  /*   textures be evicted, made and moved */
+  ST_ResidencyFrame();
+  ST_LoaderUpdate();
+  ST_ResidencyPlace();
+  __atomic_store_n(&st_lists[st_writeList].busy, 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&st_pendingList, st_writeList, __ATOMIC_RELEASE);
+  LightEvent_Signal(&st_submitEvent);
+
+  st_writeList ^= 1;
 }
 
 /* Returns current screen */
 gfxScreen_t ST_RenderCurrentScreen(void)
 {
-  return sf2d_get_current_screen();
+  return st_currentScreen;
 }
 
 u16 ST_RenderScreenWidth(gfxScreen_t screen)
@@ -92,8 +508,12 @@ float ST_RenderFPS(void)
 /* Sets background to given color */
 void ST_RenderSetBackground(u8 red, u8 green, u8 blue)
 {
-  sf2d_set_clear_color(RGBA8(red, green, blue, 0xFF));
+  st_rendercmd cmd;
+
   st_background = RGBA8(red, green, blue, 0xFF);
+  cmd.type = ST_RCMD_CLEAR_COLOR;
+  cmd.color = st_background;
+  cmdSubmit(&cmd);
 }
 
 /* Returns background color in the RGBA8 format */
@@ -102,6 +522,162 @@ u32 ST_RenderGetBackground(void)
   return st_background;
 }
 
+/* Clips drawing to a rectangle of the current screen */
+/* Takes position and size of the rectangle */
+void ST_RenderSetScissor(u32 x, u32 y, u32 width, u32 height)
+{
+  st_rendercmd cmd;
+
+  cmd.type = ST_RCMD_SCISSOR;
+  cmd.xleft = x;
+  cmd.ytop = y;
+  cmd.width = width;
+  cmd.height = height;
+  cmdSubmit(&cmd);
+}
+
+/* Stops clipping drawing */
+void ST_RenderClearScissor(void)
+{
+  ST_RenderSetScissor(0, 0, 0, 0);
+}
+
+/**************************\
+|*     Render Capture     *|
+\**************************/
+/* Starts recording what each frame draws to a file */
+/* Takes an open file and number of frames to record (0 for no limit) */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCaptureStart(FILE *file, u32 frames)
+{
+  st_captureheader header;
+
+  if (!file || st_captureFile)
+    return 0;
+
+  memset(&header, 0, sizeof(header));
+  header.magic = ST_CAPTURE_MAGIC;
+  header.version = ST_CAPTURE_VERSION;
+  if (fwrite(&header, sizeof(header), 1, file) != 1)
+    return 0;
+
+  st_captureFile = file;
+  st_captureFrames = frames;
+  return 1;
+}
+
+/* Stops recording frames */
+/*   The file is flushed but left open */
+void ST_RenderCaptureStop(void)
+{
+  if (!st_captureFile)
+    return;
+
+  fflush(st_captureFile);
+  st_captureFile = NULL;
+  st_captureFrames = 0;
+}
+
+/* Returns 1 if frames are being recorded and 0 if not */
+u8 ST_RenderCapturing(void)
+{
+  return st_captureFile != NULL;
+}
+
+/*************************\
+|*     Render Thread     *|
+\*************************/
+/* Starts the render thread on the second core */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderThreadStart(void)
+{
+  s32 prio = 0x30;
+  u8 i;
+
+  if (st_threaded)
+    return 1;
+
+  for (i = 0; i < 2; i++)
+  {
+    st_lists[i].count = 0;
+    st_lists[i].busy = 0;
+    if (!st_lists[i].cmds)
+    {
+      st_lists[i].cmds = calloc(ST_RENDER_LIST_START, sizeof(st_rendercmd));
+      if (!st_lists[i].cmds)
+        return 0;
+      st_lists[i].capacity = ST_RENDER_LIST_START;
+    }
+  }
+
+  LightEvent_Init(&st_submitEvent, RESET_ONESHOT);
+  LightEvent_Init(&st_doneEvent, RESET_ONESHOT);
+  st_pendingList = -1;
+  st_threadQuit = 0;
+  st_writeList = 0;
+
+  /* The app core is limited to a slice of time on the second CPU */
+  if (R_FAILED(APT_GetAppCpuTimeLimit(&st_oldCpuTimeLimit)) ||
+    st_oldCpuTimeLimit < ST_RENDER_MIN_CPU_TIME_LIMIT)
+    st_oldCpuTimeLimit = ST_RENDER_MIN_CPU_TIME_LIMIT;
+  APT_SetAppCpuTimeLimit(80);
+  svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+  st_renderThread = threadCreate(renderThreadMain, NULL,
+    ST_RENDER_THREAD_STACK, prio - 1, ST_RENDER_THREAD_CORE, false);
+  if (!st_renderThread)
+  {
+    APT_SetAppCpuTimeLimit(st_oldCpuTimeLimit);
+    return 0;
+  }
+
+  st_threaded = 1;
+  return 1;
+}
+
+/* Waits for all submitted frames and stops the render thread */
+void ST_RenderThreadStop(void)
+{
+  u8 i;
+
+  if (!st_threaded)
+    return;
+
+  ST_RenderThreadSync();
+  __atomic_store_n(&st_threadQuit, 1, __ATOMIC_RELEASE);
+  LightEvent_Signal(&st_submitEvent);
+  threadJoin(st_renderThread, U64_MAX);
+  threadFree(st_renderThread);
+  st_renderThread = NULL;
+  st_threaded = 0;
+
+  /* Give the system back the time the thread took */
+  APT_SetAppCpuTimeLimit(st_oldCpuTimeLimit);
+
+  for (i = 0; i < 2; i++)
+  {
+    free(st_lists[i].cmds);
+    st_lists[i].cmds = NULL;
+    st_lists[i].count = 0;
+    st_lists[i].capacity = 0;
+  }
+}
+
+/* Waits until the render thread has drawn every submitted frame */
+void ST_RenderThreadSync(void)
+{
+  if (!st_threaded)
+    return;
+
+  listWait(&st_lists[0]);
+  listWait(&st_lists[1]);
+}
+
+/* Returns 1 if the render thread is running and 0 if not */
+u8 ST_RenderThreadRunning(void)
+{
+  return st_threaded;
+}
+
 /*******************************\
 |*     Render Spritesheets     *|
 \*******************************/
@@ -109,14 +685,15 @@ u32 ST_RenderGetBackground(void)
 /* Takes spritesheet and x and y of position to render on screen */
 void ST_RenderSpritesheetPosition(st_spritesheet *spritesheet, s64 x, s64 y)
 {
-  sf2d_draw_texture(spritesheet, x, y);
+  renderPart(ST_RCMD_TEXTURE, spritesheet, 0, 0, 0, 0, x, y,
+    1.0, 0.0, 0);
 }
 
 /* Draw Spritesheet at 0,0 */
 /* Takes spritesheet */
 void ST_RenderSpritesheet(st_spritesheet *spritesheet)
 {
-  sf2d_draw_texture(spritesheet, 0, 0);
+  ST_RenderSpritesheetPosition(spritesheet, 0, 0);
 }
 
 /* Draw Sprite in Spritesheet at Position */
@@ -129,7 +706,8 @@ void ST_RenderSpritePosition(st_spritesheet *spritesheet,
   u32 width, u32 height,
   s64 x, s64 y)
 {
-  sf2d_draw_texture_part(spritesheet, x, y, xleft, ytop, width, height);
+  renderPart(ST_RCMD_PART, spritesheet, xleft, ytop, width, height, x, y,
+    1.0, 0.0, 0);
 }
 
 /* Draw Sprite in Spritesheet at 0,0 */
@@ -155,8 +733,8 @@ void ST_RenderSpritePositionScale(st_spritesheet *spritesheet,
   s64 x, s64 y,
   double scale)
 {
-  sf2d_draw_texture_part_scale(spritesheet, x, y, xleft, ytop,
-    width, height, scale, scale);
+  renderPart(ST_RCMD_PART_SCALE, spritesheet, xleft, ytop, width, height,
+    x, y, scale, 0.0, 0);
 }
 
 /* Draw Rotated Sprite in Spritesheet at Position */
@@ -171,8 +749,8 @@ void ST_RenderSpritePositionRotate(st_spritesheet *spritesheet,
   s64 x, s64 y,
   double rotate)
 {
-  sf2d_draw_texture_part_rotate_scale(spritesheet, x, y, rotate, xleft, ytop,
-    width, height, 1.0, 1.0);
+  renderPart(ST_RCMD_PART_ROTATE_SCALE_BLEND, spritesheet, xleft, ytop,
+    width, height, x, y, 1.0, rotate, RGBA8(0xFF, 0xFF, 0xFF, 0xFF));
 }
 
 /* Draw Scaled and Rotated Sprite in Spritesheet at Position */
@@ -189,8 +767,8 @@ void ST_RenderSpritePositionScaleRotate(st_spritesheet *spritesheet,
   double scale,
   double rotate)
 {
-  sf2d_draw_texture_part_rotate_scale(spritesheet, x, y, rotate, xleft, ytop,
-    width, height, scale, scale);
+  renderPart(ST_RCMD_PART_ROTATE_SCALE_BLEND, spritesheet, xleft, ytop,
+    width, height, x, y, scale, rotate, RGBA8(0xFF, 0xFF, 0xFF, 0xFF));
 }
 
 /* Draw Scaled, Rotated, and Blended Sprite in Spritesheet at Position */
@@ -213,8 +791,8 @@ void ST_RenderSpriteAdvanced(st_spritesheet *spritesheet,
   width = (width + 1) / 2 * 2;
   height = (height + 1) / 2 * 2;
 
-  sf2d_draw_texture_part_rotate_scale_blend(spritesheet, x, y, rotate,
-    xleft, ytop, width, height, scale, scale, RGBA8(red, green, blue, alpha));
+  renderPart(ST_RCMD_PART_ROTATE_SCALE_BLEND, spritesheet, xleft, ytop,
+    width, height, x, y, scale, rotate, RGBA8(red, green, blue, alpha));
 }
 
 /*************************\
@@ -224,39 +802,24 @@ void ST_RenderSpriteAdvanced(st_spritesheet *spritesheet,
 /* Takes spritesheet and position at which to draw */
 void ST_RenderFramePosition(st_frame *frame, s64 x, s64 y)
 {
-  ST_RenderSpriteAdvanced(frame->spritesheet,
-    frame->xleft, frame->ytop,
-    frame->width, frame->height,
-    x - frame->xoff, y - frame->yoff,
-    1.0,
-    0.0,
-    255, 255, 255, 255);
+  renderFrame(frame, x - frame->xoff, y - frame->yoff,
+    1.0, 0.0, RGBA8(255, 255, 255, 255));
 }
 
 /* Draw scaled frame at given position */
 /* Takes spritesheet, position at which to draw and a scalar multiplier */
 void ST_RenderFrameScale(st_frame *frame, s64 x, s64 y, double scale)
 {
-  ST_RenderSpriteAdvanced(frame->spritesheet,
-    frame->xleft, frame->ytop,
-    frame->width, frame->height,
-    x + frame->xoff, y + frame->yoff,
-    scale,
-    0.0,
-    255, 255, 255, 255);
+  renderFrame(frame, x + frame->xoff, y + frame->yoff,
+    scale, 0.0, RGBA8(255, 255, 255, 255));
 }
 
 /* Draw rotated frame at given position */
 /* Takes spritesheet, position at which to draw and a rotation in radians */
 void ST_RenderFrameRotate(st_frame *frame, s64 x, s64 y, double rotate)
 {
-  ST_RenderSpriteAdvanced(frame->spritesheet,
-    frame->xleft, frame->ytop,
-    frame->width, frame->height,
-    x + frame->xoff, y + frame->yoff,
-    1.0,
-    rotate,
-    255, 255, 255, 255);
+  renderFrame(frame, x + frame->xoff, y + frame->yoff,
+    1.0, rotate, RGBA8(255, 255, 255, 255));
 }
 
 /* Draw scaled, rotated, and blended frame at given position */
@@ -267,13 +830,8 @@ void ST_RenderFramePositionAdvanced(st_frame *frame, s64 x, s64 y,
   double scale, double rotate,
   u8 red, u8 green, u8 blue, u8 alpha)
 {
-  ST_RenderSpriteAdvanced(frame->spritesheet,
-    frame->xleft, frame->ytop,
-    frame->width, frame->height,
-    x - frame->xoff, y - frame->yoff,
-    scale,
-    rotate,
-    red, green, blue, alpha);
+  renderFrame(frame, x - frame->xoff, y - frame->yoff,
+    scale, rotate, RGBA8(red, green, blue, alpha));
 }
 
 /*****************************\
@@ -294,6 +852,7 @@ void ST_RenderAnimationNext(st_animation *animation, s64 x, s64 y)
   animation->currentFrame++;
   if(animation->currentFrame >= animation->length)
     animation->currentFrame = animation->loopFrame;
+  ST_AnimationDispatchEvents(animation);
   ST_RenderAnimationCurrent(animation, x, y);
 }
 
@@ -305,6 +864,7 @@ void ST_RenderAnimationPrevious(st_animation *animation, s64 x, s64 y)
   animation->currentFrame--;
   if(animation->currentFrame >= animation->length)
     animation->currentFrame = animation->loopFrame;
+  ST_AnimationDispatchEvents(animation);
   ST_RenderAnimationCurrent(animation, x, y);
 }
 
@@ -364,6 +924,7 @@ void ST_RenderAnimationNextAdvanced(st_animation *animation, s64 x, s64 y,
   animation->currentFrame++;
   if(animation->currentFrame >= animation->length)
     animation->currentFrame = animation->loopFrame;
+  ST_AnimationDispatchEvents(animation);
   ST_RenderAnimationCurrentAdvanced(animation, x, y,
     scale, rotate, red, green, blue, alpha);
 }
@@ -375,6 +936,7 @@ void ST_RenderAnimationPreviousAdvanced(st_animation *animation, s64 x, s64 y,
   animation->currentFrame--;
   if(animation->currentFrame >= animation->length)
     animation->currentFrame = animation->loopFrame;
+  ST_AnimationDispatchEvents(animation);
   ST_RenderAnimationCurrentAdvanced(animation, x, y,
     scale, rotate, red, green, blue, alpha);
 }
@@ -440,6 +1002,19 @@ u8 ST_RenderEntity(st_entity *entity)
 /****************************\
 |*     Camera Rendering     *|
 \****************************/
+/* Plays an entity's animation for a camera, stepping it less often when */
+/*   the entity is far away and the governor has lowered the quality */
+static void playCameraAnimation(st_entity *entity, double distance,
+  s64 x, s64 y, double scale, double rotate,
+  u8 red, u8 green, u8 blue, u8 alpha)
+{
+  st_animation *animation = entity->animations[entity->currentAnim];
+
+  ST_GovernorStepAnimation(animation, distance);
+  ST_RenderAnimationCurrentAdvanced(animation, x, y, scale, rotate,
+    red, green, blue, alpha);
+}
+
 /* Plays the current animation of an entity modified by a camera's values */
 /* Takes a pointer to an entity and a pointer to a camera */
 /* Returns 1 on success and 0 on failure */
@@ -456,7 +1031,7 @@ u8 ST_RenderEntityCamera(st_entity *entity, st_camera *cam)
   xrend = px2 * cam->zoom + ST_RenderScreenWidth(ST_RenderCurrentScreen()) / 2;
   yrend = py2 * cam->zoom + ST_RenderScreenHeight() / 2;
 
-  ST_RenderAnimationPlayAdvanced(entity->animations[entity->currentAnim],
+  playCameraAnimation(entity, sqrt(px2 * px2 + py2 * py2),
     xrend,
     yrend,
     entity->scale * cam->zoom, entity->rotation + cam->rotation,
@@ -482,7 +1057,7 @@ u8 ST_RenderEntityCameraNoSpriteRot(st_entity *entity, st_camera *cam)
   xrend = px2 * cam->zoom + ST_RenderScreenWidth(ST_RenderCurrentScreen()) / 2;
   yrend = py2 * cam->zoom + ST_RenderScreenHeight() / 2;
 
-  ST_RenderAnimationPlayAdvanced(entity->animations[entity->currentAnim],
+  playCameraAnimation(entity, sqrt(px2 * px2 + py2 * py2),
     xrend,
     yrend,
     entity->scale * cam->zoom, entity->rotation,
@@ -507,3 +1082,133 @@ u8 ST_RenderEntityMainCameraNoSpriteRot(st_entity *entity)
 {
   return ST_RenderEntityCameraNoSpriteRot(entity, ST_MainCameraGet());
 }
+
+/*******************************\
+|*     Composite Rendering     *|
+\*******************************/
+/* Draws the parts of a composite in layer order */
+/*   Takes the root's position on screen, its rotation and its scale */
+static void renderComposite(st_composite *composite, double x, double y,
+  double rotate, double scale)
+{
+  const st_compositepart *part;
+  double c, s;
+  u16 i;
+
+  ST_CompositeUpdate(composite);
+  cmdReserve(composite->partCount);
+
+  c = cos(rotate) * scale;
+  s = sin(rotate) * scale;
+  for (i = 0; i < composite->partCount; i++)
+  {
+    part = &composite->parts[composite->order[i]];
+    if (!part->frame || !part->alpha)
+      continue;
+    renderFrame(part->frame,
+      x + part->worldX * c - part->worldY * s,
+      y + part->worldX * s + part->worldY * c,
+      scale * part->worldScale, rotate + part->worldRotation,
+      RGBA8(part->red, part->green, part->blue, part->alpha));
+  }
+}
+
+/* Draws a composite at its position */
+/* Takes a pointer to a composite */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderComposite(st_composite *composite)
+{
+  if (!composite)
+    return 0;
+
+  renderComposite(composite, composite->xpos, composite->ypos,
+    composite->rotation, composite->scale);
+  return 1;
+}
+
+/* Draws a composite modified by a camera's values */
+/* Takes a pointer to a composite and a pointer to a camera */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCompositeCamera(st_composite *composite, st_camera *cam)
+{
+  double c, s, px, py;
+
+  if (!composite || !cam)
+    return 0;
+
+  c = cos(cam->rotation);
+  s = sin(cam->rotation);
+  px = composite->xpos - cam->x;
+  py = composite->ypos - cam->y;
+  renderComposite(composite,
+    (px * c - py * s) * cam->zoom +
+    ST_RenderScreenWidth(ST_RenderCurrentScreen()) / 2,
+    (px * s + py * c) * cam->zoom + ST_RenderScreenHeight() / 2,
+    composite->rotation + cam->rotation, composite->scale * cam->zoom);
+  return 1;
+}
+
+/* Draws a composite modified by the main camera's values */
+/* Takes a pointer to a composite */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderCompositeMainCamera(st_composite *composite)
+{
+  return ST_RenderCompositeCamera(composite, ST_MainCameraGet());
+}
+
+/******************************\
+|*     Viewport Rendering     *|
+\******************************/
+/* Draws the entities in a viewport's draw list */
+/*   ST_ViewportCull must be called first to fill the list and step the */
+/*   animations, so this only draws their current frames */
+/* Takes a pointer to a viewport */
+/* Returns 1 on success and 0 on failure */
+u8 ST_RenderViewport(st_viewport *viewport)
+{
+  st_camera *cam = viewport->camera;
+  st_viewportdraw *draw;
+  st_entity *entity;
+  st_animation *animation;
+  u32 i;
+
+  if (!cam)
+    return 0;
+
+  if (viewport->scissor)
+    ST_RenderSetScissor(viewport->x < 0 ? 0 : viewport->x,
+      viewport->y < 0 ? 0 : viewport->y, viewport->width, viewport->height);
+
+  for (i = 0; i < viewport->drawCount; i++)
+  {
+    draw = &viewport->draws[i];
+    entity = draw->entity;
+    animation = entity->animations[entity->currentAnim];
+    if (viewport->rotateSprites)
+      ST_RenderAnimationCurrentAdvanced(animation, draw->x, draw->y,
+        entity->scale * cam->zoom, entity->rotation + cam->rotation,
+        entity->red, entity->green, entity->blue, entity->alpha);
+    else
+      ST_RenderAnimationCurrentAdvanced(animation, draw->x, draw->y,
+        entity->scale * cam->zoom, entity->rotation,
+        addu8(entity->red, cam->red), addu8(entity->green, cam->green),
+        addu8(entity->blue, cam->blue), addu8(entity->alpha, cam->alpha));
+  }
+
+  if (viewport->scissor)
+    ST_RenderClearScissor();
+
+  return 1;
+}
+
+/* Draws every viewport that belongs to the current screen */
+/* Takes a list of viewports and number of viewports */
+void ST_RenderViewports(st_viewport **viewports, u8 viewportCount)
+{
+  u8 i;
+  for (i = 0; i < viewportCount; i++)
+  {
+    if (viewports[i]->screen == st_currentScreen)
+      ST_RenderViewport(viewports[i]);
+  }
+}
@@ -0,0 +1,624 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include "spritetools/spritetools_residency.h"
+
+/* Frames a spritesheet may still be in use by the GPU after being drawn */
+#define IN_FLIGHT_FRAMES 2
+
+/* Starting size of the lookup table (must be a power of 2) */
+#define TABLE_START 64
+
+/* Most moved texture buffers waiting for the GPU to let go of them */
+#define GRAVEYARD_SIZE 64
+
+/* Flag for GX_TextureCopy to do a straight copy */
+#define TEXTURE_COPY 0x8
+
+/* Old texture data that may still be read by frames in flight */
+typedef struct {
+  void *data;
+  sf2d_place place;
+  u32 frame;
+} st_grave;
+
+static st_residency **st_records = NULL; /* Open addressed by pointer */
+static u32 st_tableSize = 0;
+static u32 st_recordCount = 0;
+static u32 st_budget = ST_RESIDENCY_DEFAULT_BUDGET;
+static u32 st_used = 0;
+static u32 st_frame = IN_FLIGHT_FRAMES;
+static st_residency *st_lastTouched = NULL;
+static st_grave st_graveyard[GRAVEYARD_SIZE];
+static u8 st_placeDue = 0;
+static u8 st_moveDue = 0; /* Some records are waiting to be moved */
+
+/* Returns the home slot of a spritesheet in the table */
+static u32 hashSlot(const st_spritesheet *spritesheet)
+{
+  return (((u32)(size_t)spritesheet >> 3) * 2654435761u) &
+    (st_tableSize - 1);
+}
+
+/* Returns the table slot holding a spritesheet, or -1 */
+static s32 findSlot(const st_spritesheet *spritesheet)
+{
+  u32 slot;
+
+  if (!st_tableSize)
+    return -1;
+
+  slot = hashSlot(spritesheet);
+  while (st_records[slot])
+  {
+    if (st_records[slot]->spritesheet == spritesheet)
+      return slot;
+    slot = (slot + 1) & (st_tableSize - 1);
+  }
+  return -1;
+}
+
+/* Puts a record in the first free slot after its home slot */
+static void insertRecord(st_residency *record)
+{
+  u32 slot = hashSlot(record->spritesheet);
+  while (st_records[slot])
+    slot = (slot + 1) & (st_tableSize - 1);
+  st_records[slot] = record;
+}
+
+/* Doubles the table (or creates it) and reinserts every record */
+static u8 growTable(void)
+{
+  st_residency **old = st_records;
+  u32 oldSize = st_tableSize;
+  u32 size = st_tableSize ? st_tableSize * 2 : TABLE_START;
+  u32 i;
+
+  st_records = calloc(size, sizeof(st_residency *));
+  if (!st_records)
+  {
+    st_records = old;
+    return 0;
+  }
+  st_tableSize = size;
+
+  for (i = 0; i < oldSize; i++)
+  {
+    if (old[i])
+      insertRecord(old[i]);
+  }
+  free(old);
+
+  return 1;
+}
+
+/* Takes a record out of the table, shifting back any that probed past it */
+static void removeSlot(u32 slot)
+{
+  u32 next = (slot + 1) & (st_tableSize - 1);
+  u32 home;
+
+  st_records[slot] = NULL;
+  while (st_records[next])
+  {
+    home = hashSlot(st_records[next]->spritesheet);
+    /* Move it back if its home isn't between the hole and where it sits */
+    if ((next > slot && (home <= slot || home > next)) ||
+      (next < slot && (home <= slot && home > next)))
+    {
+      st_records[slot] = st_records[next];
+      st_records[next] = NULL;
+      slot = next;
+    }
+    next = (next + 1) & (st_tableSize - 1);
+  }
+}
+
+/* Frees the texture data of a record */
+static void evictRecord(st_residency *record)
+{
+  C3D_TexDelete(&record->spritesheet->tex);
+  record->spritesheet->tex.data = NULL;
+  record->resident = 0;
+  st_used -= record->bytes;
+}
+
+/* Returns 1 if a record may be evicted right now */
+static u8 canEvict(st_residency *record, st_residency *keep)
+{
+  return record != keep && record->resident &&
+    record->source.type != ST_SOURCE_NONE &&
+    record->lastFrame + IN_FLIGHT_FRAMES <= st_frame;
+}
+
+/* Evicts least recently drawn records until usage is at most the target */
+/*   Never evicts keep */
+static u32 trimTo(u32 target, st_residency *keep)
+{
+  st_residency *oldest;
+  u32 freed = 0;
+  u32 i;
+
+  while (st_used > target)
+  {
+    oldest = NULL;
+    for (i = 0; i < st_tableSize; i++)
+    {
+      if (st_records[i] && canEvict(st_records[i], keep) &&
+        (!oldest || st_records[i]->lastFrame < oldest->lastFrame))
+        oldest = st_records[i];
+    }
+    if (!oldest)
+      break;
+    freed += oldest->bytes;
+    evictRecord(oldest);
+  }
+
+  return freed;
+}
+
+/* Loads the texture data of an evicted record back in */
+static u8 reloadRecord(st_residency *record)
+{
+  st_spritesheet *temp;
+
+  if (st_budget)
+    trimTo(st_budget > record->bytes ? st_budget - record->bytes : 0, record);
+
+  temp = ST_SpritesheetLoadSource(&record->source);
+  if (!temp && trimTo(0, record))
+    temp = ST_SpritesheetLoadSource(&record->source);
+  if (!temp)
+    return 0;
+
+  /* Keep the caller's pointer valid by moving the new data into it */
+  *record->spritesheet = *temp;
+  free(temp);
+
+  record->bytes = record->spritesheet->tex.size;
+  record->resident = 1;
+  st_used += record->bytes;
+
+  /* Moving copies on the GPU, which can't happen in the middle of a */
+  /*   frame, so ST_ResidencyPlace does it */
+  if (record->source.placement == ST_PLACE_VRAM)
+  {
+    record->moveDue = 1;
+    st_moveDue = 1;
+  }
+
+  return 1;
+}
+
+/* Frees texture data from the right memory */
+static void freeData(void *data, sf2d_place place)
+{
+  if (place == SF2D_PLACE_VRAM)
+    vramFree(data);
+  else
+    linearFree(data);
+}
+
+/* Returns a free slot in the graveyard or NULL if it's full */
+static st_grave *findGrave(void)
+{
+  u8 i;
+  for (i = 0; i < GRAVEYARD_SIZE; i++)
+  {
+    if (!st_graveyard[i].data)
+      return &st_graveyard[i];
+  }
+  return NULL;
+}
+
+/* Frees every buried buffer that the GPU is done with */
+static void sweepGraveyard(u8 all)
+{
+  u8 i;
+  for (i = 0; i < GRAVEYARD_SIZE; i++)
+  {
+    if (st_graveyard[i].data &&
+      (all || st_graveyard[i].frame + IN_FLIGHT_FRAMES <= st_frame))
+    {
+      freeData(st_graveyard[i].data, st_graveyard[i].place);
+      st_graveyard[i].data = NULL;
+    }
+  }
+}
+
+/* Copies a record's texture data into the other kind of memory */
+static u8 moveRecord(st_residency *record, sf2d_place place)
+{
+  st_spritesheet *spritesheet = record->spritesheet;
+  st_grave *grave;
+  void *data;
+
+  if (!record->resident || spritesheet->place == place)
+    return 1;
+
+  /* Frames in flight may still read the old data, so it's freed later */
+  grave = findGrave();
+  if (!grave)
+    return 0;
+
+  if (place == SF2D_PLACE_VRAM)
+    data = vramAlloc(spritesheet->tex.size);
+  else
+    data = linearAlloc(spritesheet->tex.size);
+  if (!data)
+    return 0;
+
+  /* The texture is already tiled, so the GPU can copy it as is */
+  if (spritesheet->place == SF2D_PLACE_RAM)
+    GSPGPU_FlushDataCache(spritesheet->tex.data, spritesheet->tex.size);
+  GX_TextureCopy(spritesheet->tex.data, 0, data, 0, spritesheet->tex.size,
+    TEXTURE_COPY);
+  gspWaitForPPF();
+
+  grave->data = spritesheet->tex.data;
+  grave->place = spritesheet->place;
+  grave->frame = st_frame;
+  spritesheet->tex.data = data;
+  spritesheet->place = place;
+
+  return 1;
+}
+
+/* Sorts records by most sampled first */
+static int comparePressure(const void *a, const void *b)
+{
+  const st_residency *ra = *(st_residency * const *)a;
+  const st_residency *rb = *(st_residency * const *)b;
+
+  if (ra->pressure > rb->pressure)
+    return -1;
+  if (ra->pressure < rb->pressure)
+    return 1;
+  return 0;
+}
+
+/* Returns 1 if a grave holds VRAM that will be freed in a later frame */
+static u8 vramBuried(void)
+{
+  u8 i;
+  for (i = 0; i < GRAVEYARD_SIZE; i++)
+  {
+    if (st_graveyard[i].data && st_graveyard[i].place == SF2D_PLACE_VRAM)
+      return 1;
+  }
+  return 0;
+}
+
+/* Moves records waiting to be moved to where their placement wants them */
+/*   Automatic ones were picked for VRAM and only go in while it's free */
+/*   past the reserve. Records that don't fit keep waiting while demoted */
+/*   VRAM is still buried, and are given up on after that */
+static void movePending(void)
+{
+  st_residency *record;
+  u8 buried = vramBuried();
+  u32 space, reserve;
+  u32 i;
+
+  st_moveDue = 0;
+  for (i = 0; i < st_tableSize; i++)
+  {
+    record = st_records[i];
+    if (!record || !record->moveDue)
+      continue;
+    record->moveDue = 0;
+    if (!record->resident)
+      continue;
+
+    if (record->source.placement == ST_PLACE_RAM)
+    {
+      moveRecord(record, SF2D_PLACE_RAM);
+      continue;
+    }
+
+    space = vramSpaceFree();
+    reserve = record->source.placement == ST_PLACE_AUTO ?
+      ST_RESIDENCY_VRAM_RESERVE : 0;
+    if (space > reserve && record->bytes <= space - reserve &&
+      moveRecord(record, SF2D_PLACE_VRAM))
+      continue;
+    if (buried)
+    {
+      record->moveDue = 1;
+      st_moveDue = 1;
+    }
+  }
+}
+
+/*******************************\
+|*     Residency Functions     *|
+\*******************************/
+/* Inits the residency manager */
+u8 ST_ResidencyInit(void)
+{
+  if (!st_tableSize && !growTable())
+    return 0;
+
+  return 1;
+}
+
+/* Frees all bookkeeping. Spritesheets themselves are left alone */
+u8 ST_ResidencyFini(void)
+{
+  u32 i;
+  sweepGraveyard(1);
+  for (i = 0; i < st_tableSize; i++)
+    free(st_records[i]);
+  free(st_records);
+  st_records = NULL;
+  st_tableSize = 0;
+  st_recordCount = 0;
+  st_used = 0;
+  st_lastTouched = NULL;
+
+  return 1;
+}
+
+/* Sets the texture memory budget in bytes (0 = no limit) */
+void ST_ResidencySetBudget(u32 bytes)
+{
+  st_budget = bytes;
+  if (st_budget)
+    trimTo(st_budget, NULL);
+}
+
+/* Returns the texture memory budget in bytes */
+u32 ST_ResidencyGetBudget(void)
+{
+  return st_budget;
+}
+
+/* Returns the bytes of texture data currently loaded */
+u32 ST_ResidencyUsed(void)
+{
+  return st_used;
+}
+
+/* Starts tracking a spritesheet */
+/* Takes a pointer to a spritesheet and where it was loaded from */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencyAdd(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source)
+{
+  st_residency *record;
+
+  if (!spritesheet || findSlot(spritesheet) >= 0)
+    return 0;
+
+  /* Keep the table at most half full so probes stay short */
+  if ((st_recordCount + 1) * 2 > st_tableSize && !growTable())
+    return 0;
+
+  record = calloc(sizeof(st_residency), 1);
+  if (!record)
+    return 0;
+
+  record->spritesheet = spritesheet;
+  record->source = *source;
+  record->bytes = spritesheet->tex.size;
+  record->lastFrame = st_frame;
+  record->resident = 1;
+  insertRecord(record);
+  st_recordCount++;
+  st_used += record->bytes;
+
+  if (st_budget)
+    trimTo(st_budget, record);
+
+  return 1;
+}
+
+/* Stops tracking a spritesheet */
+/* Takes a pointer to a spritesheet */
+void ST_ResidencyRemove(st_spritesheet *spritesheet)
+{
+  s32 slot = findSlot(spritesheet);
+  st_residency *record;
+
+  if (slot < 0)
+    return;
+
+  record = st_records[slot];
+  if (record->resident)
+    st_used -= record->bytes;
+  if (st_lastTouched == record)
+    st_lastTouched = NULL;
+  removeSlot(slot);
+  st_recordCount--;
+  free(record);
+}
+
+/* Returns the bookkeeping of a spritesheet or NULL if it isn't tracked */
+/* Takes a pointer to a spritesheet */
+st_residency *ST_ResidencyGet(st_spritesheet *spritesheet)
+{
+  s32 slot;
+
+  if (st_lastTouched && st_lastTouched->spritesheet == spritesheet)
+    return st_lastTouched;
+
+  slot = findSlot(spritesheet);
+  if (slot < 0)
+    return NULL;
+  return st_records[slot];
+}
+
+/* Marks a spritesheet as drawn this frame, reloading it if needed */
+/* Takes a pointer to a spritesheet */
+/* Returns 1 if the spritesheet is loaded and 0 if it couldn't be */
+u8 ST_ResidencyTouch(st_spritesheet *spritesheet)
+{
+  return ST_ResidencyTouchSampled(spritesheet, 0);
+}
+
+/* Same as ST_ResidencyTouch, but also counts how many texels are drawn */
+/* Takes a pointer to a spritesheet and number of texels drawn */
+/* Returns 1 if the spritesheet is loaded and 0 if it couldn't be */
+u8 ST_ResidencyTouchSampled(st_spritesheet *spritesheet, u32 texels)
+{
+  st_residency *record = ST_ResidencyGet(spritesheet);
+
+  /* Untracked spritesheets are always loaded */
+  if (!record)
+    return spritesheet != NULL;
+
+  st_lastTouched = record;
+  record->lastFrame = st_frame;
+  record->pressure += texels;
+  if (!record->resident)
+    return reloadRecord(record);
+
+  return 1;
+}
+
+/* Frees the texture data of a spritesheet until it's drawn again */
+/* Takes a pointer to a spritesheet */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencyEvict(st_spritesheet *spritesheet)
+{
+  st_residency *record = ST_ResidencyGet(spritesheet);
+
+  if (!record || !canEvict(record, NULL))
+    return 0;
+
+  evictRecord(record);
+  return 1;
+}
+
+/* Returns 1 if a spritesheet's texture data is loaded and 0 if not */
+/* Takes a pointer to a spritesheet */
+u8 ST_ResidencyIsResident(st_spritesheet *spritesheet)
+{
+  st_residency *record = ST_ResidencyGet(spritesheet);
+
+  if (!record)
+    return spritesheet != NULL;
+  return record->resident;
+}
+
+/* Evicts least recently drawn spritesheets until no more than the given */
+/*   number of bytes are in use, or nothing else can be evicted */
+/* Takes a number of bytes */
+/* Returns number of bytes freed */
+u32 ST_ResidencyTrim(u32 bytes)
+{
+  return trimTo(bytes, NULL);
+}
+
+/* Moves on to the next frame. ST_RenderEndRender calls this */
+void ST_ResidencyFrame(void)
+{
+  st_frame++;
+  sweepGraveyard(0);
+  if (st_frame % ST_RESIDENCY_PLACEMENT_WINDOW == 0)
+    st_placeDue = 1;
+}
+
+/* Returns the current frame number */
+u32 ST_ResidencyFrameCount(void)
+{
+  return st_frame;
+}
+
+/* Changes the placement hint of a spritesheet */
+/* Takes a pointer to a spritesheet and a placement */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ResidencySetPlacement(st_spritesheet *spritesheet,
+  st_placement placement)
+{
+  st_residency *record = ST_ResidencyGet(spritesheet);
+
+  if (!record)
+    return 0;
+
+  record->source.placement = placement;
+  /* Automatic placement waits for the next placement window */
+  record->moveDue = placement != ST_PLACE_AUTO;
+  if (record->moveDue)
+    st_moveDue = 1;
+
+  return 1;
+}
+
+/* Moves automatically placed spritesheets between RAM and VRAM */
+void ST_ResidencyPlace(void)
+{
+  st_residency **hot;
+  st_residency *record;
+  u32 count = 0;
+  u32 space;
+  u32 i;
+
+  if (!st_placeDue)
+  {
+    if (st_moveDue)
+      movePending();
+    return;
+  }
+  st_placeDue = 0;
+
+  hot = calloc(st_recordCount ? st_recordCount : 1, sizeof(st_residency *));
+  if (!hot)
+    return;
+
+  /* VRAM already held by automatic spritesheets is up for grabs too */
+  space = vramSpaceFree();
+  for (i = 0; i < st_tableSize; i++)
+  {
+    record = st_records[i];
+    if (!record || !record->resident ||
+      record->source.placement != ST_PLACE_AUTO)
+      continue;
+    if (record->spritesheet->place == SF2D_PLACE_VRAM)
+      space += record->bytes;
+    hot[count++] = record;
+  }
+  space = space > ST_RESIDENCY_VRAM_RESERVE ?
+    space - ST_RESIDENCY_VRAM_RESERVE : 0;
+
+  qsort(hot, count, sizeof(st_residency *), comparePressure);
+
+  /* Hand out VRAM hottest first. Anything that doesn't get some is */
+  /*   pulled out of the list so it can be demoted */
+  for (i = 0; i < count; i++)
+  {
+    if (hot[i]->pressure && hot[i]->bytes <= space)
+    {
+      space -= hot[i]->bytes;
+      continue;
+    }
+    hot[i]->moveDue = 0;
+    moveRecord(hot[i], SF2D_PLACE_RAM);
+    hot[i] = NULL;
+  }
+
+  /* Demoted data stays in VRAM until the GPU is done with it, so */
+  /*   promotions that need its room wait for it to be freed */
+  for (i = 0; i < count; i++)
+  {
+    if (hot[i] && hot[i]->spritesheet->place != SF2D_PLACE_VRAM)
+    {
+      hot[i]->moveDue = 1;
+      st_moveDue = 1;
+    }
+  }
+  free(hot);
+  movePending();
+
+  for (i = 0; i < st_tableSize; i++)
+  {
+    if (st_records[i])
+      st_records[i]->pressure = 0;
+  }
+}
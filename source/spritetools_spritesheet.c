@@ -5,8 +5,698 @@
 */
 
 #include <3ds.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
 #include "spritetools/spritetools_spritesheet.h"
+#include "spritetools/spritetools_residency.h"
+#include "spritetools/spritetools_archive.h"
+#include "spritetools/spritetools_pixel.h"
 #include <sfil.h>
+#include <png.h>
+#include <jpeglib.h>
+
+
+/* Sources bigger than this aren't believed when measuring PNGs */
+#define ST_CACHE_MAX_SIZE 0x4000000
+
+/* Largest width or height a texture can have */
+#define ST_DECODE_MAX_SIDE 1024
+
+/* Size of the headers of the BMP files that can be decoded */
+#define ST_BMP_HEADER_SIZE 54
+
+/* Spritesheet shared by every load of the same content */
+typedef struct {
+  u64 key; /* Hash of the content, or of the archive entry */
+  u32 size;
+  st_sourcetype type;
+  st_spritesheet *spritesheet;
+  u32 refs;
+} st_cacheentry;
+
+static st_cacheentry *st_cache = NULL;
+static u32 st_cacheCount = 0;
+static u32 st_cacheCapacity = 0;
+
+/* Returns a 64 bit hash of some bytes */
+/*   Two murmur style lanes take turns on 32 bit words, which the ARM11 */
+/*   multiplies much faster than 64 bit ones */
+static u64 hashBytes(const u8 *data, u32 size)
+{
+  u32 h[2] = {0x9E3779B9 ^ size, 0x85EBCA6B + size};
+  u32 i, k, tail = 0;
+
+  for (i = 0; i + 4 <= size; i += 4)
+  {
+    memcpy(&k, data + i, 4);
+    k *= 0xCC9E2D51;
+    k = (k << 15) | (k >> 17);
+    k *= 0x1B873593;
+    h[(i >> 2) & 1] ^= k;
+    h[(i >> 2) & 1] = ((h[(i >> 2) & 1] << 13) | (h[(i >> 2) & 1] >> 19)) *
+      5 + 0xE6546B64;
+  }
+  for (k = 0; i < size; i++, k += 8)
+    tail |= (u32)data[i] << k;
+  h[0] ^= tail * 0xCC9E2D51;
+
+  /* Let each lane's bits reach the other */
+  for (i = 0; i < 2; i++)
+  {
+    h[0] ^= h[1] >> 16;
+    h[0] *= 0x85EBCA6B;
+    h[1] ^= h[0] >> 13;
+    h[1] *= 0xC2B2AE35;
+  }
+  return ((u64)h[0] << 32) | h[1];
+}
+
+/* Returns the size of a PNG file by walking its chunks, or 0 */
+/*   Only for decoding PNGs given without a size, which sfil trusts the */
+/*   same way. The cache never walks buffers it doesn't know the size of */
+static u32 pngSize(const u8 *png)
+{
+  static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+    '\n'};
+  u32 offset = 8, length;
+
+  if (memcmp(png, signature, 8))
+    return 0;
+  for (;;)
+  {
+    length = (png[offset] << 24) | (png[offset + 1] << 16) |
+      (png[offset + 2] << 8) | png[offset + 3];
+    if (length > ST_CACHE_MAX_SIZE)
+      return 0;
+    if (!memcmp(png + offset + 4, "IEND", 4))
+      return offset + 12 + length;
+    offset += 12 + length;
+    if (offset > ST_CACHE_MAX_SIZE)
+      return 0;
+  }
+}
+
+/* Works out the cache key of a source */
+/* Returns 1 if it can be cached, 0 if not */
+static u8 sourceKey(const st_spritesheetsource *source, u64 *key, u32 *size)
+{
+  const u8 *data = source->buffer;
+  const st_textureheader *header;
+
+  switch (source->type)
+  {
+    case ST_SOURCE_RGBA8:
+      *size = source->width * source->height * 4;
+      *key = hashBytes(data, *size) ^
+        ((u64)source->format << 48 | (u64)source->width << 24 |
+        source->height);
+      return *size != 0;
+    case ST_SOURCE_PNG:
+      /* PNGs without a size aren't cached */
+      *size = source->size;
+      break;
+    case ST_SOURCE_BMP:
+      if (data[0] != 'B' || data[1] != 'M')
+        return 0;
+      *size = data[2] | (data[3] << 8) | (data[4] << 16) | (data[5] << 24);
+      break;
+    case ST_SOURCE_JPEG:
+      *size = source->size;
+      break;
+    case ST_SOURCE_TEXTURE:
+      header = source->buffer;
+      if (header->magic != ST_TEXTURE_MAGIC)
+        return 0;
+      *size = sizeof(st_textureheader) + header->dataSize;
+      break;
+    case ST_SOURCE_ARCHIVE:
+      /* Entries are already named, so the entry itself is the key */
+      *size = source->size;
+      *key = (u64)(uintptr_t)source->buffer << 32 | source->size;
+      return 1;
+    default:
+      return 0;
+  }
+
+  if (!*size || *size > ST_CACHE_MAX_SIZE)
+    return 0;
+  *key = hashBytes(data, *size);
+  return 1;
+}
+
+/* Returns the cache entry of a spritesheet or NULL */
+static st_cacheentry *cacheEntry(st_spritesheet *spritesheet)
+{
+  u32 i;
+
+  for (i = 0; i < st_cacheCount; i++)
+    if (st_cache[i].spritesheet == spritesheet)
+      return &st_cache[i];
+  return NULL;
+}
+
+/* Returns the cached spritesheet for a key without adding a reference */
+static st_spritesheet *cacheLookup(u64 key, u32 size, st_sourcetype type)
+{
+  u32 i;
+
+  for (i = 0; i < st_cacheCount; i++)
+    if (st_cache[i].key == key && st_cache[i].size == size &&
+      st_cache[i].type == type)
+      return st_cache[i].spritesheet;
+  return NULL;
+}
+
+/* Adds a spritesheet to the cache with one reference */
+static void cacheAdd(st_spritesheet *spritesheet, u64 key, u32 size,
+  st_sourcetype type)
+{
+  st_cacheentry *cache;
+  u32 capacity;
+
+  if (st_cacheCount >= st_cacheCapacity)
+  {
+    capacity = st_cacheCapacity ? st_cacheCapacity * 2 : 32;
+    cache = realloc(st_cache, capacity * sizeof(st_cacheentry));
+    /* Without room it just won't be shared */
+    if (!cache)
+      return;
+    st_cache = cache;
+    st_cacheCapacity = capacity;
+  }
+
+  st_cache[st_cacheCount].key = key;
+  st_cache[st_cacheCount].size = size;
+  st_cache[st_cacheCount].type = type;
+  st_cache[st_cacheCount].spritesheet = spritesheet;
+  st_cache[st_cacheCount].refs = 1;
+  st_cacheCount++;
+}
+
+/* Copies linear texels the size of a texture into its tiled layout */
+static void tileTexels(const void *src, void *dst, u32 width, u32 height,
+  u32 bytes)
+{
+  if (bytes == 4)
+    ST_PixelTile32(src, width, width, height, dst, width, height, 0);
+  else
+    ST_PixelTile16(src, width, width, height, dst, width, height);
+}
+
+/* Makes a spritesheet out of RGBA8 pixels, converting them to a format */
+static st_spritesheet *loadPixels(const st_spritesheetsource *source,
+  sf2d_place place)
+{
+  u32 bits = ST_TextureFormatBits(source->format);
+  u32 count = source->width * source->height;
+  st_spritesheet *spritesheet;
+  u16 *packed;
+
+  if (bits != 32 && bits != 16)
+    return NULL;
+
+  spritesheet = sf2d_create_texture(source->width, source->height,
+    (sf2d_texfmt)source->format, place);
+  if (!spritesheet)
+    return NULL;
+
+  /* Padding isn't written by the tiler, so keep it from being garbage */
+  if (spritesheet->tex.width != source->width ||
+    spritesheet->tex.height != source->height)
+    memset(spritesheet->tex.data, 0, spritesheet->tex.size);
+
+  if (bits == 32)
+    ST_PixelTile32(source->buffer, source->width, source->width,
+      source->height, spritesheet->tex.data, spritesheet->tex.width,
+      spritesheet->tex.height, 1);
+  else
+  {
+    packed = malloc(count * sizeof(u16));
+    if (!packed)
+    {
+      sf2d_free_texture(spritesheet);
+      return NULL;
+    }
+    ST_PixelPack16(source->buffer, packed, count, source->format);
+    ST_PixelTile16(packed, source->width, source->width, source->height,
+      spritesheet->tex.data, spritesheet->tex.width, spritesheet->tex.height);
+    free(packed);
+  }
+  GSPGPU_FlushDataCache(spritesheet->tex.data, spritesheet->tex.size);
+  spritesheet->tiled = 1;
+
+  return spritesheet;
+}
+
+/* Makes an empty spritesheet for a converted texture's header */
+static st_spritesheet *createTexture(const st_textureheader *header)
+{
+  st_spritesheet *spritesheet;
+  u32 bits = ST_TextureFormatBits(header->format);
+
+  if (header->magic != ST_TEXTURE_MAGIC ||
+    header->version != ST_TEXTURE_VERSION || !bits)
+    return NULL;
+  /* Block compressed formats can't be tiled at load time */
+  if (bits < 16 && !(header->flags & ST_TEXTURE_TILED))
+    return NULL;
+
+  spritesheet = sf2d_create_texture(header->width, header->height,
+    header->format, SF2D_PLACE_RAM);
+  if (!spritesheet)
+    return NULL;
+  if (spritesheet->tex.width != header->pow2Width ||
+    spritesheet->tex.height != header->pow2Height ||
+    spritesheet->tex.size != header->dataSize)
+  {
+    sf2d_free_texture(spritesheet);
+    return NULL;
+  }
+  spritesheet->tiled = 1;
+
+  return spritesheet;
+}
+
+/* Makes a spritesheet out of a converted texture */
+static st_spritesheet *loadTexture(const void *buffer)
+{
+  const st_textureheader *header = buffer;
+  const u8 *data = (const u8 *)buffer + sizeof(st_textureheader);
+  st_spritesheet *spritesheet = createTexture(header);
+
+  if (!spritesheet)
+    return NULL;
+
+  if (header->flags & ST_TEXTURE_TILED)
+    memcpy(spritesheet->tex.data, data, header->dataSize);
+  else
+    tileTexels(data, spritesheet->tex.data, header->pow2Width,
+      header->pow2Height, ST_TextureFormatBits(header->format) / 8);
+  GSPGPU_FlushDataCache(spritesheet->tex.data, spritesheet->tex.size);
+
+  return spritesheet;
+}
+
+/* Makes a spritesheet out of a converted texture in an archive file */
+/*   Tiled texel data is read straight into the texture */
+static st_spritesheet *streamTexture(st_archive *archive, s32 index)
+{
+  const st_archiveentry *entry = ST_ArchiveEntry(archive, index);
+  st_textureheader header;
+  st_spritesheet *spritesheet;
+  void *temp;
+  u32 size;
+
+  if (ST_ArchiveRead(archive, index, 0, &header, sizeof(header)) !=
+    sizeof(header) || header.dataSize > entry->size - sizeof(header))
+    return NULL;
+  spritesheet = createTexture(&header);
+  if (!spritesheet)
+    return NULL;
+
+  size = header.dataSize;
+  if (header.flags & ST_TEXTURE_TILED)
+  {
+    if (ST_ArchiveRead(archive, index, sizeof(header),
+      spritesheet->tex.data, size) != size)
+    {
+      sf2d_free_texture(spritesheet);
+      return NULL;
+    }
+  }
+  else
+  {
+    temp = malloc(size);
+    if (!temp || ST_ArchiveRead(archive, index, sizeof(header), temp,
+      size) != size)
+    {
+      free(temp);
+      sf2d_free_texture(spritesheet);
+      return NULL;
+    }
+    tileTexels(temp, spritesheet->tex.data, header.pow2Width,
+      header.pow2Height, ST_TextureFormatBits(header.format) / 8);
+    free(temp);
+  }
+  GSPGPU_FlushDataCache(spritesheet->tex.data, spritesheet->tex.size);
+
+  return spritesheet;
+}
+
+/* Makes a spritesheet out of an archive entry */
+static st_spritesheet *loadArchive(st_archive *archive, s32 index,
+  sf2d_place place)
+{
+  const st_archiveentry *entry = ST_ArchiveEntry(archive, index);
+  const void *data = ST_ArchiveData(archive, index);
+  st_spritesheet *spritesheet;
+  void *temp = NULL;
+
+  if (!entry)
+    return NULL;
+
+  if (entry->type == ST_ARCHIVE_TEXTURE)
+  {
+    if (data)
+      return entry->size < sizeof(st_textureheader) ? NULL :
+        loadTexture(data);
+    return streamTexture(archive, index);
+  }
+
+  /* Images have to be whole to be decoded */
+  if (!data)
+  {
+    temp = malloc(entry->size);
+    if (!temp || ST_ArchiveRead(archive, index, 0, temp, entry->size) !=
+      entry->size)
+    {
+      free(temp);
+      return NULL;
+    }
+    data = temp;
+  }
+
+  switch (entry->type)
+  {
+    case ST_ARCHIVE_PNG:
+      spritesheet = sfil_load_PNG_buffer(data, place);
+      break;
+    case ST_ARCHIVE_BMP:
+      spritesheet = sfil_load_BMP_buffer(data, place);
+      break;
+    case ST_ARCHIVE_JPEG:
+      spritesheet = sfil_load_JPEG_buffer(data, entry->size, place);
+      break;
+    default:
+      spritesheet = NULL;
+      break;
+  }
+
+  free(temp);
+  return spritesheet;
+}
+
+/* libjpeg error handler that jumps back out of the decoder */
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf jump;
+} st_jpegerror;
+
+static void jpegError(j_common_ptr info)
+{
+  longjmp(((st_jpegerror *)info->err)->jump, 1);
+}
+
+/* Decodes a PNG file into RGBA8 pixels */
+/* Returns the pixels or NULL on failure */
+static u8 *decodePNG(const void *buffer, u32 size, u32 *width, u32 *height)
+{
+  png_image image;
+  u8 *pixels;
+
+  if (!size)
+    return NULL;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_memory(&image, buffer, size))
+    return NULL;
+  if (image.width > ST_DECODE_MAX_SIDE || image.height > ST_DECODE_MAX_SIDE)
+  {
+    png_image_free(&image);
+    return NULL;
+  }
+
+  image.format = PNG_FORMAT_RGBA;
+  pixels = malloc(PNG_IMAGE_SIZE(image));
+  if (!pixels || !png_image_finish_read(&image, NULL, pixels, 0, NULL))
+  {
+    png_image_free(&image);
+    free(pixels);
+    return NULL;
+  }
+  *width = image.width;
+  *height = image.height;
+
+  return pixels;
+}
+
+/* Decodes an uncompressed 24 or 32 bit BMP file into RGBA8 pixels */
+/*   Like sfil, the fourth byte of 32 bit pixels is ignored */
+/* Returns the pixels or NULL on failure */
+static u8 *decodeBMP(const u8 *bmp, u32 size, u32 *width, u32 *height)
+{
+  u32 offset, bytes, pitch, row, x, y;
+  s32 w, h;
+  const u8 *src;
+  u8 *pixels, *dst;
+
+  if (size < ST_BMP_HEADER_SIZE || bmp[0] != 'B' || bmp[1] != 'M')
+    return NULL;
+  memcpy(&offset, bmp + 10, 4);
+  memcpy(&w, bmp + 18, 4);
+  memcpy(&h, bmp + 22, 4);
+  bytes = (bmp[28] | (bmp[29] << 8)) / 8;
+  if ((bytes != 3 && bytes != 4) || (bmp[30] && bmp[30] != 3))
+    return NULL;
+  /* Checked before any sizes are worked out so none of them can wrap */
+  if (w <= 0 || w > ST_DECODE_MAX_SIDE || !h || h > ST_DECODE_MAX_SIDE ||
+    h < -ST_DECODE_MAX_SIDE)
+    return NULL;
+
+  *width = w;
+  *height = h < 0 ? -h : h;
+  pitch = (*width * bytes + 3) & ~3;
+  if (offset > size || (size - offset) / pitch < *height)
+    return NULL;
+  pixels = malloc(*width * *height * 4);
+  if (!pixels)
+    return NULL;
+
+  /* Rows are stored bottom up unless the height is negative */
+  for (y = 0; y < *height; y++)
+  {
+    row = h < 0 ? y : *height - 1 - y;
+    src = bmp + offset + row * pitch;
+    dst = pixels + y * *width * 4;
+    for (x = 0; x < *width; x++, src += bytes, dst += 4)
+    {
+      dst[0] = src[2];
+      dst[1] = src[1];
+      dst[2] = src[0];
+      dst[3] = 0xFF;
+    }
+  }
+
+  return pixels;
+}
+
+/* Decodes a JPEG file into RGBA8 pixels */
+/* Returns the pixels or NULL on failure */
+static u8 *decodeJPEG(const void *buffer, u32 size, u32 *width, u32 *height)
+{
+  struct jpeg_decompress_struct info;
+  st_jpegerror error;
+  u8 *volatile pixels = NULL;
+  JSAMPROW row;
+
+  info.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = jpegError;
+  if (setjmp(error.jump))
+  {
+    jpeg_destroy_decompress(&info);
+    free(pixels);
+    return NULL;
+  }
+
+  jpeg_create_decompress(&info);
+  jpeg_mem_src(&info, (unsigned char *)buffer, size);
+  jpeg_read_header(&info, TRUE);
+  if (info.image_width > ST_DECODE_MAX_SIDE ||
+    info.image_height > ST_DECODE_MAX_SIDE)
+  {
+    jpeg_destroy_decompress(&info);
+    return NULL;
+  }
+  info.out_color_space = JCS_EXT_RGBA;
+  jpeg_start_decompress(&info);
+
+  pixels = malloc(info.output_width * info.output_height * 4);
+  if (!pixels)
+  {
+    jpeg_destroy_decompress(&info);
+    return NULL;
+  }
+  while (info.output_scanline < info.output_height)
+  {
+    row = pixels + info.output_scanline * info.output_width * 4;
+    jpeg_read_scanlines(&info, &row, 1);
+  }
+  *width = info.output_width;
+  *height = info.output_height;
+
+  jpeg_finish_decompress(&info);
+  jpeg_destroy_decompress(&info);
+  return pixels;
+}
+
+/* Decodes an image file of some type into RGBA8 pixels */
+/* Returns the pixels or NULL on failure */
+static u8 *decodeImage(st_sourcetype type, const void *buffer, u32 size,
+  u32 *width, u32 *height)
+{
+  switch (type)
+  {
+    case ST_SOURCE_PNG:
+      return decodePNG(buffer, size, width, height);
+    case ST_SOURCE_BMP:
+      return decodeBMP(buffer, size, width, height);
+    case ST_SOURCE_JPEG:
+      return decodeJPEG(buffer, size, width, height);
+    default:
+      return NULL;
+  }
+}
+
+/* Reads an archive entry into memory, decoding it if it's an image */
+/* Returns 1 on success and 0 on failure */
+static u8 decodeArchive(st_archive *archive, s32 index,
+  st_decodedsource *decoded)
+{
+  const st_archiveentry *entry = ST_ArchiveEntry(archive, index);
+  const void *data = ST_ArchiveData(archive, index);
+  const st_textureheader *header;
+  void *temp = NULL;
+  u32 width, height;
+  u8 *pixels;
+
+  if (!entry)
+    return 0;
+  if (!data)
+  {
+    temp = malloc(entry->size);
+    if (!temp || ST_ArchiveRead(archive, index, 0, temp, entry->size) !=
+      entry->size)
+    {
+      free(temp);
+      return 0;
+    }
+    data = temp;
+  }
+
+  if (entry->type == ST_ARCHIVE_TEXTURE)
+  {
+    header = data;
+    if (entry->size < sizeof(st_textureheader) ||
+      header->dataSize > entry->size - sizeof(st_textureheader))
+    {
+      free(temp);
+      return 0;
+    }
+    decoded->source.type = ST_SOURCE_TEXTURE;
+    decoded->source.buffer = data;
+    decoded->pixels = temp;
+    return 1;
+  }
+
+  switch (entry->type)
+  {
+    case ST_ARCHIVE_PNG:
+      pixels = decodeImage(ST_SOURCE_PNG, data, entry->size, &width, &height);
+      break;
+    case ST_ARCHIVE_BMP:
+      pixels = decodeImage(ST_SOURCE_BMP, data, entry->size, &width, &height);
+      break;
+    case ST_ARCHIVE_JPEG:
+      pixels = decodeImage(ST_SOURCE_JPEG, data, entry->size, &width,
+        &height);
+      break;
+    default:
+      pixels = NULL;
+      break;
+  }
+  free(temp);
+  if (!pixels)
+    return 0;
+
+  decoded->source.type = ST_SOURCE_RGBA8;
+  decoded->source.buffer = pixels;
+  decoded->source.width = width;
+  decoded->source.height = height;
+  decoded->source.format = ST_TEXFMT_RGBA8;
+  decoded->pixels = pixels;
+  return 1;
+}
+
+/* Gives a cached spritesheet another reference for a new load */
+/*   Asking for VRAM moves it there. Other hints leave it where it is */
+static st_spritesheet *shareCached(st_spritesheet *cached,
+  const st_spritesheetsource *source)
+{
+  cacheEntry(cached)->refs++;
+  if (source->placement == ST_PLACE_VRAM &&
+    cached->place != SF2D_PLACE_VRAM)
+    ST_ResidencySetPlacement(cached, ST_PLACE_VRAM);
+  return cached;
+}
+
+/* Hands a new spritesheet to the cache and the residency manager */
+/*   Sources the library can't count on staying valid are recorded as */
+/*   ST_SOURCE_NONE, so they are never evicted and reloaded */
+static st_spritesheet *trackSource(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source, u8 reloadable)
+{
+  st_spritesheetsource kept = *source;
+  st_spritesheet *cached;
+  u64 key;
+  u32 size;
+
+  if (sourceKey(source, &key, &size))
+  {
+    cached = cacheLookup(key, size, source->type);
+    if (cached)
+    {
+      sf2d_free_texture(spritesheet);
+      return shareCached(cached, source);
+    }
+    cacheAdd(spritesheet, key, size, source->type);
+  }
+
+  if (!reloadable)
+  {
+    kept.type = ST_SOURCE_NONE;
+    kept.buffer = NULL;
+  }
+  ST_ResidencyAdd(spritesheet, &kept);
+
+  /* Converted textures are always staged in RAM first, and moved to VRAM */
+  /*   at the end of the frame */
+  if (source->placement == ST_PLACE_VRAM &&
+    spritesheet->place != SF2D_PLACE_VRAM)
+    ST_ResidencySetPlacement(spritesheet, ST_PLACE_VRAM);
+
+  return spritesheet;
+}
+
+/* Loads a source, evicting idle spritesheets and trying again if memory */
+/*   runs out */
+static st_spritesheet *createSource(const st_spritesheetsource *source,
+  u8 reloadable)
+{
+  st_spritesheet *spritesheet = ST_SpritesheetCacheFind(source);
+
+  if (spritesheet)
+    return spritesheet;
+
+  spritesheet = ST_SpritesheetLoadSource(source);
+  if (!spritesheet && ST_ResidencyTrim(0))
+    spritesheet = ST_SpritesheetLoadSource(source);
+  if (!spritesheet)
+    return NULL;
+
+  return trackSource(spritesheet, source, reloadable);
+}
 
 /*********************************\
 |*     Spritesheet Functions     *|
@@ -17,17 +707,202 @@
 st_spritesheet *ST_SpritesheetCreateSpritesheet(const unsigned char *pixel_data,
     unsigned int width, unsigned int height)
 {
-  return sf2d_create_texture_mem_RGBA8(pixel_data, width, height,
-    TEXFMT_RGBA8, SF2D_PLACE_RAM);
+  st_spritesheetsource source = {ST_SOURCE_RGBA8, pixel_data, 0,
+    width, height, ST_PLACE_AUTO};
+  return createSource(&source, 0);
+}
+
+/* Load spritesheet from image, converting it to a smaller texel format */
+/* Takes image and format (ST_TEXFMT_RGB565, RGB5A1 or RGBA4) */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetFormat(
+  const unsigned char *pixel_data, unsigned int width, unsigned int height,
+  st_texformat format)
+{
+  st_spritesheetsource source = {ST_SOURCE_RGBA8, pixel_data, 0,
+    width, height, ST_PLACE_AUTO, format};
+  return createSource(&source, 0);
+}
+
+/* Load spritesheet from a source with a placement hint */
+/*   Loading the same content again returns the same spritesheet with */
+/*   another reference. If memory runs out, idle spritesheets are evicted */
+/*   and it tries again */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetSource(
+  const st_spritesheetsource *source)
+{
+  return createSource(source, 1);
+}
+
+/* Hands a spritesheet made by ST_SpritesheetLoadSource to the cache and */
+/*   the residency manager, and moves it where its placement hint wants it */
+/*   If the same content was loaded in the meantime, the new spritesheet */
+/*   is freed and the cached one is returned with another reference */
+/* Takes st_spritesheet and pointer to the source it was loaded from */
+/* Returns pointer to the st_spritesheet to use */
+st_spritesheet *ST_SpritesheetTrackSource(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source)
+{
+  return trackSource(spritesheet, source, 1);
+}
+
+/* Same as ST_SpritesheetTrackSource, but the source's buffer isn't kept */
+/*   The buffer can be freed afterward and the spritesheet is never evicted */
+/* Takes st_spritesheet and pointer to the source it was loaded from */
+/* Returns pointer to the st_spritesheet to use */
+st_spritesheet *ST_SpritesheetTrackBorrowed(st_spritesheet *spritesheet,
+  const st_spritesheetsource *source)
+{
+  return trackSource(spritesheet, source, 0);
+}
+
+/* Finds a spritesheet already loaded from the same content as a source */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet with another reference, or NULL */
+st_spritesheet *ST_SpritesheetCacheFind(const st_spritesheetsource *source)
+{
+  st_spritesheet *spritesheet;
+  u64 key;
+  u32 size;
+
+  if (!st_cacheCount || !sourceKey(source, &key, &size))
+    return NULL;
+  spritesheet = cacheLookup(key, size, source->type);
+  if (spritesheet)
+    return shareCached(spritesheet, source);
+
+  return NULL;
+}
+
+/* Returns how many loads share a spritesheet */
+/* Takes st_spritesheet */
+u32 ST_SpritesheetReferences(st_spritesheet *spritesheet)
+{
+  st_cacheentry *entry = cacheEntry(spritesheet);
+  return entry ? entry->refs : 1;
 }
 
 /* Free spritesheet */
+/*   Shared spritesheets are only freed when the last reference is */
 /* Takes st_spritesheet */
 void ST_SpritesheetFreeSpritesheet(st_spritesheet *spritesheet)
 {
+  st_cacheentry *entry = cacheEntry(spritesheet);
+
+  if (entry)
+  {
+    if (--entry->refs)
+      return;
+    *entry = st_cache[--st_cacheCount];
+  }
+
+  ST_ResidencyRemove(spritesheet);
   sf2d_free_texture(spritesheet);
 }
 
+/* Decodes a source into a new spritesheet without tracking it */
+/* Takes pointer to a source */
+/* Returns pointer to st_spritesheet or NULL on failure */
+st_spritesheet *ST_SpritesheetLoadSource(const st_spritesheetsource *source)
+{
+  /* Automatic placement starts out in RAM until it proves to be hot */
+  sf2d_place place = source->placement == ST_PLACE_VRAM ?
+    SF2D_PLACE_VRAM : SF2D_PLACE_RAM;
+
+  switch (source->type)
+  {
+    case ST_SOURCE_RGBA8:
+      return loadPixels(source, place);
+    case ST_SOURCE_PNG:
+      return sfil_load_PNG_buffer(source->buffer, place);
+    case ST_SOURCE_BMP:
+      return sfil_load_BMP_buffer(source->buffer, place);
+    case ST_SOURCE_JPEG:
+      return sfil_load_JPEG_buffer(source->buffer, source->size, place);
+    case ST_SOURCE_TEXTURE:
+      return loadTexture(source->buffer);
+    case ST_SOURCE_ARCHIVE:
+      return loadArchive((st_archive *)source->buffer, source->size, place);
+    default:
+      return NULL;
+  }
+}
+
+/* Decodes a source into ordinary memory without making a texture */
+/*   Images come out as RGBA8 pixels and archive entries are read in, so */
+/*   ST_SpritesheetLoadSource only has to copy the result into a texture. */
+/*   Touches nothing shared, so it can run on any thread */
+/* Takes pointer to a source and pointer to where to put the result */
+/* Returns 1 on success and 0 on failure */
+u8 ST_SpritesheetDecodeSource(const st_spritesheetsource *source,
+  st_decodedsource *decoded)
+{
+  const u8 *bmp = source->buffer;
+  u32 width, height, size;
+  u8 *pixels;
+
+  decoded->source = *source;
+  decoded->pixels = NULL;
+
+  switch (source->type)
+  {
+    case ST_SOURCE_RGBA8:
+    case ST_SOURCE_TEXTURE:
+      /* Already in memory as they are */
+      return 1;
+    case ST_SOURCE_PNG:
+      size = source->size ? source->size : pngSize(source->buffer);
+      pixels = decodeImage(source->type, source->buffer, size, &width,
+        &height);
+      break;
+    case ST_SOURCE_BMP:
+      /* Without a size, trust the one in the file like sfil does */
+      size = source->size;
+      if (!size && bmp[0] == 'B' && bmp[1] == 'M')
+        size = bmp[2] | (bmp[3] << 8) | (bmp[4] << 16) | (bmp[5] << 24);
+      pixels = decodeImage(source->type, bmp, size, &width, &height);
+      break;
+    case ST_SOURCE_JPEG:
+      pixels = decodeImage(source->type, source->buffer, source->size,
+        &width, &height);
+      break;
+    case ST_SOURCE_ARCHIVE:
+      if (decodeArchive((st_archive *)source->buffer, source->size, decoded))
+        return 1;
+      pixels = NULL;
+      break;
+    default:
+      pixels = NULL;
+      break;
+  }
+
+  if (!pixels)
+  {
+    decoded->source.type = ST_SOURCE_NONE;
+    return 0;
+  }
+  decoded->source.type = ST_SOURCE_RGBA8;
+  decoded->source.buffer = pixels;
+  decoded->source.size = 0;
+  decoded->source.width = width;
+  decoded->source.height = height;
+  decoded->source.format = ST_TEXFMT_RGBA8;
+  decoded->pixels = pixels;
+
+  return 1;
+}
+
+/* Frees the memory a decoded source owns */
+/* Takes pointer to a decoded source */
+void ST_SpritesheetFreeDecoded(st_decodedsource *decoded)
+{
+  free(decoded->pixels);
+  decoded->pixels = NULL;
+  decoded->source.type = ST_SOURCE_NONE;
+}
+
 /**********************************\
 |*     SFILLIB Implimentation     *|
 \**********************************/
@@ -40,7 +915,9 @@ void ST_SpritesheetFreeSpritesheet(st_spritesheet *spritesheet)
 /* Returns pointer to st_spritesheet */
 st_spritesheet *ST_SpritesheetCreateSpritesheetPNG(const void *buffer)
 {
-  return sfil_load_PNG_buffer(buffer, SF2D_PLACE_RAM);
+  st_spritesheetsource source = {ST_SOURCE_PNG, buffer, 0, 0, 0,
+    ST_PLACE_AUTO};
+  return createSource(&source, 0);
 }
 
 /* Load spritesheet from image as a BMP file */
@@ -48,7 +925,9 @@ st_spritesheet *ST_SpritesheetCreateSpritesheetPNG(const void *buffer)
 /* Returns pointer to st_spritesheet */
 st_spritesheet *ST_SpritesheetCreateSpritesheetBMP(const void *buffer)
 {
-  return sfil_load_BMP_buffer(buffer, SF2D_PLACE_RAM);
+  st_spritesheetsource source = {ST_SOURCE_BMP, buffer, 0, 0, 0,
+    ST_PLACE_AUTO};
+  return createSource(&source, 0);
 }
 
 /* Load spritesheet from image as a JPEG file */
@@ -56,5 +935,20 @@ st_spritesheet *ST_SpritesheetCreateSpritesheetBMP(const void *buffer)
 /* Returns pointer to st_spritesheet */
 st_spritesheet *ST_SpritesheetCreateSpritesheetJPEG(const void *buffer, unsigned long buffer_size)
 {
-  return sfil_load_JPEG_buffer(buffer, buffer_size, SF2D_PLACE_RAM);
+  st_spritesheetsource source = {ST_SOURCE_JPEG, buffer, buffer_size, 0, 0,
+    ST_PLACE_AUTO};
+  return createSource(&source, 0);
+}
+
+/******************************************\
+|*     Converted Texture Spritesheets     *|
+\******************************************/
+/* Load spritesheet from a converted texture */
+/* Takes buffer */
+/* Returns pointer to st_spritesheet */
+st_spritesheet *ST_SpritesheetCreateSpritesheetTexture(const void *buffer)
+{
+  st_spritesheetsource source = {ST_SOURCE_TEXTURE, buffer, 0, 0, 0,
+    ST_PLACE_AUTO};
+  return createSource(&source, 0);
 }
@@ -0,0 +1,387 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spritetools/spritetools_statemachine.h"
+
+/* Number of entities a new state machine has room for */
+#define ST_STATE_INSTANCES_START 16
+
+/* Starts the animation of a state over, firing its first frame's events */
+static void enterState(st_statemachine *machine, s32 instance)
+{
+  st_entity *entity = machine->entities[instance];
+  st_animation *animation;
+  u8 id = machine->animations[machine->states[instance]];
+
+  if (id >= entity->animationCount)
+    return;
+
+  entity->currentAnim = id;
+  animation = entity->animations[id];
+  animation->ftn = 0;
+  if (animation->fpf >= 0 || !animation->length)
+    animation->currentFrame = 0;
+  else
+    animation->currentFrame = animation->length - 1;
+  ST_AnimationDispatchEvents(animation);
+}
+
+/* Returns 1 if an entity's animation is on its last frame and will loop */
+/*   the next time it is played (timed like ST_RenderAnimationPlayAdvanced, */
+/*   which entities are drawn with) */
+static u8 loopEnded(st_entity *entity)
+{
+  st_animation *animation;
+
+  if (entity->currentAnim >= entity->animationCount)
+    return 1;
+  animation = entity->animations[entity->currentAnim];
+  if (animation->length <= 1)
+    return 1;
+  if (animation->fpf >= 0)
+    return animation->currentFrame == animation->length - 1 &&
+      animation->ftn >= animation->fpf;
+  return animation->currentFrame == 0 && animation->ftn >= -animation->fpf;
+}
+
+/***********************************\
+|*     State Machine Functions     *|
+\***********************************/
+/* Returns a pointer to a state machine */
+/*   Returns NULL if failed */
+/* Takes the number of states and number of parameters */
+/*   State i plays animation i until set otherwise */
+st_statemachine *ST_StateMachineCreate(u8 stateCount, u8 paramCount)
+{
+  st_statemachine *machine;
+  u16 i;
+
+  if (!stateCount || stateCount == ST_STATE_ANY)
+    return NULL;
+
+  machine = calloc(1, sizeof(st_statemachine));
+  if (!machine)
+    return NULL;
+
+  machine->stateCount = stateCount;
+  machine->paramCount = paramCount;
+  machine->animations = malloc(stateCount);
+  machine->first = calloc(stateCount + 1, sizeof(u16));
+  if (!machine->animations || !machine->first)
+  {
+    ST_StateMachineFree(machine);
+    return NULL;
+  }
+  for (i = 0; i < stateCount; i++)
+    machine->animations[i] = i;
+  machine->dirty = 1;
+
+  return machine;
+}
+
+/* Frees a state machine from memory */
+/*   Its entities are not freed */
+/* Takes a pointer to a state machine */
+void ST_StateMachineFree(st_statemachine *machine)
+{
+  if (!machine)
+    return;
+
+  free(machine->animations);
+  free(machine->transitions);
+  free(machine->table);
+  free(machine->first);
+  free(machine->entities);
+  free(machine->states);
+  free(machine->params);
+  free(machine);
+}
+
+/* Sets the animation a state plays */
+/* Takes a pointer to a state machine, a state and an animation id */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineSetAnimation(st_statemachine *machine, u8 state,
+  u8 animation)
+{
+  if (state >= machine->stateCount)
+    return 0;
+
+  machine->animations[state] = animation;
+  return 1;
+}
+
+/* Adds a transition */
+/*   When several transitions of a state are met, the first one added wins. */
+/*   Transitions from a state come before ones from ST_STATE_ANY */
+/* Takes a pointer to a state machine, source state (or ST_STATE_ANY), */
+/*   destination state, parameter, condition and value to compare with */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineAddTransition(st_statemachine *machine, u8 from, u8 to,
+  u8 param, st_statecondition condition, float value)
+{
+  st_statetransition *transition;
+
+  if ((from >= machine->stateCount && from != ST_STATE_ANY) ||
+    to >= machine->stateCount || condition > ST_STATE_LOOP_END ||
+    (condition != ST_STATE_LOOP_END && param >= machine->paramCount))
+    return 0;
+
+  if (machine->transitionCount >= machine->transitionCapacity)
+  {
+    u16 capacity = machine->transitionCapacity ?
+      machine->transitionCapacity * 2 : 8;
+    st_statetransition *transitions = realloc(machine->transitions,
+      capacity * sizeof(st_statetransition));
+    if (!transitions)
+      return 0;
+    machine->transitions = transitions;
+    machine->transitionCapacity = capacity;
+  }
+
+  transition = &machine->transitions[machine->transitionCount++];
+  transition->from = from;
+  transition->to = to;
+  transition->param = param;
+  transition->condition = condition;
+  transition->value = value;
+  machine->dirty = 1;
+
+  return 1;
+}
+
+/* Builds the transition table */
+/*   ST_StateMachineUpdate does this itself when transitions changed */
+/* Takes a pointer to a state machine */
+/* Returns 1 on success and 0 on failure */
+u8 ST_StateMachineCompile(st_statemachine *machine)
+{
+  st_statetransition *table, *transition;
+  u32 size = 0, any = 0;
+  u16 i, count;
+  u8 state;
+
+  /* Every state gets its own transitions followed by the ST_STATE_ANY */
+  /*   ones, leaving out any that would go back into the same state */
+  for (i = 0; i < machine->transitionCount; i++)
+  {
+    if (machine->transitions[i].from == ST_STATE_ANY)
+      any++;
+    else
+      size++;
+  }
+  size += any * machine->stateCount;
+  if (size > 0xFFFF)
+    return 0;
+
+  table = malloc((size ? size : 1) * sizeof(st_statetransition));
+  if (!table)
+    return 0;
+
+  count = 0;
+  for (state = 0; state < machine->stateCount; state++)
+  {
+    machine->first[state] = count;
+    for (i = 0; i < machine->transitionCount; i++)
+    {
+      transition = &machine->transitions[i];
+      if (transition->from == state)
+        table[count++] = *transition;
+    }
+    for (i = 0; i < machine->transitionCount; i++)
+    {
+      transition = &machine->transitions[i];
+      if (transition->from == ST_STATE_ANY && transition->to != state)
+        table[count++] = *transition;
+    }
+  }
+  machine->first[machine->stateCount] = count;
+
+  free(machine->table);
+  machine->table = table;
+  machine->dirty = 0;
+
+  return 1;
+}
+
+/* Adds an entity to a state machine */
+/*   Its parameters start at 0 and its animation is set to the state's */
+/* Takes a pointer to a state machine, a pointer to an entity and a state */
+/* Returns the entity's instance id, or -1 on failure */
+s32 ST_StateMachineAttach(st_statemachine *machine, st_entity *entity,
+  u8 state)
+{
+  u16 i;
+
+  if (!entity || state >= machine->stateCount)
+    return -1;
+
+  for (i = 0; i < machine->instanceCount; i++)
+    if (!machine->entities[i])
+      break;
+
+  if (i == machine->instanceCapacity)
+  {
+    u16 capacity = machine->instanceCapacity ?
+      machine->instanceCapacity * 2 : ST_STATE_INSTANCES_START;
+    st_entity **entities;
+    u8 *states;
+    float *params;
+
+    if (capacity <= machine->instanceCapacity)
+      return -1;
+    entities = realloc(machine->entities, capacity * sizeof(st_entity *));
+    if (!entities)
+      return -1;
+    machine->entities = entities;
+    states = realloc(machine->states, capacity);
+    if (!states)
+      return -1;
+    machine->states = states;
+    params = realloc(machine->params,
+      capacity * (machine->paramCount ? machine->paramCount : 1) *
+      sizeof(float));
+    if (!params)
+      return -1;
+    machine->params = params;
+    machine->instanceCapacity = capacity;
+  }
+  if (i == machine->instanceCount)
+    machine->instanceCount++;
+
+  machine->entities[i] = entity;
+  machine->states[i] = state;
+  memset(&machine->params[i * machine->paramCount], 0,
+    machine->paramCount * sizeof(float));
+  enterState(machine, i);
+
+  return i;
+}
+
+/* Removes an entity from a state machine */
+/*   Its instance id can be handed out again */
+/* Takes a pointer to a state machine and an instance id */
+void ST_StateMachineDetach(st_statemachine *machine, s32 instance)
+{
+  if (instance < 0 || instance >= machine->instanceCount)
+    return;
+
+  machine->entities[instance] = NULL;
+  while (machine->instanceCount &&
+    !machine->entities[machine->instanceCount - 1])
+    machine->instanceCount--;
+}
+
+/* Sets a parameter of an entity */
+/* Takes a pointer to a state machine, instance id, parameter and value */
+void ST_StateMachineSetParam(st_statemachine *machine, s32 instance,
+  u8 param, float value)
+{
+  if (instance < 0 || instance >= machine->instanceCount ||
+    param >= machine->paramCount)
+    return;
+
+  machine->params[instance * machine->paramCount + param] = value;
+}
+
+/* Returns a parameter of an entity */
+/* Takes a pointer to a state machine, instance id and parameter */
+float ST_StateMachineGetParam(st_statemachine *machine, s32 instance,
+  u8 param)
+{
+  if (instance < 0 || instance >= machine->instanceCount ||
+    param >= machine->paramCount)
+    return 0.0f;
+
+  return machine->params[instance * machine->paramCount + param];
+}
+
+/* Moves an entity to a state without a transition */
+/*   The state's animation starts over */
+/* Takes a pointer to a state machine, instance id and state */
+void ST_StateMachineSetState(st_statemachine *machine, s32 instance,
+  u8 state)
+{
+  if (instance < 0 || instance >= machine->instanceCount ||
+    !machine->entities[instance] || state >= machine->stateCount)
+    return;
+
+  machine->states[instance] = state;
+  enterState(machine, instance);
+}
+
+/* Returns the state of an entity */
+/* Takes a pointer to a state machine and instance id */
+u8 ST_StateMachineGetState(st_statemachine *machine, s32 instance)
+{
+  if (instance < 0 || instance >= machine->instanceCount)
+    return 0;
+
+  return machine->states[instance];
+}
+
+/* Takes at most one transition for every entity of a state machine */
+/*   Entities that change state start their new state's animation over */
+/*   Call once per update, before rendering */
+/* Takes a pointer to a state machine */
+void ST_StateMachineUpdate(st_statemachine *machine)
+{
+  const st_statetransition *transition, *end;
+  const float *params;
+  float param;
+  u16 i;
+  u8 met;
+
+  if (machine->dirty && !ST_StateMachineCompile(machine))
+    return;
+
+  for (i = 0; i < machine->instanceCount; i++)
+  {
+    if (!machine->entities[i])
+      continue;
+
+    params = &machine->params[i * machine->paramCount];
+    transition = &machine->table[machine->first[machine->states[i]]];
+    end = &machine->table[machine->first[machine->states[i] + 1]];
+    for (; transition < end; transition++)
+    {
+      param = transition->condition == ST_STATE_LOOP_END ?
+        0.0f : params[transition->param];
+      switch (transition->condition)
+      {
+        case ST_STATE_EQUAL:
+          met = param == transition->value;
+          break;
+        case ST_STATE_NOT_EQUAL:
+          met = param != transition->value;
+          break;
+        case ST_STATE_LESS:
+          met = param < transition->value;
+          break;
+        case ST_STATE_LESS_EQUAL:
+          met = param <= transition->value;
+          break;
+        case ST_STATE_GREATER:
+          met = param > transition->value;
+          break;
+        case ST_STATE_GREATER_EQUAL:
+          met = param >= transition->value;
+          break;
+        default:
+          met = loopEnded(machine->entities[i]);
+          break;
+      }
+      if (met)
+      {
+        machine->states[i] = transition->to;
+        enterState(machine, i);
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,419 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <math.h>
+#include "spritetools/spritetools_tween.h"
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+/* Easing curves sampled at ST_TWEEN_LUT_SIZE + 1 points from 0 to 1 */
+static float st_easeTables[ST_EASE_COUNT][ST_TWEEN_LUT_SIZE + 1];
+static u8 st_easeTablesBuilt = 0;
+
+/* Returns an easing curve at a point, worked out the slow way */
+static double easeExact(u8 ease, double t)
+{
+  double u;
+
+  switch (ease)
+  {
+    case ST_EASE_QUAD_IN:
+      return t * t;
+    case ST_EASE_QUAD_OUT:
+      return t * (2.0 - t);
+    case ST_EASE_QUAD_IN_OUT:
+      return t < 0.5 ? 2.0 * t * t : -1.0 + (4.0 - 2.0 * t) * t;
+    case ST_EASE_CUBIC_IN:
+      return t * t * t;
+    case ST_EASE_CUBIC_OUT:
+      u = t - 1.0;
+      return u * u * u + 1.0;
+    case ST_EASE_CUBIC_IN_OUT:
+      u = 2.0 * t - 2.0;
+      return t < 0.5 ? 4.0 * t * t * t : 0.5 * u * u * u + 1.0;
+    case ST_EASE_SINE_IN:
+      return 1.0 - cos(t * PI / 2.0);
+    case ST_EASE_SINE_OUT:
+      return sin(t * PI / 2.0);
+    case ST_EASE_SINE_IN_OUT:
+      return (1.0 - cos(t * PI)) / 2.0;
+    case ST_EASE_BACK_OUT:
+      u = t - 1.0;
+      return 1.0 + 2.70158 * u * u * u + 1.70158 * u * u;
+    case ST_EASE_BOUNCE_OUT:
+      if (t < 1.0 / 2.75)
+        return 7.5625 * t * t;
+      if (t < 2.0 / 2.75)
+      {
+        t -= 1.5 / 2.75;
+        return 7.5625 * t * t + 0.75;
+      }
+      if (t < 2.5 / 2.75)
+      {
+        t -= 2.25 / 2.75;
+        return 7.5625 * t * t + 0.9375;
+      }
+      t -= 2.625 / 2.75;
+      return 7.5625 * t * t + 0.984375;
+    default:
+      return t;
+  }
+}
+
+/* Fills the easing tables the first time they're needed */
+static void buildTables(void)
+{
+  u32 i;
+  u8 ease;
+
+  if (st_easeTablesBuilt)
+    return;
+
+  for (ease = 0; ease < ST_EASE_COUNT; ease++)
+    for (i = 0; i <= ST_TWEEN_LUT_SIZE; i++)
+      st_easeTables[ease][i] = easeExact(ease, (double)i / ST_TWEEN_LUT_SIZE);
+  st_easeTablesBuilt = 1;
+}
+
+/* Returns an easing curve at a point from its table */
+static float easeLookup(u8 ease, float t)
+{
+  const float *table = st_easeTables[ease];
+  float f;
+  u32 i;
+
+  if (t <= 0.0f)
+    return table[0];
+  f = t * ST_TWEEN_LUT_SIZE;
+  i = (u32)f;
+  if (i >= ST_TWEEN_LUT_SIZE)
+    return table[ST_TWEEN_LUT_SIZE];
+  f -= i;
+  return table[i] + (table[i + 1] - table[i]) * f;
+}
+
+/* Returns a color value rounded and kept between 0 and 255 */
+static u8 colorValue(float value)
+{
+  if (value <= 0.0f)
+    return 0;
+  if (value >= 255.0f)
+    return 255;
+  return (u8)(value + 0.5f);
+}
+
+/* Sets a value of an entity */
+static void setProperty(st_entity *entity, u8 property, float value)
+{
+  switch (property)
+  {
+    case ST_TWEEN_X:
+      entity->xpos = value;
+      break;
+    case ST_TWEEN_Y:
+      entity->ypos = value;
+      break;
+    case ST_TWEEN_SCALE:
+      entity->scale = value;
+      break;
+    case ST_TWEEN_ROTATION:
+      entity->rotation = value;
+      break;
+    case ST_TWEEN_RED:
+      entity->red = colorValue(value);
+      break;
+    case ST_TWEEN_GREEN:
+      entity->green = colorValue(value);
+      break;
+    case ST_TWEEN_BLUE:
+      entity->blue = colorValue(value);
+      break;
+    case ST_TWEEN_ALPHA:
+      entity->alpha = colorValue(value);
+      break;
+  }
+}
+
+/* Returns a value of an entity */
+static float getProperty(st_entity *entity, u8 property)
+{
+  switch (property)
+  {
+    case ST_TWEEN_X:
+      return entity->xpos;
+    case ST_TWEEN_Y:
+      return entity->ypos;
+    case ST_TWEEN_SCALE:
+      return entity->scale;
+    case ST_TWEEN_ROTATION:
+      return entity->rotation;
+    case ST_TWEEN_RED:
+      return entity->red;
+    case ST_TWEEN_GREEN:
+      return entity->green;
+    case ST_TWEEN_BLUE:
+      return entity->blue;
+    default:
+      return entity->alpha;
+  }
+}
+
+/* Returns the index of the tween on a value of an entity, or -1 */
+static s32 findTween(st_tweener *tweener, st_entity *entity, u8 property)
+{
+  u32 i;
+
+  for (i = 0; i < tweener->count; i++)
+    if (tweener->entities[i] == entity && tweener->properties[i] == property)
+      return i;
+  return -1;
+}
+
+/* Moves the last tween into the place of a removed one */
+static void removeTween(st_tweener *tweener, u32 i)
+{
+  u32 last = --tweener->count;
+
+  tweener->entities[i] = tweener->entities[last];
+  tweener->properties[i] = tweener->properties[last];
+  tweener->eases[i] = tweener->eases[last];
+  tweener->repeats[i] = tweener->repeats[last];
+  tweener->starts[i] = tweener->starts[last];
+  tweener->deltas[i] = tweener->deltas[last];
+  tweener->elapsed[i] = tweener->elapsed[last];
+  tweener->rates[i] = tweener->rates[last];
+}
+
+/* Resizes every array of a set of tweens */
+/* Returns 1 on success and 0 on failure */
+static u8 resizeTweens(st_tweener *tweener, u32 capacity)
+{
+  void *p;
+
+#define ST_TWEEN_RESIZE(array) \
+  p = realloc(tweener->array, capacity * sizeof(*tweener->array)); \
+  if (!p) \
+    return 0; \
+  tweener->array = p;
+
+  ST_TWEEN_RESIZE(entities);
+  ST_TWEEN_RESIZE(properties);
+  ST_TWEEN_RESIZE(eases);
+  ST_TWEEN_RESIZE(repeats);
+  ST_TWEEN_RESIZE(starts);
+  ST_TWEEN_RESIZE(deltas);
+  ST_TWEEN_RESIZE(elapsed);
+  ST_TWEEN_RESIZE(rates);
+
+#undef ST_TWEEN_RESIZE
+
+  tweener->capacity = capacity;
+  return 1;
+}
+
+/***************************\
+|*     Tween Functions     *|
+\***************************/
+/* Returns a pointer to a set of tweens */
+/*   Returns NULL if failed */
+/* Takes the number of tweens to make room for (more are added as needed) */
+st_tweener *ST_TweenCreate(u32 capacity)
+{
+  st_tweener *tweener = calloc(1, sizeof(st_tweener));
+  if (!tweener)
+    return NULL;
+
+  buildTables();
+  if (!resizeTweens(tweener, capacity ? capacity : 16))
+  {
+    ST_TweenFree(tweener);
+    return NULL;
+  }
+
+  return tweener;
+}
+
+/* Frees a set of tweens from memory */
+/*   The entities are not freed */
+/* Takes a pointer to a set of tweens */
+void ST_TweenFree(st_tweener *tweener)
+{
+  if (!tweener)
+    return;
+
+  free(tweener->entities);
+  free(tweener->properties);
+  free(tweener->eases);
+  free(tweener->repeats);
+  free(tweener->starts);
+  free(tweener->deltas);
+  free(tweener->elapsed);
+  free(tweener->rates);
+  free(tweener);
+}
+
+/* Starts tweening a value of an entity */
+/*   Replaces any tween already running on the same value */
+/* Takes a pointer to a set of tweens, a pointer to an entity, the value */
+/*   to change, its start and end, duration in ms, easing and repeat mode */
+/* Returns 1 on success and 0 on failure */
+u8 ST_TweenStart(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property, float start, float end, float duration,
+  st_tweenease ease, st_tweenrepeat repeat)
+{
+  s32 i;
+
+  if (!entity || property > ST_TWEEN_ALPHA || ease >= ST_EASE_COUNT)
+    return 0;
+
+  i = findTween(tweener, entity, property);
+
+  /* Nothing to play, so just jump to the end */
+  if (duration <= 0.0f)
+  {
+    if (i >= 0)
+      removeTween(tweener, i);
+    setProperty(entity, property, end);
+    return 1;
+  }
+
+  if (i < 0)
+  {
+    if (tweener->count >= tweener->capacity &&
+      !resizeTweens(tweener, tweener->capacity * 2))
+      return 0;
+    i = tweener->count++;
+  }
+
+  tweener->entities[i] = entity;
+  tweener->properties[i] = property;
+  tweener->eases[i] = ease;
+  tweener->repeats[i] = repeat;
+  tweener->starts[i] = start;
+  tweener->deltas[i] = end - start;
+  tweener->elapsed[i] = 0.0f;
+  tweener->rates[i] = 1.0f / duration;
+  setProperty(entity, property, start);
+
+  return 1;
+}
+
+/* Starts tweening a value of an entity from where it is now */
+/* Takes a pointer to a set of tweens, a pointer to an entity, the value */
+/*   to change, its end, duration in ms, easing and repeat mode */
+/* Returns 1 on success and 0 on failure */
+u8 ST_TweenTo(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property, float end, float duration,
+  st_tweenease ease, st_tweenrepeat repeat)
+{
+  if (!entity)
+    return 0;
+
+  return ST_TweenStart(tweener, entity, property,
+    getProperty(entity, property), end, duration, ease, repeat);
+}
+
+/* Stops the tween on a value of an entity, leaving the value as it is */
+/* Takes a pointer to a set of tweens, a pointer to an entity and a value */
+/* Returns 1 if a tween was stopped and 0 if there wasn't one */
+u8 ST_TweenStop(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property)
+{
+  s32 i = findTween(tweener, entity, property);
+
+  if (i < 0)
+    return 0;
+
+  removeTween(tweener, i);
+  return 1;
+}
+
+/* Stops every tween on an entity */
+/*   Call this before freeing an entity that's being tweened */
+/* Takes a pointer to a set of tweens and a pointer to an entity */
+void ST_TweenStopEntity(st_tweener *tweener, st_entity *entity)
+{
+  u32 i = 0;
+
+  while (i < tweener->count)
+  {
+    if (tweener->entities[i] == entity)
+      removeTween(tweener, i);
+    else
+      i++;
+  }
+}
+
+/* Returns 1 if a value of an entity is being tweened and 0 if not */
+/* Takes a pointer to a set of tweens, a pointer to an entity and a value */
+u8 ST_TweenActive(st_tweener *tweener, st_entity *entity,
+  st_tweenproperty property)
+{
+  return findTween(tweener, entity, property) >= 0;
+}
+
+/* Advances every tween and writes the results to the entities */
+/*   Tweens that reach their end are set to it and removed */
+/* Takes a pointer to a set of tweens and the time that passed in ms */
+void ST_TweenUpdate(st_tweener *tweener, double ms)
+{
+  float t, step = ms;
+  u32 i = 0;
+  u8 done;
+
+  while (i < tweener->count)
+  {
+    tweener->elapsed[i] += step;
+    t = tweener->elapsed[i] * tweener->rates[i];
+    done = 0;
+    if (t >= 1.0f)
+    {
+      switch (tweener->repeats[i])
+      {
+        case ST_TWEEN_LOOP:
+          t -= (u32)t;
+          tweener->elapsed[i] = t / tweener->rates[i];
+          break;
+        case ST_TWEEN_PINGPONG:
+          t = fmodf(t, 2.0f);
+          tweener->elapsed[i] = t / tweener->rates[i];
+          if (t > 1.0f)
+            t = 2.0f - t;
+          break;
+        default:
+          t = 1.0f;
+          done = 1;
+          break;
+      }
+    }
+
+    setProperty(tweener->entities[i], tweener->properties[i],
+      tweener->starts[i] +
+      tweener->deltas[i] * easeLookup(tweener->eases[i], t));
+
+    /* The last tween takes this one's place and is updated next */
+    if (done)
+      removeTween(tweener, i);
+    else
+      i++;
+  }
+}
+
+/* Returns an easing curve at a point */
+/*   Read from the same table the tweens use */
+/* Takes an easing and how far along (0.0 to 1.0) */
+float ST_TweenEase(st_tweenease ease, float t)
+{
+  if (ease >= ST_EASE_COUNT)
+    return t;
+
+  buildTables();
+  return easeLookup(ease, t);
+}
@@ -0,0 +1,222 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+#include <3ds.h>
+#include <stdlib.h>
+#include <math.h>
+#include "spritetools/spritetools_viewport.h"
+#include "spritetools/spritetools_governor.h"
+
+/* Camera values worked out once per viewport for a culling pass */
+typedef struct {
+  float c, s; /* Cosine and sine of the camera's rotation */
+  float zoom;
+  float camx, camy;
+  float xcenter, ycenter;
+  float left, top, right, bottom; /* Visible area including the margin */
+} st_viewportpass;
+
+/* Returns the radius around an entity's position that its sprite covers */
+static float entityRadius(st_entity *entity)
+{
+  st_animation *anim;
+  st_frame *frame;
+  float w, h, off;
+
+  if (!entity->animationCount)
+    return 0.0f;
+  anim = entity->animations[entity->currentAnim];
+  if (!anim || !anim->length)
+    return 0.0f;
+  frame = anim->frames[anim->currentFrame < anim->length ?
+    anim->currentFrame : 0];
+  if (!frame)
+    return 0.0f;
+
+  /* Half the diagonal covers any rotation, plus the hotspot offset */
+  w = frame->drawWidth;
+  h = frame->drawHeight;
+  off = abs(frame->xoff) + abs(frame->yoff) +
+    abs(frame->trimX) + abs(frame->trimY);
+  return (sqrt(w * w + h * h) / 2.0f + off) * entity->scale;
+}
+
+/* Adds an entity to a viewport's draw list */
+static u8 pushDraw(st_viewport *viewport, st_entity *entity,
+  float x, float y, float distance)
+{
+  st_viewportdraw *draws;
+  u32 capacity;
+
+  if (viewport->drawCount >= viewport->drawCapacity)
+  {
+    capacity = viewport->drawCapacity ? viewport->drawCapacity * 2 : 64;
+    draws = realloc(viewport->draws, capacity * sizeof(st_viewportdraw));
+    if (!draws)
+      return 0;
+    viewport->draws = draws;
+    viewport->drawCapacity = capacity;
+  }
+
+  viewport->draws[viewport->drawCount].entity = entity;
+  viewport->draws[viewport->drawCount].x = x;
+  viewport->draws[viewport->drawCount].y = y;
+  viewport->draws[viewport->drawCount].distance = distance;
+  viewport->drawCount++;
+
+  return 1;
+}
+
+/******************************\
+|*     Viewport Functions     *|
+\******************************/
+/* Returns a pointer to a viewport */
+/*   Returns NULL if failed */
+/* Takes the screen, the rectangle on it, and the camera to view through */
+st_viewport *ST_ViewportCreate(gfxScreen_t screen, s16 x, s16 y,
+  u16 width, u16 height, st_camera *cam)
+{
+  st_viewport *tempview = calloc(sizeof(st_viewport), 1);
+  if (!tempview)
+    return NULL;
+
+  tempview->screen = screen;
+  tempview->x = x;
+  tempview->y = y;
+  tempview->width = width;
+  tempview->height = height;
+  tempview->camera = cam;
+  tempview->scissor = 1;
+  tempview->rotateSprites = 1;
+
+  return tempview;
+}
+
+/* Frees a viewport from memory */
+/* Takes a pointer to a viewport */
+void ST_ViewportFree(st_viewport *viewport)
+{
+  if (!viewport)
+    return;
+  free(viewport->draws);
+  free(viewport);
+}
+
+/* Moves and resizes a viewport */
+/* Takes a pointer to a viewport and the new rectangle */
+void ST_ViewportSetRect(st_viewport *viewport, s16 x, s16 y,
+  u16 width, u16 height)
+{
+  viewport->x = x;
+  viewport->y = y;
+  viewport->width = width;
+  viewport->height = height;
+}
+
+/* Sets the camera of a viewport */
+/* Takes a pointer to a viewport and a pointer to a camera */
+void ST_ViewportSetCamera(st_viewport *viewport, st_camera *cam)
+{
+  viewport->camera = cam;
+}
+
+/* Turns clipping to the viewport's rectangle on (1) or off (0) */
+/* Takes a pointer to a viewport and the state to set */
+void ST_ViewportSetScissor(st_viewport *viewport, u8 state)
+{
+  viewport->scissor = state;
+}
+
+/* Turns rotating sprites with the camera on (1) or off (0) */
+/* Takes a pointer to a viewport and the state to set */
+void ST_ViewportSetRotateSprites(st_viewport *viewport, u8 state)
+{
+  viewport->rotateSprites = state;
+}
+
+/* Builds the draw lists of several viewports in one pass over entities */
+/*   Also steps every entity's animation once, seen or not */
+/* Takes a list of viewports, number of viewports, a list of entities, */
+/*   and number of entities */
+/* Returns 1 on success and 0 on failure */
+u8 ST_ViewportCull(st_viewport **viewports, u8 viewportCount,
+  st_entity **entities, u32 entityCount)
+{
+  st_viewportpass *passes;
+  st_viewportpass *pass;
+  st_entity *entity;
+  float margin = ST_GovernorCullMargin(ST_VIEWPORT_CULL_MARGIN);
+  float radius, dx, dy, px, py, distance, nearest;
+  u32 i;
+  u8 v;
+  u8 ret = 1;
+
+  if (!viewportCount)
+    return 1;
+
+  passes = calloc(viewportCount, sizeof(st_viewportpass));
+  if (!passes)
+    return 0;
+
+  for (v = 0; v < viewportCount; v++)
+  {
+    pass = &passes[v];
+    viewports[v]->drawCount = 0;
+    if (!viewports[v]->camera)
+      continue;
+    pass->c = cos(viewports[v]->camera->rotation);
+    pass->s = sin(viewports[v]->camera->rotation);
+    pass->zoom = viewports[v]->camera->zoom;
+    pass->camx = viewports[v]->camera->x;
+    pass->camy = viewports[v]->camera->y;
+    pass->xcenter = viewports[v]->x + viewports[v]->width / 2.0f;
+    pass->ycenter = viewports[v]->y + viewports[v]->height / 2.0f;
+    pass->left = viewports[v]->x - margin;
+    pass->top = viewports[v]->y - margin;
+    pass->right = viewports[v]->x + viewports[v]->width + margin;
+    pass->bottom = viewports[v]->y + viewports[v]->height + margin;
+  }
+
+  for (i = 0; i < entityCount; i++)
+  {
+    entity = entities[i];
+    if (!entity || !entity->animationCount)
+      continue;
+    radius = entityRadius(entity);
+    nearest = -1.0f;
+
+    for (v = 0; v < viewportCount; v++)
+    {
+      if (!viewports[v]->camera)
+        continue;
+      pass = &passes[v];
+      dx = entity->xpos - pass->camx;
+      dy = entity->ypos - pass->camy;
+      distance = sqrt(dx * dx + dy * dy);
+      if (nearest < 0.0f || distance < nearest)
+        nearest = distance;
+      px = (dx * pass->c - dy * pass->s) * pass->zoom + pass->xcenter;
+      py = (dx * pass->s + dy * pass->c) * pass->zoom + pass->ycenter;
+
+      if (px + radius * pass->zoom < pass->left ||
+        px - radius * pass->zoom > pass->right ||
+        py + radius * pass->zoom < pass->top ||
+        py - radius * pass->zoom > pass->bottom)
+        continue;
+
+      if (!pushDraw(viewports[v], entity, px, py, distance))
+        ret = 0;
+    }
+
+    /* Stepped here, once for every entity, so ones seen by several */
+    /*   viewports don't play faster and ones seen by none don't stop */
+    ST_GovernorStepAnimation(entity->animations[entity->currentAnim],
+      nearest < 0.0f ? 0.0 : nearest);
+  }
+
+  free(passes);
+  return ret;
+}
@@ -0,0 +1,850 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+/* Turns TexturePacker and Aseprite JSON exports into an animation file */
+/*   ST_AnimFileLoad can read */
+/* Usage: stanimimport [-f fpf] output.stanim [set=]export.json ... */
+/*   Each export becomes a set named after the file unless a name is given, */
+/*   its image becomes a spritesheet named as in the export's meta.image, */
+/*   and frames with the same rectangle, trim and pivot are stored once. */
+/*   Aseprite tags become animations, played forward, in reverse or ping */
+/*   ponged. Without tags, frames are grouped by name with the trailing */
+/*   number cut off, so walk_01.png and walk_02.png make the animation walk. */
+/*   Frame durations are turned into frames at 60 per second, and frames */
+/*   held longer than the shortest one in an animation are repeated. -f */
+/*   sets how many frames each one lasts when the export has no durations. */
+/*   Timing matches ST_RenderAnimationPlayAdvanced, ST_AnimationStep and */
+/*   entities drawn through a camera or viewport, which show each frame */
+/*   for fpf + 1 frames, so fpf is stored one less than the frames wanted. */
+/*   ST_RenderAnimationPlay, and ST_RenderEntity on an entity that isn't */
+/*   scaled, rotated or tinted, show each frame for fpf frames instead */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <spritetools/spritetools_animfile.h>
+
+/* Deepest nesting of arrays and objects allowed in an export */
+#define JSON_MAX_DEPTH 64
+
+enum {
+  JSON_NULL,
+  JSON_BOOL,
+  JSON_NUMBER,
+  JSON_STRING,
+  JSON_ARRAY,
+  JSON_OBJECT
+};
+
+/* Value parsed from JSON */
+/*   Objects keep their keys in the order they were written */
+typedef struct st_json {
+  u8 type;
+  double number; /* Also 0 or 1 for bools */
+  char *string;
+  struct st_json *items;
+  char **keys;
+  u32 count;
+} st_json;
+
+/* Frame of an export, in the order the export lists them */
+typedef struct {
+  const char *name;
+  u32 frame; /* Index of the stored frame */
+  u32 fpf;
+} st_importframe;
+
+/* Group of frames sharing a name, for exports without tags */
+typedef struct {
+  char *name;
+  u32 *frames; /* Indices into the export's frames */
+  u32 *numbers; /* Trailing number of each frame's name */
+  u32 count;
+  u32 capacity;
+} st_importgroup;
+
+/* Everything going into the animation file */
+static char *strings;
+static u32 stringsSize, stringsCapacity;
+static st_animfilesheet *sheets;
+static u32 sheetCount, sheetCapacity;
+static st_animfileframe *frames;
+static u32 frameCount, frameCapacity;
+static st_animfileanimation *animations;
+static u32 animationCount, animationCapacity;
+static st_animfileset *sets;
+static u32 setCount, setCapacity;
+static u32 *indices;
+static u32 indexCount, indexCapacity;
+
+/* Frames each frame of an export lasts without durations */
+static u32 defaultFpf = 6;
+
+/* Resizes an array, giving up if there's no memory for it */
+static void *resize(void *array, size_t size)
+{
+  array = realloc(array, size);
+  if (!array)
+  {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
+  return array;
+}
+
+/* Makes room for one more item in an array, doubling it when full */
+static void *grow(void *array, u32 *capacity, u32 count, size_t size)
+{
+  if (count < *capacity)
+    return array;
+
+  *capacity = *capacity ? *capacity * 2 : 16;
+  return resize(array, *capacity * size);
+}
+
+/* Returns a copy of part of a string */
+static char *copyString(const char *s, size_t length)
+{
+  char *copy = resize(NULL, length + 1);
+
+  memcpy(copy, s, length);
+  copy[length] = 0;
+  return copy;
+}
+
+/**********************\
+|*     JSON Input     *|
+\**********************/
+static const char *skipSpace(const char *p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+    p++;
+  return p;
+}
+
+/* Returns the value of n hex digits, or -1 if they aren't all hex */
+static long hexValue(const char *p, int n)
+{
+  long value = 0;
+  int i;
+
+  for (i = 0; i < n; i++)
+  {
+    value <<= 4;
+    if (p[i] >= '0' && p[i] <= '9')
+      value |= p[i] - '0';
+    else if (p[i] >= 'a' && p[i] <= 'f')
+      value |= p[i] - 'a' + 10;
+    else if (p[i] >= 'A' && p[i] <= 'F')
+      value |= p[i] - 'A' + 10;
+    else
+      return -1;
+  }
+  return value;
+}
+
+/* Parses a string starting at its opening quote */
+/* Returns the text after it, or NULL if it isn't valid */
+static const char *parseString(const char *p, char **out)
+{
+  const char *end = ++p;
+  char *s;
+  long c, low;
+  u32 length = 0;
+
+  /* Escapes never get longer once decoded, so the raw length is enough */
+  while (*end && *end != '"')
+    end += *end == '\\' && end[1] ? 2 : 1;
+  if (!*end)
+    return NULL;
+  s = copyString(p, end - p);
+
+  while (p < end)
+  {
+    if (*p != '\\')
+    {
+      s[length++] = *p++;
+      continue;
+    }
+    p++;
+    switch (*p++)
+    {
+      case '"': s[length++] = '"'; break;
+      case '\\': s[length++] = '\\'; break;
+      case '/': s[length++] = '/'; break;
+      case 'b': s[length++] = '\b'; break;
+      case 'f': s[length++] = '\f'; break;
+      case 'n': s[length++] = '\n'; break;
+      case 'r': s[length++] = '\r'; break;
+      case 't': s[length++] = '\t'; break;
+      case 'u':
+        if (end - p < 4 || (c = hexValue(p, 4)) < 0)
+        {
+          free(s);
+          return NULL;
+        }
+        p += 4;
+        if (c >= 0xD800 && c < 0xDC00 && end - p >= 6 && p[0] == '\\' &&
+          p[1] == 'u' && (low = hexValue(p + 2, 4)) >= 0xDC00 &&
+          low < 0xE000)
+        {
+          c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+          p += 6;
+        }
+        /* Written as UTF-8, which is never longer than the escape */
+        if (c < 0x80)
+          s[length++] = c;
+        else if (c < 0x800)
+        {
+          s[length++] = 0xC0 | (c >> 6);
+          s[length++] = 0x80 | (c & 0x3F);
+        }
+        else if (c < 0x10000)
+        {
+          s[length++] = 0xE0 | (c >> 12);
+          s[length++] = 0x80 | ((c >> 6) & 0x3F);
+          s[length++] = 0x80 | (c & 0x3F);
+        }
+        else
+        {
+          s[length++] = 0xF0 | (c >> 18);
+          s[length++] = 0x80 | ((c >> 12) & 0x3F);
+          s[length++] = 0x80 | ((c >> 6) & 0x3F);
+          s[length++] = 0x80 | (c & 0x3F);
+        }
+        break;
+      default:
+        free(s);
+        return NULL;
+    }
+  }
+  s[length] = 0;
+  *out = s;
+
+  return end + 1;
+}
+
+/* Parses any value */
+/* Returns the text after it, or NULL if it isn't valid */
+static const char *parseValue(const char *p, st_json *value, int depth)
+{
+  u32 capacity = 0, keyCapacity = 0;
+  char *end;
+
+  memset(value, 0, sizeof(st_json));
+  p = skipSpace(p);
+  if (depth > JSON_MAX_DEPTH)
+    return NULL;
+
+  if (*p == '"')
+  {
+    value->type = JSON_STRING;
+    return parseString(p, &value->string);
+  }
+  if (*p == '[' || *p == '{')
+  {
+    value->type = *p == '[' ? JSON_ARRAY : JSON_OBJECT;
+    p = skipSpace(p + 1);
+    if (*p == (value->type == JSON_ARRAY ? ']' : '}'))
+      return p + 1;
+    while (1)
+    {
+      value->items = grow(value->items, &capacity, value->count,
+        sizeof(st_json));
+      if (value->type == JSON_OBJECT)
+      {
+        value->keys = grow(value->keys, &keyCapacity, value->count,
+          sizeof(char *));
+        p = skipSpace(p);
+        if (*p != '"' || !(p = parseString(p, &value->keys[value->count])))
+          return NULL;
+        p = skipSpace(p);
+        if (*p++ != ':')
+          return NULL;
+      }
+      p = parseValue(p, &value->items[value->count++], depth + 1);
+      if (!p)
+        return NULL;
+      p = skipSpace(p);
+      if (*p == ',')
+      {
+        p++;
+        continue;
+      }
+      if (*p++ != (value->type == JSON_ARRAY ? ']' : '}'))
+        return NULL;
+      return p;
+    }
+  }
+  if (!strncmp(p, "true", 4) || !strncmp(p, "false", 5))
+  {
+    value->type = JSON_BOOL;
+    value->number = *p == 't';
+    return p + (*p == 't' ? 4 : 5);
+  }
+  if (!strncmp(p, "null", 4))
+    return p + 4;
+
+  value->type = JSON_NUMBER;
+  value->number = strtod(p, &end);
+  return end == p ? NULL : end;
+}
+
+static void freeJson(st_json *value)
+{
+  u32 i;
+
+  for (i = 0; i < value->count; i++)
+  {
+    freeJson(&value->items[i]);
+    if (value->keys)
+      free(value->keys[i]);
+  }
+  free(value->items);
+  free(value->keys);
+  free(value->string);
+}
+
+/* Returns the value of a key in an object, or NULL if it isn't there */
+static const st_json *jsonGet(const st_json *object, const char *key)
+{
+  u32 i;
+
+  if (!object || object->type != JSON_OBJECT)
+    return NULL;
+  for (i = 0; i < object->count; i++)
+    if (!strcmp(object->keys[i], key))
+      return &object->items[i];
+  return NULL;
+}
+
+/* Returns the number under a key in an object, or fallback */
+static double jsonNumber(const st_json *object, const char *key,
+  double fallback)
+{
+  const st_json *value = jsonGet(object, key);
+  return value && value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+/* Returns the string under a key in an object, or NULL */
+static const char *jsonString(const st_json *object, const char *key)
+{
+  const st_json *value = jsonGet(object, key);
+  return value && value->type == JSON_STRING ? value->string : NULL;
+}
+
+/* Reads and parses a whole file */
+static int readJson(const char *path, st_json *json)
+{
+  FILE *in = fopen(path, "rb");
+  const char *end;
+  char *text;
+  long size;
+
+  if (!in)
+    return 0;
+  fseek(in, 0, SEEK_END);
+  size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  text = size < 0 ? NULL : malloc(size + 1);
+  if (!text || fread(text, 1, size, in) != (size_t)size)
+  {
+    fclose(in);
+    free(text);
+    return 0;
+  }
+  fclose(in);
+  text[size] = 0;
+
+  end = parseValue(text, json, 0);
+  free(text);
+  return end && !*skipSpace(end);
+}
+
+/*************************\
+|*     File Contents     *|
+\*************************/
+/* Returns the offset of a string, adding it if it isn't already there */
+static u32 addString(const char *s)
+{
+  u32 length = strlen(s) + 1, offset = 0;
+
+  while (offset < stringsSize)
+  {
+    if (!strcmp(strings + offset, s))
+      return offset;
+    offset += strlen(strings + offset) + 1;
+  }
+
+  while (stringsSize + length > stringsCapacity)
+    strings = grow(strings, &stringsCapacity, stringsCapacity, 1);
+  memcpy(strings + stringsSize, s, length);
+  stringsSize += length;
+
+  return offset;
+}
+
+/* Returns the index of a sheet, adding it if it isn't already there */
+static u32 addSheet(const char *name)
+{
+  u32 offset = addString(name), i;
+
+  for (i = 0; i < sheetCount; i++)
+    if (sheets[i].name == offset)
+      return i;
+  sheets = grow(sheets, &sheetCapacity, sheetCount, sizeof(st_animfilesheet));
+  sheets[sheetCount].name = offset;
+  return sheetCount++;
+}
+
+/* Returns the index of a frame, adding it if it isn't already there */
+static u32 addFrame(const st_animfileframe *frame)
+{
+  u32 i;
+
+  for (i = 0; i < frameCount; i++)
+    if (!memcmp(&frames[i], frame, sizeof(st_animfileframe)))
+      return i;
+  frames = grow(frames, &frameCapacity, frameCount, sizeof(st_animfileframe));
+  frames[frameCount] = *frame;
+  return frameCount++;
+}
+
+static void addIndex(u32 index)
+{
+  indices = grow(indices, &indexCapacity, indexCount, sizeof(u32));
+  indices[indexCount++] = index;
+}
+
+/* Returns n rounded up to an even number, like frames are drawn */
+static s32 evenSize(s32 n)
+{
+  return (n + 1) / 2 * 2;
+}
+
+/* Turns a frame of an export into a stored frame */
+/* Returns 0 if it can't be drawn as exported */
+static int importFrame(const st_json *entry, u32 sheet, const char *name,
+  st_importframe *out)
+{
+  const st_json *rect = jsonGet(entry, "frame");
+  const st_json *trim = jsonGet(entry, "spriteSourceSize");
+  const st_json *source = jsonGet(entry, "sourceSize");
+  const st_json *pivot = jsonGet(entry, "pivot");
+  const st_json *rotated = jsonGet(entry, "rotated");
+  st_animfileframe frame;
+  double duration = jsonNumber(entry, "duration", 0.0);
+  s32 width, height, sourceWidth, sourceHeight, x, y;
+
+  if (!rect)
+  {
+    fprintf(stderr, "Frame %s has no rectangle\n", name);
+    return 0;
+  }
+  if (rotated && rotated->type == JSON_BOOL && rotated->number)
+  {
+    fprintf(stderr, "Frame %s is rotated, which can't be drawn\n", name);
+    return 0;
+  }
+
+  x = jsonNumber(rect, "x", 0.0);
+  y = jsonNumber(rect, "y", 0.0);
+  width = jsonNumber(rect, "w", 0.0);
+  height = jsonNumber(rect, "h", 0.0);
+  sourceWidth = jsonNumber(source, "w", width);
+  sourceHeight = jsonNumber(source, "h", height);
+  if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > 0xFFFF ||
+    y + height > 0xFFFF || sourceWidth > 0xFFFF || sourceHeight > 0xFFFF)
+  {
+    fprintf(stderr, "Frame %s is out of range\n", name);
+    return 0;
+  }
+
+  memset(&frame, 0, sizeof(frame));
+  frame.sheet = sheet;
+  frame.xleft = x;
+  frame.ytop = y;
+  frame.width = width;
+  frame.height = height;
+  frame.sourceWidth = sourceWidth;
+  frame.sourceHeight = sourceHeight;
+
+  /* Frames are drawn around their center, so move it as far as trimming */
+  /*   moved the packed rectangle's center from the source's */
+  frame.trimX = (s32)jsonNumber(trim, "x", 0.0) + evenSize(width) / 2 -
+    evenSize(sourceWidth) / 2;
+  frame.trimY = (s32)jsonNumber(trim, "y", 0.0) + evenSize(height) / 2 -
+    evenSize(sourceHeight) / 2;
+
+  /* The pivot is drawn where the entity is instead of the center */
+  if (pivot)
+  {
+    frame.xoff = (s32)((jsonNumber(pivot, "x", 0.5) - 0.5) * sourceWidth);
+    frame.yoff = (s32)((jsonNumber(pivot, "y", 0.5) - 0.5) * sourceHeight);
+  }
+
+  out->name = name;
+  out->frame = addFrame(&frame);
+  out->fpf = duration > 0.0 ? (u32)(duration * 60.0 / 1000.0 + 0.5) :
+    defaultFpf;
+  if (!out->fpf)
+    out->fpf = 1;
+
+  return 1;
+}
+
+/* Adds an animation playing frames of an export in the order given */
+/* Returns the index of the animation, or -1 if it's too long */
+static s32 addAnimation(const char *name, const st_importframe *list,
+  const u32 *order, u32 count)
+{
+  st_animfileanimation *animation;
+  u32 fpf = 0x7FFF, first = indexCount, length = 0, repeat, i;
+
+  /* Every frame lasts as long as the shortest, so longer ones repeat */
+  for (i = 0; i < count; i++)
+    if (list[order[i]].fpf < fpf)
+      fpf = list[order[i]].fpf;
+  for (i = 0; i < count; i++)
+  {
+    repeat = (list[order[i]].fpf + fpf / 2) / fpf;
+    if (!repeat)
+      repeat = 1;
+    length += repeat;
+    if (length > 0xFFFF)
+    {
+      fprintf(stderr, "Animation %s is too long\n", name);
+      return -1;
+    }
+    while (repeat--)
+      addIndex(list[order[i]].frame);
+  }
+
+  animations = grow(animations, &animationCapacity, animationCount,
+    sizeof(st_animfileanimation));
+  animation = &animations[animationCount];
+  memset(animation, 0, sizeof(st_animfileanimation));
+  animation->name = addString(name);
+  /* ST_RenderAnimationPlayAdvanced and ST_AnimationStep move on once ftn */
+  /*   passes fpf, so each frame shows for fpf + 1 frames. Plain */
+  /*   ST_RenderAnimationPlay moves on once ftn reaches fpf, a frame sooner */
+  animation->fpf = fpf - 1;
+  animation->loopFrame = 0;
+  animation->frames = first;
+  animation->length = length;
+
+  return animationCount++;
+}
+
+/* Adds the animations of tags, like Aseprite's meta.frameTags */
+/* Returns the number of animations added, or -1 on failure */
+static s32 importTags(const st_json *tags, const st_importframe *list,
+  u32 count, u32 *added)
+{
+  const st_json *tag;
+  const char *name, *direction;
+  u32 *order, length, from, to, i, j;
+  s32 animation;
+
+  order = malloc((count * 2 + 1) * sizeof(u32));
+  if (!order)
+    return -1;
+
+  for (i = 0; i < tags->count; i++)
+  {
+    tag = &tags->items[i];
+    name = jsonString(tag, "name");
+    direction = jsonString(tag, "direction");
+    from = jsonNumber(tag, "from", 0.0);
+    to = jsonNumber(tag, "to", 0.0);
+    if (!name || from > to || to >= count)
+    {
+      fprintf(stderr, "Tag %u isn't valid\n", i);
+      free(order);
+      return -1;
+    }
+
+    length = 0;
+    if (direction && (!strcmp(direction, "reverse") ||
+      !strcmp(direction, "pingpong_reverse")))
+    {
+      for (j = to + 1; j-- > from;)
+        order[length++] = j;
+      if (!strcmp(direction, "pingpong_reverse"))
+        for (j = from + 1; j < to; j++)
+          order[length++] = j;
+    }
+    else
+    {
+      for (j = from; j <= to; j++)
+        order[length++] = j;
+      if (direction && !strcmp(direction, "pingpong"))
+        for (j = to; j-- > from + 1;)
+          order[length++] = j;
+    }
+
+    animation = addAnimation(name, list, order, length);
+    if (animation < 0)
+    {
+      free(order);
+      return -1;
+    }
+    added[i] = animation;
+  }
+
+  free(order);
+  return tags->count;
+}
+
+/* Adds an animation for each group of frames named alike */
+/* Returns the number of animations added, or -1 on failure */
+static s32 importGroups(const st_importframe *list, u32 count,
+  const char *fallback, u32 *added)
+{
+  st_importgroup *groups = NULL, *group;
+  u32 groupCount = 0, groupCapacity = 0, number, i, j, k;
+  const char *name, *end, *digits;
+  s32 animation, result;
+
+  for (i = 0; i < count; i++)
+  {
+    /* Cut off the extension, then the number and what separates it */
+    name = list[i].name;
+    end = strrchr(name, '.');
+    if (!end || strchr(end, '/'))
+      end = name + strlen(name);
+    digits = end;
+    while (digits > name && digits[-1] >= '0' && digits[-1] <= '9')
+      digits--;
+    number = 0;
+    for (j = 0; digits + j < end; j++)
+      number = number * 10 + (digits[j] - '0');
+    end = digits;
+    while (end > name && (end[-1] == ' ' || end[-1] == '_' ||
+      end[-1] == '-' || end[-1] == '.'))
+      end--;
+    if (end == name)
+    {
+      name = fallback;
+      end = fallback + strlen(fallback);
+    }
+
+    for (j = 0; j < groupCount; j++)
+      if (strlen(groups[j].name) == (size_t)(end - name) &&
+        !strncmp(groups[j].name, name, end - name))
+        break;
+    if (j == groupCount)
+    {
+      groups = grow(groups, &groupCapacity, groupCount,
+        sizeof(st_importgroup));
+      memset(&groups[groupCount], 0, sizeof(st_importgroup));
+      groups[groupCount++].name = copyString(name, end - name);
+    }
+    group = &groups[j];
+
+    /* Keep the group in number order, leaving equal numbers as listed */
+    if (group->count == group->capacity)
+    {
+      group->numbers = grow(group->numbers, &group->capacity, group->count,
+        sizeof(u32));
+      group->frames = resize(group->frames, group->capacity * sizeof(u32));
+    }
+    k = group->count++;
+    while (k && group->numbers[k - 1] > number)
+    {
+      group->numbers[k] = group->numbers[k - 1];
+      group->frames[k] = group->frames[k - 1];
+      k--;
+    }
+    group->numbers[k] = number;
+    group->frames[k] = i;
+  }
+
+  result = groupCount;
+  for (i = 0; i < groupCount; i++)
+  {
+    if (result >= 0)
+    {
+      animation = addAnimation(groups[i].name, list, groups[i].frames,
+        groups[i].count);
+      if (animation < 0)
+        result = -1;
+      added[i] = animation;
+    }
+    free(groups[i].name);
+    free(groups[i].frames);
+    free(groups[i].numbers);
+  }
+  free(groups);
+
+  return result;
+}
+
+/* Returns the name of a file without its directory or extension */
+static char *baseName(const char *path)
+{
+  const char *start = strrchr(path, '/'), *end;
+
+  start = start ? start + 1 : path;
+  end = strrchr(start, '.');
+  if (!end || end == start)
+    end = start + strlen(start);
+  return copyString(start, end - start);
+}
+
+/* Adds a set with the animations of an export */
+/* Returns 1 on success and 0 on failure */
+static int importExport(const char *setName, const char *path)
+{
+  const st_json *list, *meta, *tags;
+  st_importframe *imported;
+  const char *image;
+  st_json json;
+  u32 *added, count, sheet, i;
+  s32 animationsAdded;
+  int result = 0;
+
+  if (!readJson(path, &json))
+  {
+    fprintf(stderr, "Couldn't read %s as JSON\n", path);
+    return 0;
+  }
+
+  list = jsonGet(&json, "frames");
+  meta = jsonGet(&json, "meta");
+  image = jsonString(meta, "image");
+  if (!list || (list->type != JSON_ARRAY && list->type != JSON_OBJECT) ||
+    !list->count || !image)
+  {
+    fprintf(stderr, "%s isn't a TexturePacker or Aseprite export\n", path);
+    freeJson(&json);
+    return 0;
+  }
+
+  /* Frames are either an object keyed by name or an array with names */
+  sheet = addSheet(image);
+  count = list->count;
+  tags = jsonGet(meta, "frameTags");
+  if (tags && (tags->type != JSON_ARRAY || !tags->count))
+    tags = NULL;
+  imported = malloc(count * sizeof(st_importframe));
+  added = malloc((tags && tags->count > count ? tags->count : count) *
+    sizeof(u32));
+  if (!imported || !added)
+    goto done;
+  for (i = 0; i < count; i++)
+  {
+    const char *name = list->type == JSON_OBJECT ? list->keys[i] :
+      jsonString(&list->items[i], "filename");
+    if (!name || !importFrame(&list->items[i], sheet, name, &imported[i]))
+    {
+      if (!name)
+        fprintf(stderr, "Frame %u of %s has no name\n", i, path);
+      goto done;
+    }
+  }
+
+  animationsAdded = tags ? importTags(tags, imported, count, added) :
+    importGroups(imported, count, setName, added);
+  if (animationsAdded < 0)
+    goto done;
+  if (animationsAdded > 0xFF)
+  {
+    fprintf(stderr, "%s has more animations than an entity can hold\n", path);
+    goto done;
+  }
+
+  sets = grow(sets, &setCapacity, setCount, sizeof(st_animfileset));
+  sets[setCount].name = addString(setName);
+  sets[setCount].animations = indexCount;
+  sets[setCount].count = animationsAdded;
+  for (i = 0; i < (u32)animationsAdded; i++)
+    addIndex(added[i]);
+  setCount++;
+  result = 1;
+
+done:
+  free(imported);
+  free(added);
+  freeJson(&json);
+  return result;
+}
+
+int main(int argc, char **argv)
+{
+  st_animfileheader header;
+  char *name, *eq;
+  const char *path;
+  int first = 1, i;
+  u32 j;
+  FILE *out;
+
+  if (argc > 2 && !strcmp(argv[1], "-f"))
+  {
+    defaultFpf = strtoul(argv[2], NULL, 10);
+    first = 3;
+  }
+  if (argc - first < 2 || !defaultFpf || defaultFpf > 0x7FFF)
+  {
+    fprintf(stderr, "Usage: %s [-f fpf] output.stanim [set=]export.json ...\n",
+      argv[0]);
+    return 1;
+  }
+
+  for (i = first + 1; i < argc; i++)
+  {
+    eq = strchr(argv[i], '=');
+    path = eq ? eq + 1 : argv[i];
+    name = eq ? copyString(argv[i], eq - argv[i]) : baseName(path);
+    for (j = 0; j < setCount; j++)
+    {
+      if (!strcmp(strings + sets[j].name, name))
+      {
+        fprintf(stderr, "%s is in the file twice\n", name);
+        return 1;
+      }
+    }
+    if (!importExport(name, path))
+      return 1;
+    free(name);
+  }
+
+  memset(&header, 0, sizeof(header));
+  header.magic = ST_ANIMFILE_MAGIC;
+  header.version = ST_ANIMFILE_VERSION;
+  header.sheetCount = sheetCount;
+  header.frameCount = frameCount;
+  header.animationCount = animationCount;
+  header.eventCount = 0;
+  header.setCount = setCount;
+  header.indexCount = indexCount;
+  header.stringsSize = stringsSize;
+
+  out = fopen(argv[first], "wb");
+  if (!out)
+  {
+    fprintf(stderr, "Couldn't write %s\n", argv[first]);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(sheets, sizeof(st_animfilesheet), sheetCount, out);
+  fwrite(frames, sizeof(st_animfileframe), frameCount, out);
+  fwrite(animations, sizeof(st_animfileanimation), animationCount, out);
+  fwrite(sets, sizeof(st_animfileset), setCount, out);
+  fwrite(indices, sizeof(u32), indexCount, out);
+  fwrite(strings, 1, stringsSize, out);
+  if (fclose(out))
+  {
+    fprintf(stderr, "Couldn't write %s\n", argv[first]);
+    return 1;
+  }
+
+  printf("%u sheets, %u frames, %u animations, %u sets: %u bytes\n",
+    sheetCount, frameCount, animationCount, setCount,
+    ST_AnimFileSize(&header));
+
+  return 0;
+}
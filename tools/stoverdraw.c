@@ -0,0 +1,261 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+/* Measures fill rate and overdraw in a capture from ST_RenderCaptureStart */
+/* Usage: stoverdraw [-m heatmap] capture.stcf */
+/*   Every recorded quad is rasterized into a counter per screen pixel, */
+/*   sampling pixel centers like the GPU does, and each frame's fill (pixels */
+/*   written), average and worst overdraw are printed. -m also writes a PPM */
+/*   heatmap of each screen of each frame, named heatmap-frame-screen.ppm */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <spritetools/spritetools_capture.h>
+
+#define SCREEN_HEIGHT 240
+
+/* Counters and totals for one screen */
+typedef struct {
+  const char *name;
+  u32 width;
+  u16 *counts;
+  u32 quads;
+  u64 fill;
+  u64 frameFill; /* Totals over every frame */
+  u32 frames;
+  u16 worst;
+} st_overdrawscreen;
+
+/* Region drawing is clipped to */
+typedef struct {
+  int left, top, right, bottom;
+} st_overdrawclip;
+
+static int clampInt(int v, int low, int high)
+{
+  return v < low ? low : (v > high ? high : v);
+}
+
+/* Adds a convex quad to a screen's counters */
+/*   A pixel is covered when its center is inside the quad */
+static void rasterize(st_overdrawscreen *screen, const st_overdrawclip *clip,
+  const float *x, const float *y)
+{
+  float top = y[0], bottom = y[0], center, left, right, t;
+  int row, col, rowStart, rowEnd, colStart, colEnd, hits;
+  u8 i, j;
+
+  for (i = 1; i < 4; i++)
+  {
+    if (y[i] < top)
+      top = y[i];
+    if (y[i] > bottom)
+      bottom = y[i];
+  }
+
+  rowStart = clampInt((int)ceilf(top - 0.5f), clip->top, clip->bottom);
+  rowEnd = clampInt((int)ceilf(bottom - 0.5f), clip->top, clip->bottom);
+  for (row = rowStart; row < rowEnd; row++)
+  {
+    center = row + 0.5f;
+    left = 0;
+    right = 0;
+    hits = 0;
+    for (i = 0; i < 4; i++)
+    {
+      j = (i + 1) & 3;
+      if ((y[i] <= center) == (y[j] <= center))
+        continue;
+      t = x[i] + (center - y[i]) * (x[j] - x[i]) / (y[j] - y[i]);
+      if (!hits || t < left)
+        left = t;
+      if (!hits || t > right)
+        right = t;
+      hits++;
+    }
+    if (hits < 2)
+      continue;
+
+    colStart = clampInt((int)ceilf(left - 0.5f), clip->left, clip->right);
+    colEnd = clampInt((int)ceilf(right - 0.5f), clip->left, clip->right);
+    for (col = colStart; col < colEnd; col++)
+      screen->counts[row * screen->width + col]++;
+    screen->fill += colEnd - colStart;
+  }
+  screen->quads++;
+}
+
+/* Writes a screen's counters as a heatmap */
+/*   Black is untouched, then blue, green, yellow and red as pixels are */
+/*   drawn more times, with white for 8 or more */
+static int writeHeatmap(const char *prefix, u32 frame,
+  const st_overdrawscreen *screen)
+{
+  static const u8 colors[9][3] = {
+    {0, 0, 0}, {0, 0, 160}, {0, 96, 255}, {0, 200, 96}, {128, 224, 0},
+    {255, 224, 0}, {255, 128, 0}, {224, 0, 0}, {255, 255, 255}
+  };
+  char path[1024];
+  u32 i, count = screen->width * SCREEN_HEIGHT;
+  u16 n;
+  FILE *out;
+
+  snprintf(path, sizeof(path), "%s-%u-%s.ppm", prefix, frame, screen->name);
+  out = fopen(path, "wb");
+  if (!out)
+    return 0;
+
+  fprintf(out, "P6\n%u %u\n255\n", screen->width, SCREEN_HEIGHT);
+  for (i = 0; i < count; i++)
+  {
+    n = screen->counts[i] > 8 ? 8 : screen->counts[i];
+    fwrite(colors[n], 1, 3, out);
+  }
+  return !fclose(out);
+}
+
+/* Prints and resets a screen's counters at the end of a frame */
+static void finishScreen(st_overdrawscreen *screen, u32 frame,
+  const char *heatmap)
+{
+  u32 i, count = screen->width * SCREEN_HEIGHT, covered = 0;
+  u16 worst = 0;
+
+  if (!screen->quads)
+    return;
+
+  for (i = 0; i < count; i++)
+  {
+    if (screen->counts[i])
+      covered++;
+    if (screen->counts[i] > worst)
+      worst = screen->counts[i];
+  }
+
+  printf("%6u %-6s %6u %9llu %8.2f %8.2f %6u\n", frame, screen->name,
+    screen->quads, (unsigned long long)screen->fill,
+    (double)screen->fill / count,
+    covered ? (double)screen->fill / covered : 0.0, worst);
+
+  if (heatmap && !writeHeatmap(heatmap, frame, screen))
+    fprintf(stderr, "Couldn't write heatmap of frame %u\n", frame);
+
+  screen->frameFill += screen->fill;
+  screen->frames++;
+  if (worst > screen->worst)
+    screen->worst = worst;
+  screen->quads = 0;
+  screen->fill = 0;
+  memset(screen->counts, 0, count * sizeof(u16));
+}
+
+int main(int argc, char **argv)
+{
+  st_overdrawscreen screens[2] = {
+    {"top", 400, NULL, 0, 0, 0, 0, 0},
+    {"bottom", 320, NULL, 0, 0, 0, 0, 0}
+  };
+  st_captureheader header;
+  st_capturerecord record;
+  st_overdrawclip clip;
+  st_overdrawscreen *screen = &screens[0];
+  const char *heatmap = NULL, *path;
+  u32 frame = 0, i;
+  int arg;
+  FILE *in;
+
+  for (arg = 1; arg < argc - 1; arg++)
+  {
+    if (strcmp(argv[arg], "-m") || arg + 2 >= argc)
+      break;
+    heatmap = argv[++arg];
+  }
+  if (arg != argc - 1 || argv[arg][0] == '-')
+  {
+    fprintf(stderr, "Usage: %s [-m heatmap] capture.stcf\n", argv[0]);
+    return 1;
+  }
+
+  path = argv[arg];
+  in = fopen(path, "rb");
+  if (!in)
+  {
+    fprintf(stderr, "Couldn't read %s\n", path);
+    return 1;
+  }
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+    header.magic != ST_CAPTURE_MAGIC || header.version != ST_CAPTURE_VERSION)
+  {
+    fprintf(stderr, "%s isn't a render capture\n", path);
+    return 1;
+  }
+
+  for (i = 0; i < 2; i++)
+  {
+    screens[i].counts = calloc(screens[i].width * SCREEN_HEIGHT, sizeof(u16));
+    if (!screens[i].counts)
+      return 1;
+  }
+
+  clip.left = clip.top = 0;
+  clip.right = screen->width;
+  clip.bottom = SCREEN_HEIGHT;
+
+  printf("%6s %-6s %6s %9s %8s %8s %6s\n", "frame", "screen", "quads",
+    "fill", "average", "covered", "worst");
+  while (fread(&record, sizeof(record), 1, in) == 1)
+  {
+    switch (record.type)
+    {
+      case ST_CAPTURE_END_FRAME:
+        for (i = 0; i < 2; i++)
+          finishScreen(&screens[i], frame, heatmap);
+        frame++;
+        break;
+      case ST_CAPTURE_SCREEN:
+        screen = &screens[record.value == ST_CAPTURE_BOTTOM];
+        clip.left = clip.top = 0;
+        clip.right = screen->width;
+        clip.bottom = SCREEN_HEIGHT;
+        break;
+      case ST_CAPTURE_SCISSOR:
+        clip.left = 0;
+        clip.top = 0;
+        clip.right = screen->width;
+        clip.bottom = SCREEN_HEIGHT;
+        if (record.value)
+        {
+          clip.left = clampInt(record.x[0], 0, screen->width);
+          clip.top = clampInt(record.y[0], 0, SCREEN_HEIGHT);
+          clip.right = clampInt(record.x[2], clip.left, screen->width);
+          clip.bottom = clampInt(record.y[2], clip.top, SCREEN_HEIGHT);
+        }
+        break;
+      case ST_CAPTURE_QUAD:
+        rasterize(screen, &clip, record.x, record.y);
+        break;
+    }
+  }
+  fclose(in);
+
+  /* A capture that was stopped mid frame still counts what it got */
+  for (i = 0; i < 2; i++)
+    finishScreen(&screens[i], frame, heatmap);
+
+  for (i = 0; i < 2; i++)
+  {
+    if (screens[i].frames)
+      printf("%s: %u frames, %.0f pixels filled per frame, "
+        "%.2f average overdraw, %u worst\n", screens[i].name,
+        screens[i].frames, (double)screens[i].frameFill / screens[i].frames,
+        (double)screens[i].frameFill / screens[i].frames /
+        (screens[i].width * SCREEN_HEIGHT), screens[i].worst);
+    free(screens[i].counts);
+  }
+  return 0;
+}
@@ -0,0 +1,208 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+/* Packs files into an archive ST_ArchiveOpen can read */
+/* Usage: stpack output.stpk [name=]file ... */
+/*   Entries are named after their path unless a name is given, and their */
+/*   payloads are stored in the order given so a level's assets can be */
+/*   read front to back. The type comes from the file's extension */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <spritetools/spritetools_archive.h>
+
+/* File being packed */
+typedef struct {
+  const char *name;
+  const char *path;
+  u8 *data;
+  u32 size;
+  u16 type;
+} st_packfile;
+
+/* Returns the archive type of a file from its extension */
+static u16 fileType(const char *path)
+{
+  const char *dot = strrchr(path, '.');
+
+  if (!dot)
+    return ST_ARCHIVE_RAW;
+  if (!strcmp(dot, ".sttex"))
+    return ST_ARCHIVE_TEXTURE;
+  if (!strcmp(dot, ".stanim"))
+    return ST_ARCHIVE_ANIMATION;
+  if (!strcmp(dot, ".png") || !strcmp(dot, ".PNG"))
+    return ST_ARCHIVE_PNG;
+  if (!strcmp(dot, ".bmp") || !strcmp(dot, ".BMP"))
+    return ST_ARCHIVE_BMP;
+  if (!strcmp(dot, ".jpg") || !strcmp(dot, ".jpeg") ||
+    !strcmp(dot, ".JPG") || !strcmp(dot, ".JPEG"))
+    return ST_ARCHIVE_JPEG;
+  return ST_ARCHIVE_RAW;
+}
+
+/* Reads a whole file */
+static int readFile(st_packfile *file)
+{
+  FILE *in = fopen(file->path, "rb");
+  long size;
+
+  if (!in)
+    return 0;
+  fseek(in, 0, SEEK_END);
+  size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  if (size < 0)
+  {
+    fclose(in);
+    return 0;
+  }
+
+  file->size = size;
+  file->data = malloc(size ? size : 1);
+  if (!file->data || fread(file->data, 1, size, in) != (size_t)size)
+  {
+    fclose(in);
+    return 0;
+  }
+  fclose(in);
+
+  return 1;
+}
+
+/* Returns n rounded up to the archive's alignment */
+static u32 align(u32 n)
+{
+  return (n + ST_ARCHIVE_ALIGN - 1) & ~(ST_ARCHIVE_ALIGN - 1);
+}
+
+int main(int argc, char **argv)
+{
+  static const u8 padding[ST_ARCHIVE_ALIGN];
+  st_archiveheader header;
+  st_archiveentry *table;
+  st_packfile *files;
+  char *names, *eq;
+  u32 count, tableSize, namesSize, offset, slot, i;
+  FILE *out;
+
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s output.stpk [name=]file ...\n", argv[0]);
+    return 1;
+  }
+
+  count = argc - 2;
+  files = calloc(count, sizeof(st_packfile));
+  if (!files)
+    return 1;
+
+  namesSize = 0;
+  for (i = 0; i < count; i++)
+  {
+    eq = strchr(argv[i + 2], '=');
+    files[i].name = argv[i + 2];
+    files[i].path = argv[i + 2];
+    if (eq)
+    {
+      *eq = 0;
+      files[i].path = eq + 1;
+    }
+    files[i].type = fileType(files[i].path);
+    if (!readFile(&files[i]))
+    {
+      fprintf(stderr, "Couldn't read %s\n", files[i].path);
+      return 1;
+    }
+    namesSize += strlen(files[i].name) + 1;
+  }
+
+  /* Keep the table at most half full so lookups stay short */
+  tableSize = 8;
+  while (tableSize < count * 2)
+    tableSize <<= 1;
+
+  table = malloc(tableSize * sizeof(st_archiveentry));
+  names = malloc(namesSize);
+  if (!table || !names)
+    return 1;
+  memset(table, 0, tableSize * sizeof(st_archiveentry));
+  for (i = 0; i < tableSize; i++)
+    table[i].name = ST_ARCHIVE_EMPTY;
+
+  memset(&header, 0, sizeof(header));
+  header.magic = ST_ARCHIVE_MAGIC;
+  header.version = ST_ARCHIVE_VERSION;
+  header.entryCount = count;
+  header.tableSize = tableSize;
+  header.namesSize = namesSize;
+  header.indexSize = sizeof(header) + tableSize * sizeof(st_archiveentry) +
+    namesSize;
+
+  offset = align(header.indexSize);
+  namesSize = 0;
+  for (i = 0; i < count; i++)
+  {
+    u32 hash = ST_ArchiveHash(files[i].name);
+
+    slot = hash & (tableSize - 1);
+    while (table[slot].name != ST_ARCHIVE_EMPTY)
+    {
+      if (table[slot].hash == hash &&
+        !strcmp(names + table[slot].name, files[i].name))
+      {
+        fprintf(stderr, "%s is in the archive twice\n", files[i].name);
+        return 1;
+      }
+      slot = (slot + 1) & (tableSize - 1);
+    }
+
+    table[slot].hash = hash;
+    table[slot].name = namesSize;
+    table[slot].offset = offset;
+    table[slot].size = files[i].size;
+    table[slot].type = files[i].type;
+    strcpy(names + namesSize, files[i].name);
+    namesSize += strlen(files[i].name) + 1;
+    offset = align(offset + files[i].size);
+  }
+  header.dataSize = offset - header.indexSize;
+
+  /* Everything is written as is, so this tool must run little endian */
+  out = fopen(argv[1], "wb");
+  if (!out)
+  {
+    fprintf(stderr, "Couldn't write %s\n", argv[1]);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(table, sizeof(st_archiveentry), tableSize, out);
+  fwrite(names, 1, header.namesSize, out);
+  offset = header.indexSize;
+  for (i = 0; i < count; i++)
+  {
+    fwrite(padding, 1, align(offset) - offset, out);
+    offset = align(offset);
+    fwrite(files[i].data, 1, files[i].size, out);
+    offset += files[i].size;
+  }
+  fwrite(padding, 1, align(offset) - offset, out);
+  if (fclose(out))
+  {
+    fprintf(stderr, "Couldn't write %s\n", argv[1]);
+    return 1;
+  }
+
+  printf("%s: %u entries, %u bytes\n", argv[1], count, align(offset));
+
+  for (i = 0; i < count; i++)
+    free(files[i].data);
+  free(files);
+  free(table);
+  free(names);
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+/* Checks the pixel kernels in source/spritetools_pixel.c against plain */
+/*   versions and times them. Built twice by the Makefile: stpixelbench */
+/*   with whatever SIMD the host has, stpixelbench-scalar without any */
+/* Usage: stpixelbench [size] [iterations] */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <spritetools/spritetools_pixel.h>
+
+/* Returns a time in seconds */
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Texel offset in the GPU's tiled layout, written the slow, obvious way */
+static u32 tiledOffset(u32 x, u32 y, u32 width)
+{
+  u32 morton = 0, bit;
+
+  for (bit = 0; bit < 3; bit++)
+    morton |= (((x >> bit) & 1) << (bit * 2)) |
+      (((y >> bit) & 1) << (bit * 2 + 1));
+  return (y & ~7) * width + (x & ~7) * 8 + morton;
+}
+
+/* Plain versions of the kernels to check against */
+static void refSwap(const u8 *src, u8 *dst, u32 count)
+{
+  u32 i;
+  for (i = 0; i < count * 4; i += 4)
+  {
+    dst[i] = src[i + 3];
+    dst[i + 1] = src[i + 2];
+    dst[i + 2] = src[i + 1];
+    dst[i + 3] = src[i];
+  }
+}
+
+static void refPremultiply(u8 *rgba, u32 count)
+{
+  u32 i, c;
+  for (i = 0; i < count; i++)
+    for (c = 0; c < 3; c++)
+      rgba[i * 4 + c] = (rgba[i * 4 + c] * rgba[i * 4 + 3] + 127) / 255;
+}
+
+static void refPack16(const u8 *rgba, u16 *dst, u32 count, u16 format)
+{
+  const u8 *p;
+  u32 i;
+  for (i = 0; i < count; i++)
+  {
+    p = rgba + i * 4;
+    if (format == ST_TEXFMT_RGB565)
+      dst[i] = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+    else if (format == ST_TEXFMT_RGB5A1)
+      dst[i] = ((p[0] >> 3) << 11) | ((p[1] >> 3) << 6) |
+        ((p[2] >> 3) << 1) | (p[3] >> 7);
+    else
+      dst[i] = ((p[0] >> 4) << 12) | ((p[1] >> 4) << 8) |
+        ((p[2] >> 4) << 4) | (p[3] >> 4);
+  }
+}
+
+static void refTile16(const u16 *src, u32 size, u16 *dst)
+{
+  u32 x, y;
+  for (y = 0; y < size; y++)
+    for (x = 0; x < size; x++)
+      dst[tiledOffset(x, size - 1 - y, size)] = src[y * size + x];
+}
+
+static void refTile32(const u32 *src, u32 width, u32 height, u32 *dst,
+  u32 texWidth, u32 texHeight, u8 swap)
+{
+  u32 x, y, v;
+  for (y = 0; y < height; y++)
+  {
+    for (x = 0; x < width; x++)
+    {
+      v = src[y * width + x];
+      if (swap)
+        refSwap((const u8 *)&src[y * width + x], (u8 *)&v, 1);
+      dst[tiledOffset(x, texHeight - 1 - y, texWidth)] = v;
+    }
+  }
+}
+
+/* Reports a kernel's time and whether it matched the plain version */
+static int report(const char *name, double seconds, u32 iterations,
+  u32 count, int ok)
+{
+  printf("  %-14s %8.3f ms %9.1f Mtexels/s  %s\n", name,
+    seconds * 1000.0 / iterations, count * (double)iterations / seconds / 1e6,
+    ok ? "ok" : "MISMATCH");
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  u32 size = argc > 1 ? atoi(argv[1]) : 1024;
+  u32 iterations = argc > 2 ? atoi(argv[2]) : 20;
+  static const u16 formats[3] = {
+    ST_TEXFMT_RGB565, ST_TEXFMT_RGB5A1, ST_TEXFMT_RGBA4
+  };
+  static const char *formatNames[3] = {
+    "pack rgb565", "pack rgb5a1", "pack rgba4"
+  };
+  u32 count, texSize, i, f, width, height;
+  u8 *rgba, *work, *expect;
+  u16 *packed, *packedExpect;
+  u32 *tiled, *tiledExpect;
+  double start;
+  int ok = 1;
+
+  if (size < 8 || (size & (size - 1)) || !iterations)
+  {
+    fprintf(stderr, "Usage: %s [size (power of 2)] [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  count = size * size;
+  rgba = malloc(count * 4);
+  work = malloc(count * 4);
+  expect = malloc(count * 4);
+  packed = malloc(count * 2);
+  packedExpect = malloc(count * 2);
+  tiled = malloc(count * 4);
+  tiledExpect = malloc(count * 4);
+  if (!rgba || !work || !expect || !packed || !packedExpect || !tiled ||
+    !tiledExpect)
+    return 1;
+
+  srand(1);
+  for (i = 0; i < count * 4; i++)
+    rgba[i] = rand();
+
+  printf("%s kernels, %ux%u texels, %u iterations\n", ST_PixelPath(), size,
+    size, iterations);
+
+  refSwap(rgba, expect, count);
+  start = now();
+  for (i = 0; i < iterations; i++)
+    ST_PixelSwapRGBA8((const u32 *)rgba, (u32 *)work, count);
+  ok &= report("swap", now() - start, iterations, count,
+    !memcmp(work, expect, count * 4));
+
+  memcpy(expect, rgba, count * 4);
+  refPremultiply(expect, count);
+  start = now();
+  for (i = 0; i < iterations; i++)
+  {
+    memcpy(work, rgba, count * 4);
+    ST_PixelPremultiply(work, count);
+  }
+  ok &= report("premultiply", now() - start, iterations, count,
+    !memcmp(work, expect, count * 4));
+
+  for (f = 0; f < 3; f++)
+  {
+    refPack16(rgba, packedExpect, count, formats[f]);
+    start = now();
+    for (i = 0; i < iterations; i++)
+      ST_PixelPack16(rgba, packed, count, formats[f]);
+    ok &= report(formatNames[f], now() - start, iterations, count,
+      !memcmp(packed, packedExpect, count * 2));
+  }
+
+  refTile16(packed, size, (u16 *)tiledExpect);
+  start = now();
+  for (i = 0; i < iterations; i++)
+    ST_PixelTile16(packed, size, size, size, (u16 *)tiled, size, size);
+  ok &= report("tile 16 bit", now() - start, iterations, count,
+    !memcmp(tiled, tiledExpect, count * 2));
+
+  memset(tiledExpect, 0, count * 4);
+  refTile32((const u32 *)rgba, size, size, tiledExpect, size, size, 1);
+  start = now();
+  for (i = 0; i < iterations; i++)
+    ST_PixelTile32((const u32 *)rgba, size, size, size, tiled, size, size, 1);
+  ok &= report("tile rgba8", now() - start, iterations, count,
+    !memcmp(tiled, tiledExpect, count * 4));
+
+  /* An image that doesn't fill its texture takes the edge path too */
+  width = size - 5;
+  height = size / 2 + 3;
+  texSize = size;
+  memset(tiled, 0, count * 4);
+  memset(tiledExpect, 0, count * 4);
+  refTile32((const u32 *)rgba, width, height, tiledExpect, texSize, texSize,
+    0);
+  start = now();
+  ST_PixelTile32((const u32 *)rgba, width, width, height, tiled, texSize,
+    texSize, 0);
+  ok &= report("tile partial", now() - start, 1, width * height,
+    !memcmp(tiled, tiledExpect, count * 4));
+
+  free(rgba);
+  free(work);
+  free(expect);
+  free(packed);
+  free(packedExpect);
+  free(tiled);
+  free(tiledExpect);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,756 @@
+/*
+* Author: BtheDestroyer
+* SpriteTools is an open source 3DS Homebrew Library which can be found here:
+* https://github.com/BtheDestroyer/SpriteTools
+*/
+
+/* Converts images into textures ST_SpritesheetCreateSpritesheetTexture can */
+/*   load. Picks the smallest texel format that stays within an error limit */
+/* Usage: sttexconv [-e maxerror] [-f format] [-l] input.pam output.sttex */
+/*   Input is a binary PAM (P7, RGB_ALPHA or RGB) or PPM (P6) image */
+/*   Texels are written in the GPU's tiled order so they can be copied */
+/*   straight into a texture. -l leaves 16 and 32 bit formats linear */
+/*   ImageMagick can make these: convert sprite.png sprite.pam */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <spritetools/spritetools_texture.h>
+
+/* Default root mean square error allowed per channel (0 - 255) */
+#define DEFAULT_MAX_ERROR 4.0
+
+/* Image being converted, padded to powers of 2 */
+typedef struct {
+  u32 width, height; /* Size of the source image */
+  u32 pow2Width, pow2Height;
+  u8 *rgba; /* pow2Width * pow2Height * 4 bytes, top row first */
+  u8 opaque; /* 1 if every alpha is 255 */
+} st_convimage;
+
+/* A converted texture and how far it is from the source */
+typedef struct {
+  u16 format;
+  u32 flags;
+  u32 size;
+  u8 *data;
+  double error;
+} st_convresult;
+
+/* ETC1 modifier tables */
+static const int etcTables[8][2] = {
+  {2, 8}, {5, 17}, {9, 29}, {13, 42},
+  {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+static u8 clamp8(int v)
+{
+  return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static u32 pow2(u32 v)
+{
+  u32 p = 8;
+  while (p < v)
+    p <<= 1;
+  return p;
+}
+
+/* Returns a pointer to a pixel of an image */
+static u8 *pixel(st_convimage *image, u32 x, u32 y)
+{
+  return image->rgba + (y * image->pow2Width + x) * 4;
+}
+
+/**************************\
+|*     Reading Images     *|
+\**************************/
+/* Reads the next header token of a PNM file, skipping comments */
+static int readToken(FILE *file, char *token, int size)
+{
+  int c, len = 0;
+
+  do
+  {
+    c = fgetc(file);
+    if (c == '#')
+      while (c != '\n' && c != EOF)
+        c = fgetc(file);
+  } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+
+  while (c != EOF && c != ' ' && c != '\t' && c != '\n' && c != '\r')
+  {
+    if (len < size - 1)
+      token[len++] = c;
+    c = fgetc(file);
+  }
+  token[len] = 0;
+
+  return len > 0;
+}
+
+/* Loads a PAM or PPM image */
+static int readImage(const char *path, st_convimage *image)
+{
+  FILE *file = fopen(path, "rb");
+  char token[64];
+  u32 depth = 3, maxval = 255, x, y, c;
+  u8 *row;
+  int pam;
+
+  if (!file)
+    return 0;
+
+  readToken(file, token, sizeof(token));
+  pam = !strcmp(token, "P7");
+  if (!pam && strcmp(token, "P6"))
+  {
+    fclose(file);
+    return 0;
+  }
+
+  image->width = image->height = 0;
+  if (pam)
+  {
+    while (readToken(file, token, sizeof(token)) && strcmp(token, "ENDHDR"))
+    {
+      if (!strcmp(token, "WIDTH") && readToken(file, token, sizeof(token)))
+        image->width = atoi(token);
+      else if (!strcmp(token, "HEIGHT") &&
+        readToken(file, token, sizeof(token)))
+        image->height = atoi(token);
+      else if (!strcmp(token, "DEPTH") && readToken(file, token, sizeof(token)))
+        depth = atoi(token);
+      else if (!strcmp(token, "MAXVAL") &&
+        readToken(file, token, sizeof(token)))
+        maxval = atoi(token);
+      else if (!strcmp(token, "TUPLTYPE"))
+        readToken(file, token, sizeof(token));
+    }
+  }
+  else
+  {
+    readToken(file, token, sizeof(token));
+    image->width = atoi(token);
+    readToken(file, token, sizeof(token));
+    image->height = atoi(token);
+    readToken(file, token, sizeof(token));
+    maxval = atoi(token);
+  }
+
+  if (!image->width || !image->height || maxval != 255 ||
+    (depth != 3 && depth != 4) || image->width > 1024 ||
+    image->height > 1024)
+  {
+    fclose(file);
+    return 0;
+  }
+
+  image->pow2Width = pow2(image->width);
+  image->pow2Height = pow2(image->height);
+  image->rgba = calloc(image->pow2Width * image->pow2Height, 4);
+  row = malloc(image->width * depth);
+  if (!image->rgba || !row)
+  {
+    fclose(file);
+    free(row);
+    return 0;
+  }
+
+  image->opaque = 1;
+  for (y = 0; y < image->height; y++)
+  {
+    if (fread(row, depth, image->width, file) != image->width)
+    {
+      fclose(file);
+      free(row);
+      return 0;
+    }
+    for (x = 0; x < image->width; x++)
+    {
+      for (c = 0; c < 3; c++)
+        pixel(image, x, y)[c] = row[x * depth + c];
+      pixel(image, x, y)[3] = depth == 4 ? row[x * depth + 3] : 255;
+      if (pixel(image, x, y)[3] != 255)
+        image->opaque = 0;
+    }
+  }
+  fclose(file);
+  free(row);
+
+  /* Repeat the edges into the padding so block formats don't bleed */
+  for (y = 0; y < image->pow2Height; y++)
+  {
+    for (x = 0; x < image->pow2Width; x++)
+    {
+      if (x < image->width && y < image->height)
+        continue;
+      memcpy(pixel(image, x, y),
+        pixel(image, x < image->width ? x : image->width - 1,
+          y < image->height ? y : image->height - 1), 4);
+    }
+  }
+
+  return 1;
+}
+
+/*****************************\
+|*     Error Measurement     *|
+\*****************************/
+/* Squared error of one pixel. Color matters less the more see-through */
+static double pixelError(const u8 *a, const u8 *b)
+{
+  double weight = a[3] / 255.0;
+  double dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+  double da = a[3] - b[3];
+
+  return (dr * dr + dg * dg + db * db) * weight + da * da;
+}
+
+/* Root mean square error per channel over the visible image */
+static double imageError(st_convimage *image, const u8 *decoded)
+{
+  double total = 0.0;
+  u32 x, y;
+
+  for (y = 0; y < image->height; y++)
+    for (x = 0; x < image->width; x++)
+      total += pixelError(pixel(image, x, y),
+        decoded + (y * image->pow2Width + x) * 4);
+
+  return sqrt(total / (image->width * image->height * 4.0));
+}
+
+/*************************\
+|*     16 and 32 Bit     *|
+\*************************/
+/* Packs one pixel into a format and unpacks it again into out */
+static u32 packPixel(u16 format, const u8 *in, u8 *out)
+{
+  u32 r = in[0], g = in[1], b = in[2], a = in[3];
+  u32 v;
+
+  switch (format)
+  {
+    case ST_TEXFMT_RGB565:
+      r >>= 3; g >>= 2; b >>= 3;
+      v = (r << 11) | (g << 5) | b;
+      out[0] = (r << 3) | (r >> 2);
+      out[1] = (g << 2) | (g >> 4);
+      out[2] = (b << 3) | (b >> 2);
+      out[3] = 255;
+      return v;
+    case ST_TEXFMT_RGB5A1:
+      r >>= 3; g >>= 3; b >>= 3; a >>= 7;
+      v = (r << 11) | (g << 6) | (b << 1) | a;
+      out[0] = (r << 3) | (r >> 2);
+      out[1] = (g << 3) | (g >> 2);
+      out[2] = (b << 3) | (b >> 2);
+      out[3] = a ? 255 : 0;
+      return v;
+    case ST_TEXFMT_RGBA4:
+      r >>= 4; g >>= 4; b >>= 4; a >>= 4;
+      v = (r << 12) | (g << 8) | (b << 4) | a;
+      out[0] = r * 17;
+      out[1] = g * 17;
+      out[2] = b * 17;
+      out[3] = a * 17;
+      return v;
+    default:
+      memcpy(out, in, 4);
+      return (r << 24) | (g << 16) | (b << 8) | a;
+  }
+}
+
+/* Converts to a 16 or 32 bit format, rows in image order */
+static int convertLinear(st_convimage *image, u16 format,
+  st_convresult *result)
+{
+  u32 bytes = ST_TextureFormatBits(format) / 8;
+  u32 count = image->pow2Width * image->pow2Height;
+  u8 *decoded = malloc(count * 4);
+  u32 i, v;
+
+  result->format = format;
+  result->flags = 0;
+  result->size = count * bytes;
+  result->data = malloc(result->size);
+  if (!decoded || !result->data)
+  {
+    free(decoded);
+    return 0;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    v = packPixel(format, image->rgba + i * 4, decoded + i * 4);
+    if (bytes == 2)
+    {
+      result->data[i * 2] = v & 0xFF;
+      result->data[i * 2 + 1] = v >> 8;
+    }
+    else
+    {
+      result->data[i * 4] = v & 0xFF;
+      result->data[i * 4 + 1] = (v >> 8) & 0xFF;
+      result->data[i * 4 + 2] = (v >> 16) & 0xFF;
+      result->data[i * 4 + 3] = v >> 24;
+    }
+  }
+
+  result->error = imageError(image, decoded);
+  free(decoded);
+  return 1;
+}
+
+/* Returns offset in texels of a texel in the GPU's tiled layout */
+/*   Must match the tiling in source/spritetools_pixel.c */
+static u32 tiledOffset(u32 x, u32 y, u32 width)
+{
+  u32 morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
+    ((x & 4) << 2) | ((y & 4) << 3);
+  return (y & ~7) * width + (x & ~7) * 8 + morton;
+}
+
+/* Rearranges linear 16 or 32 bit texels into the GPU's tiled layout */
+static int tileResult(st_convimage *image, st_convresult *result)
+{
+  u32 bytes = ST_TextureFormatBits(result->format) / 8;
+  u32 width = image->pow2Width, height = image->pow2Height;
+  u8 *tiled = malloc(result->size);
+  u32 x, y, row;
+
+  if (!tiled)
+    return 0;
+
+  /* Rows are flipped because the GPU's textures are upside down */
+  for (y = 0; y < height; y++)
+  {
+    row = height - 1 - y;
+    for (x = 0; x < width; x++)
+      memcpy(tiled + tiledOffset(x, y, width) * bytes,
+        result->data + (row * width + x) * bytes, bytes);
+  }
+
+  free(result->data);
+  result->data = tiled;
+  result->flags |= ST_TEXTURE_TILED;
+  return 1;
+}
+
+/****************\
+|*     ETC1     *|
+\****************/
+/* Finds the best table and indices for a subblock around a base color */
+/*   Returns the squared error and fills in the table and indices */
+static u32 fitSubblock(const u8 block[16][4], const int *pixels,
+  const int *base, int *bestTable, int indices[16], u8 decoded[16][4])
+{
+  u32 bestError = 0xFFFFFFFF;
+  int t, p, m, c, mod, best;
+  u32 error, err, pixelBest;
+  int tableIndices[8];
+  int mods[4];
+
+  for (t = 0; t < 8; t++)
+  {
+    /* Index bits: 0 = +small, 1 = +large, 2 = -small, 3 = -large */
+    mods[0] = etcTables[t][0];
+    mods[1] = etcTables[t][1];
+    mods[2] = -etcTables[t][0];
+    mods[3] = -etcTables[t][1];
+
+    error = 0;
+    for (p = 0; p < 8; p++)
+    {
+      pixelBest = 0xFFFFFFFF;
+      best = 0;
+      for (m = 0; m < 4; m++)
+      {
+        err = 0;
+        for (c = 0; c < 3; c++)
+        {
+          mod = clamp8(base[c] + mods[m]) - block[pixels[p]][c];
+          err += mod * mod;
+        }
+        if (err < pixelBest)
+        {
+          pixelBest = err;
+          best = m;
+        }
+      }
+      error += pixelBest;
+      tableIndices[p] = best;
+    }
+
+    if (error < bestError)
+    {
+      bestError = error;
+      *bestTable = t;
+      for (p = 0; p < 8; p++)
+      {
+        indices[pixels[p]] = tableIndices[p];
+        mods[0] = etcTables[t][0];
+        mods[1] = etcTables[t][1];
+        mods[2] = -etcTables[t][0];
+        mods[3] = -etcTables[t][1];
+        for (c = 0; c < 3; c++)
+          decoded[pixels[p]][c] = clamp8(base[c] + mods[tableIndices[p]]);
+      }
+    }
+  }
+
+  return bestError;
+}
+
+/* Encodes a 4x4 block of pixels (indexed x * 4 + y) into an ETC1 block */
+/*   Returns the block as a u64 the way the 3DS stores it */
+static u64 encodeEtc1Block(const u8 block[16][4], u8 decoded[16][4])
+{
+  static const int halves[2][2][8] = {
+    { /* Not flipped: left and right 2x4 halves */
+      {0, 1, 2, 3, 4, 5, 6, 7}, {8, 9, 10, 11, 12, 13, 14, 15}
+    },
+    { /* Flipped: top and bottom 4x2 halves */
+      {0, 1, 4, 5, 8, 9, 12, 13}, {2, 3, 6, 7, 10, 11, 14, 15}
+    }
+  };
+  u64 best = 0, bits;
+  u32 bestError = 0xFFFFFFFF, error;
+  int flip, diff, h, c, p;
+  int avg[2][3], q[2][3], base[2][3], table[2];
+  int indices[16];
+  u8 trial[16][4];
+
+  for (flip = 0; flip < 2; flip++)
+  {
+    for (h = 0; h < 2; h++)
+    {
+      for (c = 0; c < 3; c++)
+      {
+        avg[h][c] = 0;
+        for (p = 0; p < 8; p++)
+          avg[h][c] += block[halves[flip][h][p]][c];
+        avg[h][c] = (avg[h][c] + 4) / 8;
+      }
+    }
+
+    for (diff = 0; diff < 2; diff++)
+    {
+      for (h = 0; h < 2; h++)
+      {
+        for (c = 0; c < 3; c++)
+        {
+          if (diff)
+          {
+            q[h][c] = (avg[h][c] * 31 + 127) / 255;
+            base[h][c] = (q[h][c] << 3) | (q[h][c] >> 2);
+          }
+          else
+          {
+            q[h][c] = (avg[h][c] * 15 + 127) / 255;
+            base[h][c] = q[h][c] * 17;
+          }
+        }
+      }
+
+      /* Differential mode only reaches 3 steps up and 4 down */
+      if (diff && (q[1][0] - q[0][0] < -4 || q[1][0] - q[0][0] > 3 ||
+        q[1][1] - q[0][1] < -4 || q[1][1] - q[0][1] > 3 ||
+        q[1][2] - q[0][2] < -4 || q[1][2] - q[0][2] > 3))
+        continue;
+
+      error = fitSubblock(block, halves[flip][0], base[0], &table[0],
+        indices, trial);
+      error += fitSubblock(block, halves[flip][1], base[1], &table[1],
+        indices, trial);
+      if (error >= bestError)
+        continue;
+
+      bestError = error;
+      memcpy(decoded, trial, sizeof(trial));
+      if (diff)
+        bits = ((u64)q[0][0] << 59) | ((u64)((q[1][0] - q[0][0]) & 7) << 56) |
+          ((u64)q[0][1] << 51) | ((u64)((q[1][1] - q[0][1]) & 7) << 48) |
+          ((u64)q[0][2] << 43) | ((u64)((q[1][2] - q[0][2]) & 7) << 40);
+      else
+        bits = ((u64)q[0][0] << 60) | ((u64)q[1][0] << 56) |
+          ((u64)q[0][1] << 52) | ((u64)q[1][1] << 48) |
+          ((u64)q[0][2] << 44) | ((u64)q[1][2] << 40);
+      bits |= ((u64)table[0] << 37) | ((u64)table[1] << 34) |
+        ((u64)diff << 33) | ((u64)flip << 32);
+      for (p = 0; p < 16; p++)
+        bits |= ((u64)(indices[p] >> 1) << (16 + p)) |
+          ((u64)(indices[p] & 1) << p);
+      best = bits;
+    }
+  }
+
+  return best;
+}
+
+/* Writes a u64 little endian */
+static void putU64(u8 *out, u64 v)
+{
+  int i;
+  for (i = 0; i < 8; i++)
+    out[i] = (v >> (i * 8)) & 0xFF;
+}
+
+/* Converts to ETC1 or ETC1A4 in the GPU's tiled block order */
+static int convertEtc1(st_convimage *image, u16 format, st_convresult *result)
+{
+  u32 blockBytes = format == ST_TEXFMT_ETC1A4 ? 16 : 8;
+  u32 count = image->pow2Width * image->pow2Height;
+  u8 *decoded = malloc(count * 4);
+  u8 *out;
+  u8 block[16][4], decBlock[16][4];
+  u32 tx, ty, b, x, y, px, py, row;
+  u64 alpha;
+
+  result->format = format;
+  result->flags = ST_TEXTURE_TILED;
+  result->size = count * blockBytes / 16;
+  result->data = malloc(result->size);
+  if (!decoded || !result->data)
+  {
+    free(decoded);
+    return 0;
+  }
+
+  out = result->data;
+  /* Tiles run bottom to top because the GPU's textures are upside down */
+  for (ty = 0; ty < image->pow2Height; ty += 8)
+  {
+    for (tx = 0; tx < image->pow2Width; tx += 8)
+    {
+      /* Each tile holds four blocks: top left, top right, and so on */
+      for (b = 0; b < 4; b++)
+      {
+        alpha = 0;
+        for (x = 0; x < 4; x++)
+        {
+          for (y = 0; y < 4; y++)
+          {
+            px = tx + (b & 1) * 4 + x;
+            py = ty + (b >> 1) * 4 + y;
+            row = image->pow2Height - 1 - py;
+            memcpy(block[x * 4 + y], pixel(image, px, row), 4);
+            alpha |= (u64)(block[x * 4 + y][3] >> 4) << ((x * 4 + y) * 4);
+          }
+        }
+
+        if (blockBytes == 16)
+        {
+          putU64(out, alpha);
+          out += 8;
+        }
+        putU64(out, encodeEtc1Block((const u8 (*)[4])block, decBlock));
+        out += 8;
+
+        for (x = 0; x < 4; x++)
+        {
+          for (y = 0; y < 4; y++)
+          {
+            px = tx + (b & 1) * 4 + x;
+            row = image->pow2Height - 1 - (ty + (b >> 1) * 4 + y);
+            memcpy(decoded + (row * image->pow2Width + px) * 4,
+              decBlock[x * 4 + y], 3);
+            decoded[(row * image->pow2Width + px) * 4 + 3] =
+              blockBytes == 16 ? (block[x * 4 + y][3] >> 4) * 17 : 255;
+          }
+        }
+      }
+    }
+  }
+
+  result->error = imageError(image, decoded);
+  free(decoded);
+  return 1;
+}
+
+/************************\
+|*     Main Program     *|
+\************************/
+/* Returns a format's value from its name, or -1 */
+static int parseFormat(const char *name)
+{
+  if (!strcmp(name, "rgba8"))
+    return ST_TEXFMT_RGBA8;
+  if (!strcmp(name, "rgb5a1") || !strcmp(name, "rgba5551"))
+    return ST_TEXFMT_RGB5A1;
+  if (!strcmp(name, "rgb565"))
+    return ST_TEXFMT_RGB565;
+  if (!strcmp(name, "rgba4"))
+    return ST_TEXFMT_RGBA4;
+  if (!strcmp(name, "etc1"))
+    return ST_TEXFMT_ETC1;
+  if (!strcmp(name, "etc1a4"))
+    return ST_TEXFMT_ETC1A4;
+  return -1;
+}
+
+/* Returns a format's name */
+static const char *formatName(u16 format)
+{
+  switch (format)
+  {
+    case ST_TEXFMT_RGB5A1:
+      return "rgb5a1";
+    case ST_TEXFMT_RGB565:
+      return "rgb565";
+    case ST_TEXFMT_RGBA4:
+      return "rgba4";
+    case ST_TEXFMT_ETC1:
+      return "etc1";
+    case ST_TEXFMT_ETC1A4:
+      return "etc1a4";
+    default:
+      return "rgba8";
+  }
+}
+
+/* Converts an image to a format */
+static int convert(st_convimage *image, u16 format, st_convresult *result)
+{
+  if (format == ST_TEXFMT_ETC1 || format == ST_TEXFMT_ETC1A4)
+    return convertEtc1(image, format, result);
+  return convertLinear(image, format, result);
+}
+
+/* Writes a converted texture to a file */
+static int writeTexture(const char *path, st_convimage *image,
+  st_convresult *result)
+{
+  st_textureheader header;
+  FILE *file = fopen(path, "wb");
+  int ok;
+
+  if (!file)
+    return 0;
+
+  /* The header is written as is, so this tool must run little endian */
+  memset(&header, 0, sizeof(header));
+  header.magic = ST_TEXTURE_MAGIC;
+  header.version = ST_TEXTURE_VERSION;
+  header.format = result->format;
+  header.width = image->width;
+  header.height = image->height;
+  header.pow2Width = image->pow2Width;
+  header.pow2Height = image->pow2Height;
+  header.flags = result->flags;
+  header.dataSize = result->size;
+
+  ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(result->data, result->size, 1, file) == 1;
+  fclose(file);
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  /* Candidates from smallest to largest */
+  static const u16 opaqueFormats[] = {
+    ST_TEXFMT_ETC1, ST_TEXFMT_RGB565, ST_TEXFMT_RGBA8
+  };
+  static const u16 alphaFormats[] = {
+    ST_TEXFMT_ETC1A4, ST_TEXFMT_RGB5A1, ST_TEXFMT_RGBA4, ST_TEXFMT_RGBA8
+  };
+  st_convimage image;
+  st_convresult best, trial;
+  const u16 *formats;
+  double maxError = DEFAULT_MAX_ERROR;
+  int forced = -1, linear = 0;
+  int i, count;
+  const char *input = NULL, *output = NULL;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-e") && i + 1 < argc)
+      maxError = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-l"))
+      linear = 1;
+    else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+    {
+      forced = parseFormat(argv[++i]);
+      if (forced < 0)
+      {
+        fprintf(stderr, "Unknown format %s\n", argv[i]);
+        return 1;
+      }
+    }
+    else if (!input)
+      input = argv[i];
+    else
+      output = argv[i];
+  }
+
+  if (!input || !output)
+  {
+    fprintf(stderr, "Usage: %s [-e maxerror] [-f format] [-l] "
+      "input.pam output.sttex\n", argv[0]);
+    fprintf(stderr, "  Formats: rgba8 rgb5a1 rgb565 rgba4 etc1 etc1a4\n");
+    return 1;
+  }
+
+  if (!readImage(input, &image))
+  {
+    fprintf(stderr, "Couldn't read %s\n", input);
+    return 1;
+  }
+
+  memset(&best, 0, sizeof(best));
+  if (forced >= 0)
+  {
+    if (!convert(&image, forced, &best))
+      return 1;
+  }
+  else
+  {
+    formats = image.opaque ? opaqueFormats : alphaFormats;
+    count = image.opaque ? 3 : 4;
+    for (i = 0; i < count; i++)
+    {
+      if (!convert(&image, formats[i], &trial))
+        return 1;
+
+      /* Formats of the same size compete on error alone */
+      if (!best.data || trial.error < best.error)
+      {
+        free(best.data);
+        best = trial;
+      }
+      else
+        free(trial.data);
+
+      if (i + 1 < count && ST_TextureFormatBits(formats[i + 1]) ==
+        ST_TextureFormatBits(formats[i]))
+        continue;
+
+      /* Take the smallest size that's close enough, or RGBA8 if none are */
+      if (best.error <= maxError || i + 1 >= count)
+        break;
+      free(best.data);
+      best.data = NULL;
+    }
+  }
+
+  if (!linear && !(best.flags & ST_TEXTURE_TILED) &&
+    !tileResult(&image, &best))
+    return 1;
+
+  if (!writeTexture(output, &image, &best))
+  {
+    fprintf(stderr, "Couldn't write %s\n", output);
+    return 1;
+  }
+
+  printf("%s: %ux%u %s%s, %u bytes, error %.2f\n", output, image.width,
+    image.height, formatName(best.format),
+    best.flags & ST_TEXTURE_TILED ? " tiled" : "", best.size, best.error);
+
+  free(best.data);
+  free(image.rgba);
+  return 0;
+}